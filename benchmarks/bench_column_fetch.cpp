@@ -0,0 +1,75 @@
+// Rows-per-second comparison of result::get_tuple against result::fetch_columns.
+//
+// Usage: vsqlitepp_bench_column_fetch [rows] [batch]
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+using bench_clock = std::chrono::steady_clock;
+
+void seed(sqlite::connection &conn, long rows) {
+    sqlite::execute(conn, "CREATE TABLE bench(id INTEGER, label TEXT, value REAL);", true);
+    sqlite::transaction tx(conn);
+    sqlite::execute insert(conn, "INSERT INTO bench VALUES(?, ?, ?);");
+    for (long i = 0; i < rows; ++i) {
+        insert % static_cast<std::int64_t>(i) % ("label-" + std::to_string(i)) % (i * 0.25);
+        insert();
+        insert.clear();
+    }
+    tx.commit();
+}
+
+template <typename Fn> void report(char const *name, long rows, Fn &&fn) {
+    auto start     = bench_clock::now();
+    double checksum = fn();
+    std::chrono::duration<double> elapsed = bench_clock::now() - start;
+    std::printf("%-16s %10.0f rows/s  (%.3f s, checksum %.1f)\n", name, rows / elapsed.count(),
+                elapsed.count(), checksum);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    long rows  = argc > 1 ? std::atol(argv[1]) : 1000000;
+    long batch = argc > 2 ? std::atol(argv[2]) : 4096;
+
+    sqlite::connection conn(":memory:");
+    seed(conn, rows);
+
+    report("get_tuple", rows, [&] {
+        sqlite::query q(conn, "SELECT id, label, value FROM bench;");
+        auto res   = q.get_result();
+        double sum = 0;
+        while (res->next_row()) {
+            auto [id, label, value] = res->get_tuple<std::int64_t, std::string, double>();
+            sum += static_cast<double>(id) + value + static_cast<double>(label.size());
+        }
+        return sum;
+    });
+
+    report("fetch_columns", rows, [&] {
+        sqlite::query q(conn, "SELECT id, label, value FROM bench;");
+        auto res   = q.get_result();
+        double sum = 0;
+        sqlite::column_batch<std::int64_t, std::string, double> cols;
+        cols.reserve(static_cast<std::size_t>(batch));
+        while (res->fetch_columns(cols, static_cast<std::size_t>(batch)) > 0) {
+            auto const &ids    = cols.column<0>();
+            auto const &labels = cols.column<1>();
+            auto const &values = cols.column<2>();
+            for (std::size_t i = 0; i < cols.size(); ++i) {
+                sum += static_cast<double>(ids[i]) + values[i] +
+                       static_cast<double>(labels.offsets[i + 1] - labels.offsets[i]);
+            }
+        }
+        return sum;
+    });
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_ARROW_HPP_INCLUDED
+#define GUARD_SQLITE_ARROW_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file sqlite/arrow.hpp
+ * @brief Export query results through the Arrow C Data Interface without linking Arrow.
+ *
+ * `sqlite::arrow_exporter` fills `ArrowSchema` / `ArrowArray` structs straight from
+ * `sqlite3_column_*`. Each exported batch owns its buffers and frees them from its `release`
+ * callback, so consumers such as `pyarrow` or `arrow::ImportRecordBatch` import it without copies.
+ */
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+struct ArrowSchema {
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+}
+
+#endif // ARROW_C_DATA_INTERFACE
+
+struct sqlite3_stmt;
+
+namespace sqlite {
+inline namespace v2 {
+    struct query;
+
+    /// Arrow types produced by the exporter (formats `l`, `g`, `U` and `Z`).
+    enum class arrow_type { int64, float64, large_utf8, large_binary };
+
+    struct arrow_export_options {
+        std::size_t batch_size = 65536; ///< Maximum rows per exported ArrowArray.
+    };
+
+    /**
+     * @brief Streams the rows of a query as Arrow struct arrays.
+     *
+     * Column types come from the declared column type using SQLite's affinity rules (`INT`,
+     * `CHAR`/`CLOB`/`TEXT`, `BLOB`, `REAL`/`FLOA`/`DOUB`). Expression columns and NUMERIC
+     * affinity columns are inferred from the first non-NULL value of the first batch; columns
+     * that are entirely NULL there fall back to `large_utf8`. Later values are coerced with
+     * SQLite's usual conversions. The query must outlive the exporter.
+     */
+    class arrow_exporter {
+    public:
+        explicit arrow_exporter(query &q, arrow_export_options options = {});
+        ~arrow_exporter();
+
+        arrow_exporter(arrow_exporter const &)            = delete;
+        arrow_exporter &operator=(arrow_exporter const &) = delete;
+
+        /// Fills @p out with a struct schema describing one child per column.
+        void export_schema(ArrowSchema *out);
+
+        /**
+         * @brief Exports the next batch into @p out.
+         * @returns false (leaving @p out untouched) once all rows were exported.
+         */
+        bool export_next(ArrowArray *out);
+
+        /// Column types; fetches the first batch when inference is still pending.
+        std::vector<arrow_type> const &types();
+
+        std::vector<std::string> const &names() const noexcept;
+
+    private:
+        class column_builder;
+
+        bool fill_batch();
+
+        arrow_export_options options_;
+        sqlite3_stmt *stmt_;
+        std::vector<std::string> names_;
+        std::vector<arrow_type> types_;
+        std::vector<column_builder> builders_;
+        std::size_t batch_rows_ = 0;
+        bool pending_           = false;
+        bool done_              = false;
+        bool inferred_          = false;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_ARROW_HPP_INCLUDED
@@ -0,0 +1,169 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_BLOB_STREAM_HPP_INCLUDED
+#define GUARD_SQLITE_BLOB_STREAM_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct sqlite3_blob;
+
+/**
+ * @file sqlite/blob_stream.hpp
+ * @brief Incremental BLOB I/O on top of `sqlite3_blob_open` and friends.
+ *
+ * `sqlite::blob_stream` reads and writes a single BLOB cell in caller-sized chunks instead of
+ * materializing it, and `sqlite::blob_streambuf` adapts it to iostreams. Reserve space for a
+ * streamed write by inserting a `sqlite::zeroblob` first.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Selects whether a blob handle may write.
+    enum class blob_mode { read_only, read_write };
+
+    /**
+     * @brief RAII handle for one BLOB cell addressed by table, column and rowid.
+     *
+     * The handle expires when its row is modified or deleted; operations then throw. Writes can
+     * never change the size of the blob.
+     */
+    class blob_stream {
+    public:
+        blob_stream(connection &con, std::string_view table, std::string_view column,
+                    std::int64_t rowid, blob_mode mode = blob_mode::read_only,
+                    std::string_view schema = "main");
+        ~blob_stream();
+
+        blob_stream(blob_stream &&other) noexcept;
+        blob_stream &operator=(blob_stream &&other) noexcept;
+
+        blob_stream(blob_stream const &)            = delete;
+        blob_stream &operator=(blob_stream const &) = delete;
+
+        /// Size of the blob in bytes.
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+        std::int64_t rowid() const noexcept {
+            return rowid_;
+        }
+
+        bool writable() const noexcept {
+            return mode_ == blob_mode::read_write;
+        }
+
+        /**
+         * @brief Reads up to `buffer.size()` bytes starting at @p offset.
+         * @returns Number of bytes copied; less than requested only at the end of the blob.
+         */
+        std::size_t read(std::span<unsigned char> buffer, std::size_t offset);
+
+        /// Writes @p data at @p offset; throws when the range exceeds @ref size().
+        void write(std::span<const unsigned char> data, std::size_t offset);
+
+        /**
+         * @brief Points the handle at another row of the same column.
+         *
+         * Much cheaper than opening a new handle when iterating over many rows.
+         */
+        void reopen(std::int64_t rowid);
+
+        /**
+         * @brief Streams the whole blob through @p buffer, calling @p sink for every chunk.
+         *
+         * @p sink receives a `std::span<const unsigned char>` that is only valid for the call.
+         */
+        template <typename Sink> void read_chunks(std::span<unsigned char> buffer, Sink &&sink) {
+            for (std::size_t offset = 0; offset < size_;) {
+                std::size_t got = read(buffer, offset);
+                sink(std::span<const unsigned char>(buffer.data(), got));
+                offset += got;
+            }
+        }
+
+        void close() noexcept;
+
+        sqlite3_blob *native_handle() const noexcept {
+            return handle_;
+        }
+
+    private:
+        void throw_error(int rc, char const *what) const;
+
+        connection *con_;
+        sqlite3_blob *handle_;
+        blob_mode mode_;
+        std::int64_t rowid_;
+        std::size_t size_;
+    };
+
+    /**
+     * @brief `std::streambuf` over a @ref blob_stream with an internal chunk buffer.
+     *
+     * Supports reading, writing (within the existing blob size) and seeking. Pending writes are
+     * flushed by `pubsync()`, seeking and destruction.
+     */
+    class blob_streambuf : public std::streambuf {
+    public:
+        explicit blob_streambuf(blob_stream &blob, std::size_t buffer_size = 64 * 1024);
+        ~blob_streambuf() override;
+
+    protected:
+        int_type underflow() override;
+        int_type overflow(int_type ch) override;
+        int sync() override;
+        std::streamsize xsgetn(char_type *s, std::streamsize count) override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                         std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+    private:
+        bool flush_writes();
+        std::size_t position() const;
+
+        blob_stream &blob_;
+        std::vector<char> buffer_;
+        std::size_t buffer_offset_ = 0; ///< Blob offset of buffer_[0]
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_BLOB_STREAM_HPP_INCLUDED
@@ -0,0 +1,116 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_BULK_EXPORT_HPP_INCLUDED
+#define GUARD_SQLITE_BULK_EXPORT_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file sqlite/bulk_export.hpp
+ * @brief Streaming CSV/NDJSON export of query results without per-value allocations.
+ *
+ * `sqlite::stream_exporter` formats each cell straight from `sqlite3_column_text` /
+ * `sqlite3_column_blob` and `std::to_chars` into one reusable buffer, which is handed to a
+ * callback or written to a file descriptor whenever it fills up.
+ */
+
+struct sqlite3_stmt;
+
+namespace sqlite {
+inline namespace v2 {
+    struct query;
+
+    enum class export_format {
+        csv,   ///< RFC 4180. NULL is an empty field, empty text is written as `""`.
+        ndjson ///< One JSON object per row, keyed by column name.
+    };
+
+    struct export_options {
+        export_format format    = export_format::csv;
+        char delimiter          = ',';  ///< CSV field separator.
+        bool header             = true; ///< CSV: write the column names first.
+        bool crlf               = false; ///< End rows with CRLF instead of LF.
+        std::size_t buffer_size = 1 << 20; ///< Bytes buffered between flushes.
+    };
+
+    struct export_stats {
+        std::uint64_t rows  = 0;
+        std::uint64_t bytes = 0;
+        std::size_t flushes = 0;
+        std::chrono::microseconds elapsed{0};
+    };
+
+    /// Receives each filled buffer; the view is only valid during the call.
+    using export_sink = std::function<void(std::string_view chunk)>;
+
+    /**
+     * @brief Writes the remaining rows of a query as CSV or NDJSON.
+     *
+     * Integers and reals are formatted with `std::to_chars`; reals keep a decimal point, so `2.0`
+     * is not read back as an integer. Text is quoted or escaped only where needed. Blobs are
+     * written as lowercase hex. Non-finite reals become JSON `null`. One exporter can be reused
+     * for several runs (e.g. after rebinding the query) and keeps its buffer between them. The
+     * query must outlive the exporter.
+     */
+    class stream_exporter {
+    public:
+        explicit stream_exporter(query &q, export_options options = {});
+
+        /// Steps the query to completion and passes the output to @p sink in buffer-sized chunks.
+        export_stats write(export_sink const &sink);
+
+        /// Same as above, writing to the file descriptor @p fd (retrying partial writes).
+        export_stats write(int fd);
+
+    private:
+        class output;
+
+        void write_header(output &out);
+        void write_row(output &out);
+        void end_row(output &out);
+
+        sqlite3_stmt *stmt_;
+        export_options options_;
+        std::vector<std::string> prefixes_; ///< CSV: escaped names; NDJSON: `{"name":` / `,"name":`
+        std::vector<char> buffer_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_BULK_EXPORT_HPP_INCLUDED
@@ -0,0 +1,126 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_BULK_IMPORT_HPP_INCLUDED
+#define GUARD_SQLITE_BULK_IMPORT_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sqlite/bulk_load.hpp>
+
+/**
+ * @file sqlite/bulk_import.hpp
+ * @brief Pipelined CSV/NDJSON import: parser threads feed typed row batches to the writer.
+ *
+ * The input is memory-mapped and split at line boundaries between the parser threads. Each
+ * parser turns its range into batches of typed values (NULL, integer, real or text). The batches
+ * go through a bounded queue to the calling thread, which inserts them with one prepared
+ * statement in large transactions. A full queue blocks the parsers, so memory stays bounded by
+ * `queue_depth` batches whichever side is slower.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    enum class import_format {
+        csv,   ///< RFC 4180: quoted fields, doubled quotes, CRLF or LF line ends.
+        ndjson ///< One JSON object per line; nested objects and arrays are stored as JSON text.
+    };
+
+    /// Counters reported while importing and returned once the import completes.
+    struct import_stats {
+        std::uint64_t rows         = 0;
+        std::uint64_t bytes        = 0; ///< Input bytes covered by the rows written so far.
+        std::size_t batches        = 0;
+        std::size_t transactions   = 0; ///< Committed transactions.
+        std::chrono::microseconds elapsed{0};
+        std::chrono::microseconds writer_idle{0};    ///< Writer waiting for parsed batches.
+        std::chrono::microseconds parsers_blocked{0}; ///< Parsers waiting on a full queue (summed).
+
+        double rows_per_second() const noexcept {
+            return elapsed.count() > 0 ? static_cast<double>(rows) * 1e6 / elapsed.count() : 0.0;
+        }
+
+        double bytes_per_second() const noexcept {
+            return elapsed.count() > 0 ? static_cast<double>(bytes) * 1e6 / elapsed.count() : 0.0;
+        }
+    };
+
+    /// Format, column mapping and pipeline settings for @ref import_file.
+    struct import_options {
+        import_format format = import_format::csv;
+        char delimiter       = ',';  ///< CSV field separator.
+        bool header          = true; ///< CSV: the first record names the columns.
+        /// Target columns. Defaults to the CSV header, or the keys of the first NDJSON object.
+        /// NDJSON keys that are not listed are ignored and missing keys insert NULL.
+        std::vector<std::string> columns;
+        /// Bind numeric-looking fields as integers or reals. Numbers with leading zeros stay
+        /// text. When false every CSV field is bound as text.
+        bool infer_types           = true;
+        std::size_t parser_threads = 1; ///< CSV ranges are split at newlines, see below.
+        std::size_t batch_rows     = 4096;
+        std::size_t queue_depth    = 8; ///< Parsed batches in flight before parsers block.
+        std::size_t rows_per_transaction = 1000000;
+        /// Run the writes inside a @ref bulk_load_session. Its `rows_per_transaction` then
+        /// replaces the one above.
+        std::optional<bulk_load_options> bulk;
+        /// Called by the writer after every batch.
+        std::function<void(import_stats const &)> progress;
+    };
+
+    /**
+     * @brief Imports @p path into @p table and returns the final counters.
+     *
+     * With several parser threads, batches from different ranges interleave, so rows are not
+     * inserted in file order. Ranges start after a newline, so CSV files whose quoted fields
+     * contain line breaks must use a single parser thread. On error the current
+     * transaction is rolled back and the first parse or SQLite error is rethrown. Transactions
+     * committed before the error stay in the table.
+     */
+    import_stats import_file(connection &con, std::string_view table,
+                             std::filesystem::path const &path, import_options const &options = {});
+
+    /// Same as @ref import_file for input that is already in memory.
+    import_stats import_data(connection &con, std::string_view table, std::string_view data,
+                             import_options const &options = {});
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_BULK_IMPORT_HPP_INCLUDED
@@ -0,0 +1,215 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_BULK_LOAD_HPP_INCLUDED
+#define GUARD_SQLITE_BULK_LOAD_HPP_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <sqlite/command.hpp>
+#include <sqlite/struct_mapping.hpp>
+#include <sqlite/transaction.hpp>
+
+/**
+ * @file sqlite/bulk_load.hpp
+ * @brief Bulk-load mode: deferred index maintenance, relaxed durability, key-ordered inserts.
+ *
+ * `sqlite::bulk_load_session` switches a connection into a loading configuration and restores
+ * the previous one afterwards, even when the load throws. `sqlite::bulk_loader<T>` adds a sort
+ * buffer on top so rows reach the table B-tree in primary-key order.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Journal used while loading. The previous mode is restored when the session ends.
+    enum class bulk_journal {
+        keep,   ///< Leave journal_mode alone.
+        memory, ///< In-memory rollback journal; ROLLBACK still works.
+        off     ///< No journal at all; a failed load leaves a partially written batch behind.
+    };
+
+    /// Settings applied by @ref bulk_load_session for the duration of a load.
+    struct bulk_load_options {
+        bool drop_indexes      = true; ///< Drop secondary indexes and rebuild them at the end.
+        /// Drop explicit UNIQUE indexes as well. Duplicates then only surface when the index is
+        /// rebuilt, and `ON CONFLICT` upserts that rely on it stop matching during the load.
+        bool drop_unique_indexes = false;
+        bool relax_durability  = true; ///< `PRAGMA synchronous = OFF`
+        bulk_journal journal   = bulk_journal::memory; ///< Ignored for WAL databases.
+        std::int64_t cache_kib = 256 * 1024; ///< Page cache size while loading; 0 keeps it.
+        std::size_t sort_buffer = 100000; ///< Rows @ref bulk_loader sorts before inserting.
+        std::size_t rows_per_transaction = 0; ///< Commit every N rows; 0 uses one transaction.
+    };
+
+    /**
+     * @brief Connection-wide loading configuration for one table, undone on scope exit.
+     *
+     * The constructor records `synchronous`, `journal_mode` and `cache_size`, applies the
+     * options, drops the table's explicit non-unique indexes (UNIQUE and PRIMARY KEY constraints
+     * stay, and so do UNIQUE indexes unless `drop_unique_indexes` is set) and begins an
+     * IMMEDIATE transaction. @ref finish commits, recreates the indexes from their stored SQL
+     * and restores the pragmas. If the session is destroyed without @ref finish, the open
+     * transaction is rolled back and the indexes and pragmas are restored all the same; batches
+     * already committed through @ref commit_batch stay in the table.
+     *
+     * If an index cannot be recreated (a dropped UNIQUE index the loaded rows now violate), the
+     * rows stay committed, @ref finish throws and the index keeps being listed by
+     * @ref dropped_indexes. Fix the data and call @ref finish again to retry the rebuild.
+     *
+     * WAL databases keep their journal mode, since it is persistent and shared with other
+     * connections. Must be started outside of a transaction.
+     */
+    class bulk_load_session {
+    public:
+        bulk_load_session(connection &con, std::string_view table,
+                          bulk_load_options const &options = {});
+        ~bulk_load_session();
+
+        bulk_load_session(bulk_load_session const &)            = delete;
+        bulk_load_session &operator=(bulk_load_session const &) = delete;
+
+        /// Counts @p rows toward `rows_per_transaction`, committing when the batch is full.
+        void rows_added(std::size_t rows);
+
+        /// Commits the rows written so far and begins the next transaction.
+        void commit_batch();
+
+        /// Commits, rebuilds the dropped indexes and restores the previous connection state.
+        /// Can be called again after a failed index rebuild.
+        void finish();
+
+        bool finished() const noexcept {
+            return finished_;
+        }
+
+        connection &get_connection() noexcept {
+            return con_;
+        }
+
+        /// Names of the indexes currently dropped for the load, in creation order.
+        std::vector<std::string> dropped_indexes() const;
+
+        bulk_load_options const &options() const noexcept {
+            return options_;
+        }
+
+    private:
+        struct saved_index {
+            std::string name;
+            std::string sql;
+            bool dropped = false;
+        };
+
+        void rebuild_indexes();
+        void restore_pragmas() noexcept;
+
+        connection &con_;
+        std::string table_;
+        bulk_load_options options_;
+        std::optional<transaction> tx_;
+        std::vector<saved_index> indexes_;
+        int previous_synchronous_ = -1;
+        std::int64_t previous_cache_size_ = 0;
+        std::string previous_journal_;
+        std::size_t batch_rows_ = 0;
+        bool finished_          = false;
+    };
+
+    /**
+     * @brief Buffered, key-sorted inserts of a described struct inside a bulk-load session.
+     *
+     * Rows are collected into a buffer of `sort_buffer` entries, sorted by the struct's first
+     * field (its primary key, as in @ref struct_sql) and written with `struct_sql<T>::insert`.
+     * Sorted runs append to the right edge of the table B-tree instead of splitting pages at
+     * random positions. Call @ref finish to write the tail and rebuild the indexes; rows still
+     * buffered when the loader is destroyed without it are discarded.
+     */
+    template <described_struct T> class bulk_loader {
+    public:
+        explicit bulk_loader(connection &con, bulk_load_options const &options = {}) :
+            session_(con, describe<T>().table, options),
+            insert_(con, struct_sql<T>::insert),
+            capacity_(std::max<std::size_t>(options.sort_buffer, 1)) {
+            buffer_.reserve(capacity_);
+        }
+
+        void insert(T row) {
+            buffer_.push_back(std::move(row));
+            if (buffer_.size() >= capacity_) {
+                flush();
+            }
+        }
+
+        /// Sorts and writes the buffered rows.
+        void flush() {
+            std::stable_sort(buffer_.begin(), buffer_.end(), [](T const &lhs, T const &rhs) {
+                return std::get<0>(tie_fields(lhs)) < std::get<0>(tie_fields(rhs));
+            });
+            for (auto const &row : buffer_) {
+                insert_.clear();
+                insert_.bind_struct(row).step_once();
+            }
+            insert_.clear();
+            auto written = buffer_.size();
+            buffer_.clear();
+            session_.rows_added(written);
+        }
+
+        /// Writes the remaining rows and ends the session (see @ref bulk_load_session::finish).
+        void finish() {
+            flush();
+            session_.finish();
+        }
+
+        bulk_load_session &session() noexcept {
+            return session_;
+        }
+
+    private:
+        bulk_load_session session_;
+        command insert_;
+        std::size_t capacity_;
+        std::vector<T> buffer_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_BULK_LOAD_HPP_INCLUDED
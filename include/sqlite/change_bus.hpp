@@ -0,0 +1,211 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_CHANGE_BUS_HPP_INCLUDED
+#define GUARD_SQLITE_CHANGE_BUS_HPP_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @file sqlite/change_bus.hpp
+ * @brief Commit-batched row change notifications delivered on a dispatcher thread.
+ *
+ * `sqlite::change_bus` turns the update, commit and rollback hooks of a connection into table
+ * subscriptions, so services can react to writes instead of polling for them.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    namespace detail {
+        class change_hooks;
+    }
+
+    /// What happened to a row. `unknown` stands for rows SQLite changed without naming them to
+    /// the update hook; it carries no table or rowid and reaches every subscriber.
+    enum class change_kind { insert, update, remove, unknown };
+
+    /// One row touched by a committed transaction. The names stay valid for the bus lifetime.
+    struct table_change {
+        std::string_view schema;
+        std::string_view table;
+        change_kind kind   = change_kind::insert;
+        std::int64_t rowid = 0;
+    };
+
+    /// Inclusive rowid bounds a subscription is interested in.
+    struct rowid_range {
+        std::int64_t first = std::numeric_limits<std::int64_t>::min();
+        std::int64_t last  = std::numeric_limits<std::int64_t>::max();
+    };
+
+    /// Receives the changes of one commit that match a subscription, in statement order.
+    using change_callback = std::function<void(std::span<table_change const>)>;
+
+    /// Counters reported by @ref change_bus::stats.
+    struct change_bus_stats {
+        std::uint64_t committed_batches = 0; ///< Commits that changed at least one row.
+        std::uint64_t discarded_batches = 0; ///< Rolled back transactions that changed rows.
+        std::uint64_t changes           = 0; ///< Rows reported across committed batches.
+        std::uint64_t unknown_changes   = 0; ///< `change_kind::unknown` markers published.
+        std::uint64_t callbacks         = 0; ///< Subscriber invocations.
+        std::uint64_t callback_errors   = 0; ///< Invocations that threw.
+        std::size_t queued_batches      = 0; ///< Batches waiting for the dispatcher.
+    };
+
+    /**
+     * @brief Publishes committed row changes of one connection to subscribers.
+     *
+     * The update hook buffers each change in the writer's transaction. The commit hook hands the
+     * whole batch to a queue and returns; a dispatcher thread filters it per subscription and
+     * invokes the callbacks, so slow subscribers never hold up the writer. The rollback hook
+     * discards the buffer.
+     *
+     * Batches are queued when SQLite runs the commit hook, before the commit is durable, and
+     * SQLite offers no hook after it. Subscribers may therefore see a batch whose COMMIT then
+     * fails: SQLITE_BUSY leaves the transaction open, and an I/O error rolls it back after the
+     * batch was queued. Subscribers that need certainty should re-read the rows they are told
+     * about, retrying on busy, rather than trust the batch alone.
+     *
+     * The update hook does not see WITHOUT ROWID tables or `DELETE FROM t` without WHERE. When
+     * SQLite counted more changed rows than the hook reported, the bus publishes a
+     * `change_kind::unknown` marker after the commit, and subscribers should re-read whatever
+     * they watch. Rows that `INSERT OR REPLACE` deletes on a UNIQUE conflict are neither reported
+     * nor counted, so subscribers to such tables should treat an insert as a possible delete of
+     * other rows. Changes undone with ROLLBACK TO a savepoint are still reported.
+     *
+     * The bus listens to @p con's update, commit and rollback hooks through the connection's
+     * shared listener registry, so it coexists with query and row caches; @p con must outlive
+     * it. Queued batches are delivered before the destructor returns; subscriptions must be
+     * reset before then.
+     */
+    class change_bus {
+    public:
+        /// Keeps a callback registered; destroying or resetting it unsubscribes.
+        class subscription {
+        public:
+            subscription() = default;
+            subscription(subscription &&other) noexcept;
+            subscription &operator=(subscription &&other) noexcept;
+            subscription(subscription const &)            = delete;
+            subscription &operator=(subscription const &) = delete;
+            ~subscription();
+
+            /// Unsubscribes; when called off the dispatcher thread, waits for a running delivery.
+            void reset();
+
+            explicit operator bool() const noexcept {
+                return bus_ != nullptr;
+            }
+
+        private:
+            friend class change_bus;
+            subscription(change_bus *bus, std::uint64_t id) : bus_(bus), id_(id) {}
+            change_bus *bus_  = nullptr;
+            std::uint64_t id_ = 0;
+        };
+
+        explicit change_bus(connection &con);
+        ~change_bus();
+
+        change_bus(change_bus const &)            = delete;
+        change_bus &operator=(change_bus const &) = delete;
+
+        /**
+         * @brief Calls @p callback with the changes to @p table after each commit.
+         *
+         * @p table is `name` or `schema.name`, matched case-insensitively; an empty name
+         * subscribes to every table. Only rowids inside @p range are delivered.
+         */
+        [[nodiscard]] subscription subscribe(std::string_view table, change_callback callback,
+                                             rowid_range range = {});
+
+        /// Blocks until every batch queued so far has been delivered.
+        void flush();
+
+        change_bus_stats stats() const;
+
+    private:
+        struct subscriber {
+            std::uint64_t id = 0;
+            std::string schema;
+            std::string table;
+            rowid_range range;
+            change_callback callback;
+        };
+
+        static void on_update(void *self, int op, char const *schema, char const *table,
+                              long long rowid);
+        static int on_commit(void *self);
+        static void on_rollback(void *self);
+        static void on_missed(void *self);
+
+        std::string_view intern(char const *name);
+        void unsubscribe(std::uint64_t id);
+        void run();
+
+        connection &con_;
+        detail::change_hooks *hooks_ = nullptr;
+
+        // Touched only from the writer's hooks, which SQLite serializes per connection.
+        std::unordered_set<std::string> names_;
+        std::vector<table_change> pending_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable idle_;
+        std::deque<std::vector<table_change>> queue_;
+        std::vector<std::shared_ptr<subscriber const>> subscribers_;
+        std::uint64_t next_id_ = 1;
+        bool dispatching_      = false;
+        bool settle_           = false;
+        bool stop_             = false;
+        change_bus_stats stats_;
+        std::thread dispatcher_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_CHANGE_BUS_HPP_INCLUDED
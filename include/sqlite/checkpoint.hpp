@@ -0,0 +1,161 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_CHECKPOINT_HPP_INCLUDED
+#define GUARD_SQLITE_CHECKPOINT_HPP_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+struct sqlite3;
+
+/**
+ * @file sqlite/checkpoint.hpp
+ * @brief Background WAL checkpointing driven by `sqlite3_wal_hook`.
+ *
+ * SQLite's autocheckpoint runs on whichever writer crosses the threshold, adding the checkpoint
+ * cost to that commit. `sqlite::checkpoint_manager` disables autocheckpoint on the writer, listens
+ * for commits through the WAL hook and checkpoints on its own connection and thread instead.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Mirrors the `SQLITE_CHECKPOINT_*` modes accepted by `sqlite3_wal_checkpoint_v2`.
+    enum class checkpoint_mode {
+        passive,  ///< Copy what is possible without waiting for readers or writers.
+        full,     ///< Wait for writers, then checkpoint every frame.
+        restart,  ///< Like full, then wait for readers so the next writer restarts the WAL.
+        truncate  ///< Like restart, then truncate the WAL file to zero bytes.
+    };
+
+    /// Thresholds and timing used by @ref checkpoint_manager.
+    struct checkpoint_options {
+        std::string schema  = "main"; ///< Attached database to checkpoint.
+        int passive_frames  = 1000;   ///< WAL frames that trigger a PASSIVE checkpoint.
+        int restart_frames  = 10000;  ///< WAL frames that escalate to RESTART.
+        int truncate_frames = 50000;  ///< WAL frames that escalate to TRUNCATE.
+        std::chrono::milliseconds interval{1000};    ///< Idle wake-up to drain small WALs.
+        std::chrono::milliseconds busy_timeout{100}; ///< Wait budget for RESTART/TRUNCATE.
+    };
+
+    /// Result of a single `sqlite3_wal_checkpoint_v2` call.
+    struct checkpoint_result {
+        checkpoint_mode mode    = checkpoint_mode::passive;
+        bool busy               = false; ///< True when SQLite reported SQLITE_BUSY.
+        int wal_frames          = 0;     ///< Frames in the WAL after the call.
+        int checkpointed_frames = 0;     ///< Frames of this WAL checkpointed so far, by any call.
+        std::chrono::microseconds duration{0};
+    };
+
+    /// Cumulative counters reported by @ref checkpoint_manager::stats.
+    struct checkpoint_stats {
+        std::uint64_t passive_runs        = 0;
+        std::uint64_t restart_runs        = 0; ///< Includes FULL checkpoints.
+        std::uint64_t truncate_runs       = 0;
+        std::uint64_t busy_runs           = 0; ///< Checkpoints that could not complete.
+        std::uint64_t failures            = 0; ///< Checkpoints that raised an error.
+        int wal_frames                    = 0; ///< Latest WAL size in frames.
+        std::int64_t wal_bytes            = 0; ///< Latest WAL size in bytes (from the page size).
+        std::uint64_t checkpointed_frames = 0; ///< Frames copied back by this manager's runs.
+        std::chrono::microseconds last_duration{0};
+        std::chrono::microseconds max_duration{0};
+    };
+
+    /**
+     * @brief Owns a checkpointing thread and a dedicated connection for a WAL database.
+     *
+     * The constructor disables autocheckpoint on @p writer and installs a WAL hook which records
+     * the WAL size after each commit. The background thread runs PASSIVE checkpoints once
+     * `passive_frames` is reached (or on every `interval` while the WAL is non-empty) and
+     * escalates to RESTART or TRUNCATE for larger WALs. The destructor stops the thread, removes
+     * the hook and restores the previous autocheckpoint setting, so @p writer must outlive the
+     * manager. Only one manager (or other WAL hook) may be attached to a connection at a time.
+     */
+    class checkpoint_manager {
+    public:
+        explicit checkpoint_manager(connection &writer, checkpoint_options options = {});
+        ~checkpoint_manager();
+
+        checkpoint_manager(checkpoint_manager const &)            = delete;
+        checkpoint_manager &operator=(checkpoint_manager const &) = delete;
+
+        /// Wakes the background thread to checkpoint without waiting for a threshold.
+        void request();
+
+        /// Runs a checkpoint synchronously on the dedicated connection.
+        checkpoint_result checkpoint_now(checkpoint_mode mode = checkpoint_mode::passive);
+
+        /// Snapshot of the counters collected so far.
+        checkpoint_stats stats() const;
+
+    private:
+        static int on_wal_commit(void *self, sqlite3 *, char const *schema, int frames);
+        void run();
+        checkpoint_mode pick_mode(int frames) const;
+        checkpoint_result checkpoint_locked(checkpoint_mode mode);
+
+        connection &writer_;
+        checkpoint_options options_;
+        std::unique_ptr<connection> checkpointer_;
+        int previous_autocheckpoint_ = 0;
+        std::int64_t frame_bytes_    = 0;
+
+        std::atomic<int> wal_frames_{0};
+        std::atomic<bool> dirty_{false};
+        std::mutex checkpoint_mutex_;
+        mutable std::mutex stats_mutex_;
+        checkpoint_stats stats_;
+        // SQLite reports checkpointed frames per WAL, not per call; these are already counted.
+        int counted_wal_frames_ = 0;
+        int counted_frames_     = 0;
+
+        std::mutex wake_mutex_;
+        std::condition_variable wake_;
+        bool wake_requested_ = false;
+        bool stop_           = false;
+        std::thread worker_;
+    };
+
+    /// Convert checkpoint_mode to the corresponding PRAGMA token.
+    std::string_view to_string(checkpoint_mode mode);
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_CHECKPOINT_HPP_INCLUDED
@@ -0,0 +1,130 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_CHUNKED_MUTATION_HPP_INCLUDED
+#define GUARD_SQLITE_CHUNKED_MUTATION_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <sqlite/checkpoint.hpp>
+#include <sqlite/command.hpp>
+
+/**
+ * @file sqlite/chunked_mutation.hpp
+ * @brief Large DELETE/UPDATE statements split into short key-range transactions.
+ *
+ * `sqlite::chunked_mutation` walks a table in key order and applies the mutation one chunk per
+ * IMMEDIATE transaction, so other writers only ever wait for a single short chunk and the WAL
+ * can be checkpointed while the job runs.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Progress reported after every chunk and returned by @ref chunked_mutation::run.
+    struct chunked_mutation_progress {
+        std::size_t chunks      = 0;
+        std::uint64_t rows      = 0; ///< Rows changed so far (direct changes only).
+        std::size_t chunk_size  = 0; ///< Matching keys covered by the next chunk.
+        std::int64_t last_key   = 0; ///< Largest key covered so far.
+        bool finished           = false;
+        std::chrono::microseconds last_chunk{0}; ///< Duration of the latest transaction.
+        std::chrono::microseconds elapsed{0};
+    };
+
+    /// Chunking, pacing and checkpoint settings for @ref chunked_mutation::run.
+    struct chunked_mutation_options {
+        std::string key        = "rowid"; ///< Unique, indexed INTEGER key column.
+        std::size_t chunk_size = 1000;    ///< Matching keys covered by the first chunk.
+        std::size_t min_chunk  = 10;
+        std::size_t max_chunk  = 100000;
+        std::chrono::milliseconds time_budget{50}; ///< Target duration of one transaction.
+        std::chrono::milliseconds pause{0};        ///< Sleep between chunks to let others in.
+        std::size_t checkpoint_every = 0; ///< Chunks between WAL checkpoints; 0 disables them.
+        checkpoint_mode checkpoint   = checkpoint_mode::passive;
+        /// Called after each chunk; returning false stops before the next one.
+        std::function<bool(chunked_mutation_progress const &)> progress;
+    };
+
+    /**
+     * @brief A DELETE or UPDATE applied in ascending key ranges.
+     *
+     * Each chunk runs `SELECT max(key)` over the next `chunk_size` matching keys, then applies the
+     * mutation to `(where) AND key >= next AND key <= max` and commits, where `next` follows the
+     * previous chunk's maximum. The chunk size adapts so a transaction stays close to the time
+     * budget. Because progress is tracked by key, rows an UPDATE moves out of or into the
+     * predicate are never revisited. Rows whose key is NULL, possible when the key is not the
+     * rowid, match no range and are left untouched. Parameters bound with @ref bind apply to
+     * @c where, which is where all `?` placeholders must live.
+     */
+    class chunked_mutation {
+    public:
+        /// `DELETE FROM table WHERE (where)`
+        static chunked_mutation remove(connection &con, std::string_view table,
+                                       std::string_view where);
+
+        /// `UPDATE table SET assignments WHERE (where)`
+        static chunked_mutation update(connection &con, std::string_view table,
+                                       std::string_view assignments, std::string_view where);
+
+        /// Stores @p args (by value) as the parameters of the predicate.
+        template <typename... Args> chunked_mutation &bind(Args &&...args) {
+            binder_ = [... values = std::forward<Args>(args)](command &cmd) {
+                (void)(cmd % ... % values);
+            };
+            return *this;
+        }
+
+        /// Runs every chunk and returns the final progress; rethrows errors after rollback.
+        chunked_mutation_progress run(chunked_mutation_options const &options = {});
+
+    private:
+        chunked_mutation(connection &con, std::string table, std::string assignments,
+                         std::string where);
+
+        connection &con_;
+        std::string table_;
+        std::string assignments_; ///< Empty for DELETE
+        std::string where_;
+        std::function<void(command &)> binder_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_CHUNKED_MUTATION_HPP_INCLUDED
@@ -0,0 +1,326 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_COLUMN_BATCH_HPP_INCLUDED
+#define GUARD_SQLITE_COLUMN_BATCH_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <sqlite/detail/type_helpers.hpp>
+#include <sqlite/typed_rows.hpp>
+
+/**
+ * @file sqlite/column_batch.hpp
+ * @brief Structure-of-arrays buffers filled by `result::fetch_columns`.
+ *
+ * Every requested column lands in its own contiguous vector with a validity bitmap. Text and
+ * blob columns share one byte arena per column plus an offset array, so a batch of N rows costs
+ * a handful of allocations that are reused across batches.
+ */
+namespace sqlite {
+inline namespace v2 {
+    /**
+     * @brief Bit-packed validity mask; bit @c i is set when row @c i is not NULL.
+     *
+     * Bits are stored least-significant first, matching the Arrow validity bitmap layout.
+     */
+    class validity_bitmap {
+    public:
+        void push_back(bool valid) {
+            if ((size_ & 7u) == 0) {
+                bits_.push_back(0);
+            }
+            if (valid) {
+                bits_.back() |= static_cast<std::uint8_t>(1u << (size_ & 7u));
+            } else {
+                ++null_count_;
+            }
+            ++size_;
+        }
+
+        bool valid(std::size_t row) const noexcept {
+            return (bits_[row >> 3] >> (row & 7u)) & 1u;
+        }
+
+        std::size_t size() const noexcept {
+            return size_;
+        }
+
+        std::size_t null_count() const noexcept {
+            return null_count_;
+        }
+
+        std::uint8_t const *data() const noexcept {
+            return bits_.data();
+        }
+
+        void clear() noexcept {
+            bits_.clear();
+            size_       = 0;
+            null_count_ = 0;
+        }
+
+        void reserve(std::size_t rows) {
+            bits_.reserve((rows + 7) / 8);
+        }
+
+    private:
+        std::vector<std::uint8_t> bits_;
+        std::size_t size_       = 0;
+        std::size_t null_count_ = 0;
+    };
+
+    /// Column of fixed-width values; NULL rows hold a value-initialized @p T.
+    template <typename T> struct fixed_column {
+        using value_type = T;
+
+        std::vector<T> values;
+        validity_bitmap validity;
+
+        std::size_t size() const noexcept {
+            return values.size();
+        }
+
+        bool is_null(std::size_t row) const noexcept {
+            return !validity.valid(row);
+        }
+
+        T const &operator[](std::size_t row) const noexcept {
+            return values[row];
+        }
+
+        void clear() noexcept {
+            values.clear();
+            validity.clear();
+        }
+
+        void reserve(std::size_t rows) {
+            values.reserve(rows);
+            validity.reserve(rows);
+        }
+    };
+
+    /**
+     * @brief Column of variable-length values packed into a single arena.
+     *
+     * Row @c i occupies `arena[offsets[i], offsets[i + 1])`; @c offsets therefore always holds
+     * `size() + 1` entries. NULL rows are zero-length.
+     */
+    template <typename Byte> struct variable_column {
+        using byte_type = Byte;
+
+        std::vector<Byte> arena;
+        std::vector<std::int64_t> offsets{0};
+        validity_bitmap validity;
+
+        std::size_t size() const noexcept {
+            return offsets.size() - 1;
+        }
+
+        bool is_null(std::size_t row) const noexcept {
+            return !validity.valid(row);
+        }
+
+        std::span<const Byte> bytes(std::size_t row) const noexcept {
+            auto begin = static_cast<std::size_t>(offsets[row]);
+            auto end   = static_cast<std::size_t>(offsets[row + 1]);
+            return {arena.data() + begin, end - begin};
+        }
+
+        void clear() noexcept {
+            arena.clear();
+            offsets.resize(1);
+            validity.clear();
+        }
+
+        void reserve(std::size_t rows) {
+            offsets.reserve(rows + 1);
+            validity.reserve(rows);
+        }
+
+        void push_back(std::span<const Byte> value, bool valid) {
+            arena.insert(arena.end(), value.begin(), value.end());
+            offsets.push_back(static_cast<std::int64_t>(arena.size()));
+            validity.push_back(valid);
+        }
+    };
+
+    /// UTF-8 text column; rows are exposed as `std::string_view` into the arena.
+    struct text_column : variable_column<char> {
+        std::string_view operator[](std::size_t row) const noexcept {
+            auto b = bytes(row);
+            return {b.data(), b.size()};
+        }
+    };
+
+    /// Blob column; rows are exposed as spans into the arena.
+    struct blob_column : variable_column<unsigned char> {
+        std::span<const unsigned char> operator[](std::size_t row) const noexcept {
+            return bytes(row);
+        }
+    };
+
+    namespace detail {
+        template <typename T> struct column_storage {
+            using type = fixed_column<T>;
+        };
+
+        template <typename T> struct column_storage<std::optional<T>> : column_storage<T> {};
+
+        template <> struct column_storage<std::string> {
+            using type = text_column;
+        };
+
+        template <> struct column_storage<std::string_view> {
+            using type = text_column;
+        };
+
+        template <> struct column_storage<std::vector<unsigned char>> {
+            using type = blob_column;
+        };
+
+        template <> struct column_storage<std::span<const unsigned char>> {
+            using type = blob_column;
+        };
+
+        template <> struct column_storage<std::span<const std::byte>> {
+            using type = blob_column;
+        };
+
+        template <typename T> using column_storage_t = typename column_storage<decay_t<T>>::type;
+
+        template <typename T> void append_fixed(fixed_column<T> &col, sqlite3_stmt *stmt, int idx) {
+            if (stmt_column_is_null(stmt, idx)) {
+                col.values.emplace_back();
+                col.validity.push_back(false);
+            } else {
+                col.values.push_back(read_column<T>(stmt, idx));
+                col.validity.push_back(true);
+            }
+        }
+
+        inline void append_text(text_column &col, sqlite3_stmt *stmt, int idx) {
+            if (stmt_column_is_null(stmt, idx)) {
+                col.push_back({}, false);
+            } else {
+                auto text = stmt_column_text(stmt, idx);
+                col.push_back(std::span<const char>(text.data(), text.size()), true);
+            }
+        }
+
+        inline void append_blob(blob_column &col, sqlite3_stmt *stmt, int idx) {
+            bool valid = !stmt_column_is_null(stmt, idx);
+            col.push_back(valid ? stmt_column_blob(stmt, idx) : std::span<const unsigned char>{},
+                          valid);
+        }
+
+        template <typename Storage> void append_column(Storage &col, sqlite3_stmt *stmt, int idx) {
+            if constexpr (std::is_same_v<Storage, text_column>) {
+                append_text(col, stmt, idx);
+            } else if constexpr (std::is_same_v<Storage, blob_column>) {
+                append_blob(col, stmt, idx);
+            } else {
+                append_fixed(col, stmt, idx);
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Reusable columnar batch for the column types @p Ts.
+     *
+     * Arithmetic, enum, bool and chrono types map to @ref fixed_column, `std::string` /
+     * `std::string_view` to @ref text_column and byte vectors/spans to @ref blob_column;
+     * `std::optional<T>` maps like @c T since every column carries a validity bitmap.
+     */
+    template <typename... Ts> class column_batch {
+    public:
+        using columns_type = std::tuple<detail::column_storage_t<Ts>...>;
+
+        static constexpr std::size_t column_count = sizeof...(Ts);
+
+        template <std::size_t I> auto &column() noexcept {
+            return std::get<I>(columns_);
+        }
+
+        template <std::size_t I> auto const &column() const noexcept {
+            return std::get<I>(columns_);
+        }
+
+        columns_type &columns() noexcept {
+            return columns_;
+        }
+
+        std::size_t size() const noexcept {
+            return rows_;
+        }
+
+        bool empty() const noexcept {
+            return rows_ == 0;
+        }
+
+        /// Drops all rows but keeps the allocated capacity for the next batch.
+        void clear() noexcept {
+            std::apply([](auto &...col) { (col.clear(), ...); }, columns_);
+            rows_ = 0;
+        }
+
+        void reserve(std::size_t rows) {
+            std::apply([rows](auto &...col) { (col.reserve(rows), ...); }, columns_);
+        }
+
+        /// Appends the current row of @p stmt; used by @ref result::fetch_columns.
+        void append_row(sqlite3_stmt *stmt) {
+            append_row(stmt, std::index_sequence_for<Ts...>{});
+        }
+
+    private:
+        template <std::size_t... Index>
+        void append_row(sqlite3_stmt *stmt, std::index_sequence<Index...>) {
+            (detail::append_column(std::get<Index>(columns_), stmt, static_cast<int>(Index)), ...);
+            ++rows_;
+        }
+
+        columns_type columns_;
+        std::size_t rows_ = 0;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_COLUMN_BATCH_HPP_INCLUDED
@@ -43,6 +43,7 @@
 #include <vector>
 #include <sqlite/connection.hpp>
 #include <sqlite/detail/type_helpers.hpp>
+#include <sqlite/struct_mapping.hpp>
 
 struct sqlite3_stmt;
 
@@ -74,6 +75,13 @@ inline namespace v2 {
      */
     extern null_type nil;
 
+    /** \brief \a zeroblob binds a blob of \a size zero bytes without materializing it.
+     * The reserved space is typically filled afterwards through sqlite::blob_stream.
+     */
+    struct zeroblob {
+        std::uint64_t size;
+    };
+
     /** \brief \a command is the base class of all sql command classes
      * An object of this class is not copyable
      */
@@ -177,10 +185,32 @@ inline namespace v2 {
         void bind(int idx, std::span<const unsigned char> v);
         void bind(int idx, std::span<const std::byte> v);
 
+        /** \brief binds a zero-filled blob of the requested size (sqlite3_bind_zeroblob64)
+         * \param idx index of the parameter
+         * \param blob size of the blob to reserve
+         */
+        void bind(int idx, zeroblob blob);
+
         template <typename Value> void bind_value(int idx, Value &&value);
 
         int parameter_index(std::string_view name) const;
 
+        /** \brief Binds the mapped fields of \a value to parameters 1..N in field order.
+         *
+         * Accepts structs described with VSQLITE_FIELDS as well as plain aggregates (see
+         * sqlite/struct_mapping.hpp) and matches the parameter numbering of struct_sql<T>.
+         * \return reference to this command
+         */
+        template <mappable_struct T> command &bind_struct(T const &value) {
+            std::apply(
+                [this](auto const &...field) {
+                    int idx = 0;
+                    (bind_value(++idx, field), ...);
+                },
+                tie_fields(value));
+            return *this;
+        }
+
         template <typename Value> void bind(std::string_view name, Value &&value) {
             bind(parameter_index(name), std::forward<Value>(value));
         }
@@ -244,6 +274,12 @@ inline namespace v2 {
         command &operator%(std::span<const unsigned char> p);
         command &operator%(std::span<const std::byte> p);
 
+        /** \brief replacement for void command::bind(int idx, zeroblob);
+         * Indexes are given automatically first call uses 1 as index, second 2
+         * and so on
+         */
+        command &operator%(zeroblob p);
+
         template <typename T> command &operator%(named_parameter<T> param) {
             bind(param.name, std::move(param.value));
             return *this;
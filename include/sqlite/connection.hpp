@@ -36,6 +36,7 @@
 #include <string>
 #include <sqlite/filesystem_adapter.hpp>
 #include <sqlite/statement_cache.hpp>
+#include <sqlite/stats.hpp>
 
 /**
  * @file sqlite/connection.hpp
@@ -48,6 +49,10 @@ struct sqlite3;
 
 namespace sqlite {
 inline namespace v2 {
+    namespace detail {
+        class change_hooks;
+    }
+
     enum class open_mode {
         open_readonly,  ///< Opens an existing database for reads only or fails
         open_existing,  ///< Opens an existing database; fails when it is missing
@@ -114,6 +119,12 @@ inline namespace v2 {
          */
         std::int64_t get_last_insert_rowid();
 
+        /** \brief Returns the `sqlite3_db_status` counters of this connection
+         * (page cache, lookaside, schema and statement memory). The call does
+         * not allocate and may be issued from a monitoring thread.
+         */
+        connection_stats stats() const;
+
         void configure_statement_cache(statement_cache_config const &cfg);
         statement_cache_config statement_cache_settings() const;
         void clear_statement_cache();
@@ -130,11 +141,13 @@ inline namespace v2 {
         void open_with_flags(std::string const &db, int flags);
         sqlite3_stmt *acquire_cached_statement(std::string const &sql);
         void release_cached_statement(std::string const &sql, sqlite3_stmt *stmt);
+        detail::change_hooks &change_hooks();
 
     private:
         sqlite3 *handle;
         filesystem_adapter_ptr filesystem;
         statement_cache cache_;
+        std::unique_ptr<detail::change_hooks> hooks_;
     };
 } // namespace v2
 } // namespace sqlite
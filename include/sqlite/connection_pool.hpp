@@ -34,6 +34,7 @@
 
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -51,6 +52,14 @@
 namespace sqlite {
 inline namespace v2 {
 
+    /// Aggregated view over every connection a @ref connection_pool created.
+    struct pool_stats {
+        std::size_t capacity = 0; ///< Maximum number of connections.
+        std::size_t created  = 0; ///< Connections created so far.
+        std::size_t idle     = 0; ///< Connections currently waiting in the pool.
+        connection_stats totals;  ///< Per-connection counters summed (peaks: the largest).
+    };
+
     /// Thread-safe pool for leasing reusable SQLite connections.
     class connection_pool {
     public:
@@ -72,6 +81,11 @@ inline namespace v2 {
             connection *operator->() const;
             std::shared_ptr<connection> shared() const;
 
+            /// True when the lease holds a connection (see @ref connection_pool::try_acquire).
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(connection_);
+            }
+
         private:
             struct shared_state;
             void release();
@@ -98,6 +112,22 @@ inline namespace v2 {
          */
         lease acquire();
 
+        /**
+         * @brief Returns a lease without blocking, or an empty lease when every connection is
+         * checked out.
+         */
+        lease try_acquire();
+
+        /**
+         * @brief Like @ref try_acquire, but when no connection is available @p on_available is
+         * queued and called once, on the releasing thread, after a connection was returned.
+         *
+         * The callback only signals that a retry may succeed; it must not block. One waiter is
+         * woken per returned connection, oldest first, but the pool does not reserve the
+         * connection for it: a woken waiter that loses the race must queue again, at the back.
+         */
+        lease try_acquire(std::function<void()> on_available);
+
         /// Maximum number of concurrent connections the pool will create.
         std::size_t capacity() const;
 
@@ -107,9 +137,31 @@ inline namespace v2 {
         /// Number of connections that have been created so far.
         std::size_t created_count() const;
 
+        /// Number of connections currently leased out.
+        std::size_t leased_count() const;
+
+        /**
+         * @brief Sums the memory and cache counters of all pooled connections.
+         *
+         * Idle connections are sampled directly. Leased connections are never touched from the
+         * polling thread (that would wait on a running statement); they contribute the counters
+         * captured when they were last returned, or when they were created if they have not been
+         * returned since.
+         */
+        pool_stats stats() const;
+
     private:
         friend class lease;
         void release(std::shared_ptr<connection> conn);
+        void wake_one(std::unique_lock<std::mutex> &lock);
+        std::shared_ptr<connection> create();
+        void remember(std::shared_ptr<connection> const &conn, connection_stats const &stats) const;
+
+        /// The last counters sampled from one connection the pool created.
+        struct stats_sample {
+            std::weak_ptr<connection> conn;
+            connection_stats stats;
+        };
 
         connection_factory factory_;
         std::size_t capacity_;
@@ -117,6 +169,8 @@ inline namespace v2 {
         mutable std::mutex mutex_;
         std::condition_variable cv_;
         std::vector<std::shared_ptr<connection>> idle_;
+        std::deque<std::function<void()>> waiters_;
+        mutable std::vector<stats_sample> samples_;
     };
 
 } // namespace v2
@@ -0,0 +1,283 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_COROUTINE_HPP_INCLUDED
+#define GUARD_SQLITE_COROUTINE_HPP_INCLUDED
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <sqlite/command.hpp>
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/executor.hpp>
+#include <sqlite/query.hpp>
+
+/**
+ * @file sqlite/coroutine.hpp
+ * @brief C++20 `co_await` support for pool leases, statement execution and row iteration.
+ *
+ * Blocking SQLite calls are shipped to the small thread pool of a `sqlite::async_context`; the
+ * awaiting coroutine is resumed through a caller-supplied resume function (for example posting to
+ * an event loop) or, by default, directly on the database thread. Any coroutine type works: the
+ * awaitables only need a `std::coroutine_handle<>`.
+ */
+namespace sqlite {
+inline namespace v2 {
+
+    /// Thread pool that runs blocking database work on behalf of suspended coroutines.
+    class async_context {
+    public:
+        using resume_function = std::function<void(std::coroutine_handle<>)>;
+
+        /**
+         * @brief Starts @p threads database threads.
+         *
+         * @param resume Called with the handle of every coroutine that is ready to continue. When
+         * empty the coroutine resumes on the database thread that completed its work.
+         */
+        explicit async_context(std::size_t threads = 2, resume_function resume = {});
+
+        /// Finishes the queued work, then joins the database threads.
+        ~async_context();
+
+        async_context(async_context const &)            = delete;
+        async_context &operator=(async_context const &) = delete;
+
+        /// Queues @p work on a database thread.
+        void dispatch(std::function<void()> work);
+
+        /// Resumes @p handle through the configured resume function.
+        void resume(std::coroutine_handle<> handle);
+
+        /// Number of database threads.
+        std::size_t thread_count() const noexcept {
+            return threads_.size();
+        }
+
+    private:
+        void run();
+
+        resume_function resume_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::deque<std::function<void()>> queue_;
+        bool stop_ = false;
+        std::vector<std::thread> threads_;
+    };
+
+    /**
+     * @brief Awaitable that runs @p Fn on a database thread and yields its result.
+     *
+     * Exceptions thrown by the work are rethrown from `co_await`.
+     */
+    template <typename Fn> class async_operation {
+    public:
+        using value_type = std::invoke_result_t<Fn &>;
+
+        async_operation(async_context &ctx, Fn fn) : ctx_(&ctx), fn_(std::move(fn)) {}
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            ctx_->dispatch([this, handle] {
+                try {
+                    if constexpr (std::is_void_v<value_type>) {
+                        fn_();
+                        value_.emplace();
+                    } else {
+                        value_.emplace(fn_());
+                    }
+                } catch (...) {
+                    error_ = std::current_exception();
+                }
+                ctx_->resume(handle);
+            });
+        }
+
+        value_type await_resume() {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            if constexpr (!std::is_void_v<value_type>) {
+                return std::move(*value_);
+            }
+        }
+
+    private:
+        using storage_type =
+            std::conditional_t<std::is_void_v<value_type>, std::monostate, value_type>;
+
+        async_context *ctx_;
+        Fn fn_;
+        std::optional<storage_type> value_;
+        std::exception_ptr error_;
+    };
+
+    /// Runs @p fn on a database thread of @p ctx when awaited.
+    template <typename Fn> async_operation<std::decay_t<Fn>> async_run(async_context &ctx, Fn &&fn) {
+        return async_operation<std::decay_t<Fn>>(ctx, std::forward<Fn>(fn));
+    }
+
+    /**
+     * @brief Awaitable pool lease that never parks a database thread.
+     *
+     * When the pool is exhausted the coroutine is queued on the pool and retried on a database
+     * thread of the context once a connection comes back, so lease holders can keep stepping
+     * their statements on the same threads. The queued waiter refers to the context, so the
+     * context must outlive every coroutine still waiting for a lease.
+     */
+    class async_lease_request {
+    public:
+        async_lease_request(async_context &ctx, connection_pool &pool) :
+            ctx_(&ctx), pool_(&pool) {}
+
+        bool await_ready() {
+            lease_ = pool_->try_acquire();
+            return static_cast<bool>(lease_);
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            handle_ = handle;
+            return !attempt();
+        }
+
+        connection_pool::lease await_resume() {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            return std::move(lease_);
+        }
+
+    private:
+        // Once the waiter is queued, a release may already retry and resume the coroutine on a
+        // database thread, so a failed attempt must not touch the request again.
+        bool attempt() {
+            auto lease = pool_->try_acquire([this] { ctx_->dispatch([this] { retry(); }); });
+            if (!lease) {
+                return false;
+            }
+            lease_ = std::move(lease);
+            return true;
+        }
+
+        void retry() {
+            try {
+                if (!attempt()) {
+                    return; // another caller took the connection; queued again
+                }
+            } catch (...) {
+                error_ = std::current_exception();
+            }
+            ctx_->resume(handle_);
+        }
+
+        async_context *ctx_;
+        connection_pool *pool_;
+        connection_pool::lease lease_;
+        std::coroutine_handle<> handle_;
+        std::exception_ptr error_;
+    };
+
+    /// `co_await async_acquire(ctx, pool)` waits for a lease without blocking the caller.
+    inline async_lease_request async_acquire(async_context &ctx, connection_pool &pool) {
+        return async_lease_request(ctx, pool);
+    }
+
+    /// `co_await async_step(ctx, cmd)` executes one step of @p cmd on a database thread.
+    inline auto async_step(async_context &ctx, command &cmd) {
+        return async_run(ctx, [&cmd] { return cmd.step_once(); });
+    }
+
+    /// Materializes every row of @p q on a database thread.
+    inline auto async_fetch_all(async_context &ctx, query &q) {
+        return async_run(ctx, [&q] { return materialize(q); });
+    }
+
+    /**
+     * @brief Row-at-a-time cursor whose `next_row()` is awaitable.
+     *
+     * @code
+     * sqlite::async_cursor rows(ctx, q);
+     * while (co_await rows.next_row()) {
+     *     use(rows->get<std::string>(0));
+     * }
+     * @endcode
+     *
+     * Only one `next_row()` may be in flight per cursor; @p q must outlive the cursor.
+     */
+    class async_cursor {
+    public:
+        async_cursor(async_context &ctx, query &q) : ctx_(&ctx), query_(&q) {}
+
+        auto next_row() {
+            return async_run(*ctx_, [this] {
+                if (!result_) {
+                    result_ = query_->get_result();
+                }
+                return result_->next_row();
+            });
+        }
+
+        /// The current row; valid after `next_row()` produced true.
+        result &row() const {
+            if (!result_) {
+                throw database_exception("async_cursor::next_row() has not been awaited yet.");
+            }
+            return *result_;
+        }
+
+        result *operator->() const {
+            return &row();
+        }
+
+    private:
+        async_context *ctx_;
+        query *query_;
+        result_type result_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_COROUTINE_HPP_INCLUDED
@@ -0,0 +1,73 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_CSV_TABLE_HPP_INCLUDED
+#define GUARD_SQLITE_CSV_TABLE_HPP_INCLUDED
+
+#include <string>
+
+/**
+ * @file sqlite/csv_table.hpp
+ * @brief Read-only virtual table that queries a memory-mapped CSV file in place.
+ *
+ * After `register_csv_module(con)` a file can be queried and joined without importing it:
+ * \code
+ * CREATE VIRTUAL TABLE temp.orders USING csv(filename = 'orders.csv', key = 'id');
+ * SELECT o.*, c.name FROM orders o JOIN customers c ON c.id = o.customer;
+ * \endcode
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /**
+     * @brief Registers the CSV virtual table module on @p con under @p name.
+     *
+     * Arguments, as `name = value` pairs:
+     *  - `filename` (required): the file is mapped read-only when the table is opened.
+     *  - `header` (default `yes`): take column names from the first record. Otherwise the
+     *    columns are named `c1`..`cN` after the first record.
+     *  - `delimiter` (default `,`): a single character.
+     *  - `key`: column answering `key = ?` through a hash index, built on the first such lookup.
+     *    Values are text without affinity, so `key = 42` matches nothing, exactly as a scan.
+     *
+     * The first scan records where each record starts; the rowid is the 1-based record number,
+     * and `rowid = ?` seeks directly. Values are text, NULL for an empty unquoted field or a
+     * missing trailing field. Text is handed to SQLite as `SQLITE_STATIC` pointers into the
+     * mapping, except quoted fields with doubled quotes, which are unescaped first. Key lookups
+     * compare the text of the probe value. The file must not change while the table is open.
+     */
+    void register_csv_module(connection &con, std::string const &name = "csv");
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_CSV_TABLE_HPP_INCLUDED
@@ -0,0 +1,177 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_EXECUTOR_HPP_INCLUDED
+#define GUARD_SQLITE_EXECUTOR_HPP_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/ext/variant.hpp>
+#include <sqlite/query.hpp>
+
+/**
+ * @file sqlite/executor.hpp
+ * @brief Asynchronous query execution on a fixed set of thread-pinned reader connections.
+ *
+ * `sqlite::executor` owns one connection per worker thread. Jobs are queued on the worker with the
+ * fewest outstanding jobs, and idle workers steal from the back of busier queues. Because every
+ * connection stays on its own thread, each worker's statement cache stays warm for the SQL it
+ * runs.
+ */
+namespace sqlite {
+inline namespace v2 {
+
+    /// Fully materialized result set produced by @ref executor::submit.
+    struct materialized_rows {
+        std::vector<std::string> columns;
+        std::vector<std::vector<variant_t>> rows;
+    };
+
+    /// Steps @p q to completion and copies every row into a @ref materialized_rows.
+    materialized_rows materialize(query &q);
+
+    namespace detail {
+        /// Arguments are copied into the job; borrowed strings are turned into owned ones.
+        template <typename T>
+        using owned_argument_t =
+            std::conditional_t<std::is_convertible_v<decay_t<T>, std::string_view> &&
+                                   !std::is_same_v<decay_t<T>, std::string>,
+                               std::string, decay_t<T>>;
+    } // namespace detail
+
+    /// Runs queries and closures on worker threads that each own a reader connection.
+    class executor {
+    public:
+        using job = std::function<void(connection &)>;
+
+        /**
+         * @brief Starts @p workers threads, each with a connection created by @p factory.
+         *
+         * @throws database_exception when @p workers is zero or the factory fails.
+         */
+        executor(std::size_t workers, connection_pool::connection_factory factory);
+
+        /// Finishes every queued job, then joins the worker threads.
+        ~executor();
+
+        executor(executor const &)            = delete;
+        executor &operator=(executor const &) = delete;
+
+        /**
+         * @brief Runs @p fn with a worker's connection and returns its result through a future.
+         *
+         * Exceptions thrown by @p fn are stored in the future.
+         */
+        template <typename Fn>
+        auto post(Fn &&fn) -> std::future<std::invoke_result_t<std::decay_t<Fn> &, connection &>> {
+            using result_t = std::invoke_result_t<std::decay_t<Fn> &, connection &>;
+            auto task =
+                std::make_shared<std::packaged_task<result_t(connection &)>>(std::forward<Fn>(fn));
+            auto future = task->get_future();
+            enqueue([task](connection &con) { (*task)(con); });
+            return future;
+        }
+
+        /**
+         * @brief Prepares @p sql on a worker, binds @p args positionally and materializes every
+         * row.
+         */
+        template <typename... Args>
+        std::future<materialized_rows> submit(std::string sql, Args &&...args) {
+            return post(make_query_job(std::move(sql), std::forward<Args>(args)...));
+        }
+
+        /**
+         * @brief Like @ref submit, but hands the rows (or the failure) to @p callback on the
+         * worker thread instead of returning a future.
+         */
+        template <typename Callback, typename... Args>
+        void submit_callback(Callback &&callback, std::string sql, Args &&...args) {
+            enqueue([callback = std::forward<Callback>(callback),
+                     run = make_query_job(std::move(sql), std::forward<Args>(args)...)](
+                        connection &con) mutable {
+                materialized_rows rows;
+                std::exception_ptr error;
+                try {
+                    rows = run(con);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                callback(std::move(rows), error);
+            });
+        }
+
+        /// Number of worker threads (and reader connections).
+        std::size_t worker_count() const noexcept;
+
+        /// Jobs queued or running across all workers.
+        std::size_t pending() const noexcept;
+
+        /// Jobs that were executed by a worker other than the one they were queued on.
+        std::size_t steal_count() const noexcept;
+
+    private:
+        struct worker;
+
+        template <typename... Args> static auto make_query_job(std::string sql, Args &&...args) {
+            return [sql    = std::move(sql),
+                    params = std::tuple<detail::owned_argument_t<Args>...>(
+                        std::forward<Args>(args)...)](connection &con) mutable {
+                query q(con, sql);
+                std::apply([&q](auto &...value) { ((void)(q % value), ...); }, params);
+                return materialize(q);
+            };
+        }
+
+        void enqueue(job fn);
+        void run(std::size_t index);
+        bool try_steal(std::size_t thief, job &out);
+
+        std::vector<std::unique_ptr<worker>> workers_;
+        std::atomic<std::size_t> steals_{0};
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_EXECUTOR_HPP_INCLUDED
@@ -40,6 +40,7 @@
 #include <functional>
 #include <limits>
 #include <memory>
+#include <new>
 #include <optional>
 #include <span>
 #include <string>
@@ -480,6 +481,223 @@ inline namespace v2 {
         holder.release();
     }
 
+    namespace detail {
+        template <typename Step, typename Final, typename Value = std::nullptr_t,
+                  typename Inverse = std::nullptr_t>
+        struct aggregate_holder {
+            Step step;
+            Final final;
+            Value value;
+            Inverse inverse;
+        };
+
+        /// Per-group state inside `sqlite3_aggregate_context`, which SQLite zero-fills.
+        template <typename State> struct aggregate_slot {
+            alignas(State) unsigned char storage[sizeof(State)];
+            bool constructed;
+
+            State &get() noexcept {
+                return *std::launder(reinterpret_cast<State *>(storage));
+            }
+        };
+
+        template <typename Body> void guard_aggregate(sqlite3_context *ctx, Body &&body) {
+            try {
+                body();
+            } catch (std::exception const &ex) {
+                sqlite3_result_error(ctx, ex.what(), -1);
+            } catch (...) {
+                sqlite3_result_error(ctx, "Unhandled exception in SQL aggregate.", -1);
+            }
+        }
+
+        template <typename Callable, typename State, std::size_t... Index>
+        void invoke_with_state(Callable &callable, State &state, sqlite3_value **argv,
+                               std::index_sequence<Index...>) {
+            using traits = callable_traits<Callable>;
+            std::invoke(
+                callable, state,
+                argument_converter<decay_t<typename traits::template argument<Index + 1>>>::convert(
+                    argv[Index])...);
+        }
+
+        template <typename Callable, typename State>
+        void write_state_result(sqlite3_context *ctx, Callable &callable, State &state) {
+            using result_t = typename callable_traits<Callable>::return_type;
+            if constexpr (std::is_void_v<result_t>) {
+                std::invoke(callable, state);
+                sqlite3_result_null(ctx);
+            } else {
+                result_writer<decay_t<result_t>>::apply(ctx, std::invoke(callable, state));
+            }
+        }
+
+        /// Shared body of xStep and xInverse: constructs the state on first use, then feeds it.
+        template <typename State, typename Callable>
+        void accumulate(sqlite3_context *ctx, Callable &callable, int argc, sqlite3_value **argv) {
+            constexpr std::size_t arity = callable_traits<Callable>::arity - 1;
+            if (argc != static_cast<int>(arity)) {
+                sqlite3_result_error(ctx, "Unexpected number of arguments for SQL aggregate.", -1);
+                return;
+            }
+            auto *slot = static_cast<aggregate_slot<State> *>(
+                sqlite3_aggregate_context(ctx, static_cast<int>(sizeof(aggregate_slot<State>))));
+            if (!slot) {
+                sqlite3_result_error_nomem(ctx);
+                return;
+            }
+            guard_aggregate(ctx, [&] {
+                if (!slot->constructed) {
+                    ::new (static_cast<void *>(slot->storage)) State();
+                    slot->constructed = true;
+                }
+                invoke_with_state(callable, slot->get(), argv, std::make_index_sequence<arity>{});
+            });
+        }
+
+        /// Shared body of xValue and xFinal; groups without rows see a default-constructed state.
+        template <typename State, typename Callable>
+        void report(sqlite3_context *ctx, Callable &callable, bool release) {
+            auto *slot = static_cast<aggregate_slot<State> *>(sqlite3_aggregate_context(ctx, 0));
+            if (!slot || !slot->constructed) {
+                guard_aggregate(ctx, [&] {
+                    State empty{};
+                    write_state_result(ctx, callable, empty);
+                });
+                return;
+            }
+            guard_aggregate(ctx, [&] { write_state_result(ctx, callable, slot->get()); });
+            if (release) {
+                slot->get().~State();
+                slot->constructed = false;
+            }
+        }
+
+        template <typename State, typename Holder>
+        void aggregate_step(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+            auto *holder = static_cast<Holder *>(sqlite3_user_data(ctx));
+            accumulate<State>(ctx, holder->step, argc, argv);
+        }
+
+        template <typename State, typename Holder>
+        void aggregate_inverse(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+            auto *holder = static_cast<Holder *>(sqlite3_user_data(ctx));
+            accumulate<State>(ctx, holder->inverse, argc, argv);
+        }
+
+        template <typename State, typename Holder> void aggregate_value(sqlite3_context *ctx) {
+            report<State>(ctx, static_cast<Holder *>(sqlite3_user_data(ctx))->value, false);
+        }
+
+        template <typename State, typename Holder> void aggregate_final(sqlite3_context *ctx) {
+            report<State>(ctx, static_cast<Holder *>(sqlite3_user_data(ctx))->final, true);
+        }
+
+        template <typename Holder> void destroy_aggregate_holder(void *data) {
+            delete static_cast<Holder *>(data);
+        }
+
+        template <typename State, typename Step>
+        int aggregate_arity(function_options const &options) {
+            using traits = callable_traits<Step>;
+            static_assert(std::default_initializable<State>,
+                          "Aggregate state must be default constructible.");
+            static_assert(alignof(State) <= 8,
+                          "sqlite3_aggregate_context only guarantees 8-byte alignment.");
+            static_assert(traits::arity >= 1 &&
+                              std::is_same_v<typename traits::template argument<0>, State &>,
+                          "The step callable must take State & as its first parameter.");
+            static_assert(traits::arity - 1 <=
+                              static_cast<std::size_t>(std::numeric_limits<int>::max()),
+                          "SQL functions cannot expose more than INT_MAX parameters.");
+            constexpr auto max_arity = static_cast<int>(traits::arity - 1);
+            if (options.arity >= 0 && options.arity != max_arity) {
+                throw database_exception(
+                    "Explicit arity override does not match callable signature.");
+            }
+            return max_arity;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Registers an aggregate whose per-group @p State lives inside SQLite's aggregate
+     * context.
+     *
+     * @p step is called as `step(State &, args...)` for every row, with arguments converted like
+     * those of @ref create_function. @p final is called as `final(State &)` once per group and
+     * its result becomes the aggregate's value. The state is default constructed in place on
+     * the group's first row and destroyed after @p final, so no heap allocation is made per
+     * group. Empty groups pass a default-constructed state to @p final.
+     */
+    template <typename State, typename Step, typename Final>
+    void create_aggregate(connection &con, std::string_view name, Step &&step, Final &&final,
+                          function_options options = {}) {
+        using holder_t = detail::aggregate_holder<std::decay_t<Step>, std::decay_t<Final>>;
+        static_assert(std::is_invocable_v<std::decay_t<Final> &, State &>,
+                      "The final callable must accept State &.");
+        int arity   = detail::aggregate_arity<State, std::decay_t<Step>>(options);
+        auto holder = std::make_unique<holder_t>(
+            holder_t{std::forward<Step>(step), std::forward<Final>(final), nullptr, nullptr});
+
+        private_accessor::acccess_check(con);
+        auto handle = private_accessor::get_handle(con);
+        std::string name_buffer(name);
+        // SQLite owns the holder from here on and destroys it even if registration fails.
+        int rc = sqlite3_create_function_v2(
+            handle, name_buffer.c_str(), arity, detail::compose_text_rep(options), holder.release(),
+            nullptr, &detail::aggregate_step<State, holder_t>,
+            &detail::aggregate_final<State, holder_t>, &detail::destroy_aggregate_holder<holder_t>);
+        if (rc != SQLITE_OK) {
+            auto err = sqlite3_errmsg(handle);
+            throw database_exception_code(err ? err : detail::make_function_error(name), rc);
+        }
+    }
+
+    /**
+     * @brief Registers an aggregate window function (`sqlite3_create_window_function`).
+     *
+     * In addition to the @ref create_aggregate callables, @p value reports the current result
+     * without ending the group, and @p inverse takes the same arguments as @p step and removes
+     * a row that has left the window frame. The function also works as a plain aggregate.
+     */
+    template <typename State, typename Step, typename Final, typename Value, typename Inverse>
+    void create_window_function(connection &con, std::string_view name, Step &&step,
+                                Final &&final, Value &&value, Inverse &&inverse,
+                                function_options options = {}) {
+        using holder_t = detail::aggregate_holder<std::decay_t<Step>, std::decay_t<Final>,
+                                                  std::decay_t<Value>, std::decay_t<Inverse>>;
+        static_assert(std::is_invocable_v<std::decay_t<Final> &, State &> &&
+                          std::is_invocable_v<std::decay_t<Value> &, State &>,
+                      "The final and value callables must accept State &.");
+        static_assert(std::is_same_v<
+                          typename detail::callable_traits<std::decay_t<Step>>::arguments_tuple,
+                          typename detail::callable_traits<std::decay_t<Inverse>>::arguments_tuple>,
+                      "The inverse callable must take the same parameters as the step callable.");
+        int arity   = detail::aggregate_arity<State, std::decay_t<Step>>(options);
+        auto holder = std::make_unique<holder_t>(
+            holder_t{std::forward<Step>(step), std::forward<Final>(final),
+                     std::forward<Value>(value), std::forward<Inverse>(inverse)});
+
+        private_accessor::acccess_check(con);
+        auto handle = private_accessor::get_handle(con);
+#if SQLITE_VERSION_NUMBER >= 3025000
+        std::string name_buffer(name);
+        int rc = sqlite3_create_window_function(
+            handle, name_buffer.c_str(), arity, detail::compose_text_rep(options), holder.release(),
+            &detail::aggregate_step<State, holder_t>, &detail::aggregate_final<State, holder_t>,
+            &detail::aggregate_value<State, holder_t>, &detail::aggregate_inverse<State, holder_t>,
+            &detail::destroy_aggregate_holder<holder_t>);
+        if (rc != SQLITE_OK) {
+            auto err = sqlite3_errmsg(handle);
+            throw database_exception_code(err ? err : detail::make_function_error(name), rc);
+        }
+#else
+        (void)handle;
+        (void)arity;
+        throw database_exception("Window functions require SQLite 3.25 or newer.");
+#endif
+    }
+
 } // namespace v2
 } // namespace sqlite
 
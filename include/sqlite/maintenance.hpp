@@ -0,0 +1,148 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_MAINTENANCE_HPP_INCLUDED
+#define GUARD_SQLITE_MAINTENANCE_HPP_INCLUDED
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/**
+ * @file sqlite/maintenance.hpp
+ * @brief Idle-time housekeeping (`PRAGMA optimize`, incremental vacuum, checkpoints) for pools.
+ *
+ * `sqlite::maintenance_scheduler` watches the utilization of a @ref connection_pool and, once the
+ * pool has been quiet for a while, leases a connection to run rate-limited maintenance tasks.
+ * Every task runs under a time budget and never waits for the write lock, so it cannot stall
+ * online traffic for long.
+ */
+namespace sqlite {
+inline namespace v2 {
+    class connection_pool;
+
+    /// Individual housekeeping jobs the scheduler knows how to run.
+    enum class maintenance_task {
+        optimize,           ///< `PRAGMA optimize` bounded by `analysis_limit`.
+        incremental_vacuum, ///< `PRAGMA incremental_vacuum(N)` in short chunks.
+        checkpoint          ///< PASSIVE `wal_checkpoint` (no-op outside WAL mode).
+    };
+
+    /// Scheduling, rate limits and budgets used by @ref maintenance_scheduler.
+    struct maintenance_options {
+        std::chrono::milliseconds poll_interval{1000}; ///< How often utilization is sampled.
+        std::chrono::milliseconds idle_window{5000};   ///< Quiet period before tasks may run.
+        double idle_utilization = 0.25; ///< Max leased/capacity ratio that still counts as idle.
+        std::chrono::milliseconds task_budget{50}; ///< Wall-clock budget per task run.
+
+        bool optimize      = true;
+        int analysis_limit = 400; ///< Rows sampled per index by ANALYZE (0 = unlimited).
+        std::chrono::milliseconds optimize_every{std::chrono::hours(1)};
+
+        int vacuum_pages_per_step = 64; ///< Pages freed per incremental_vacuum call (0 = off).
+        std::chrono::milliseconds vacuum_every{std::chrono::minutes(10)};
+
+        bool checkpoint = true;
+        std::chrono::milliseconds checkpoint_every{std::chrono::minutes(1)};
+    };
+
+    /// Counters reported by @ref maintenance_scheduler::stats.
+    struct maintenance_stats {
+        std::uint64_t optimize_runs   = 0;
+        std::uint64_t vacuum_runs     = 0;
+        std::uint64_t checkpoint_runs = 0;
+        std::uint64_t pages_vacuumed  = 0;
+        std::uint64_t skipped_busy    = 0; ///< Runs abandoned because the database was locked.
+        std::uint64_t interrupted     = 0; ///< Runs stopped by the time budget.
+        std::uint64_t failures        = 0; ///< Runs that raised any other error.
+        std::chrono::microseconds last_duration{0};
+        std::chrono::microseconds max_duration{0};
+    };
+
+    /**
+     * @brief Background thread that runs maintenance on a pooled connection during idle windows.
+     *
+     * The pool counts as idle while `leased / capacity <= idle_utilization`; tasks only start once
+     * that has held for `idle_window`, at most one task per poll, each no more often than its
+     * `*_every` interval. During a task the connection's busy timeout is set to zero and a
+     * progress handler aborts statements that exceed `task_budget`. The busy timeout is restored
+     * afterwards. The progress handler is cleared instead: SQLite cannot report the current one,
+     * so the scheduler owns that slot on pooled connections and any handler installed there is
+     * lost after the next task. The pool must outlive the scheduler.
+     */
+    class maintenance_scheduler {
+    public:
+        explicit maintenance_scheduler(connection_pool &pool, maintenance_options options = {});
+        ~maintenance_scheduler();
+
+        maintenance_scheduler(maintenance_scheduler const &)            = delete;
+        maintenance_scheduler &operator=(maintenance_scheduler const &) = delete;
+
+        /**
+         * @brief Runs @p task immediately on the calling thread, ignoring idle detection and
+         * rate limits but honouring the time budget.
+         *
+         * @returns true when the task completed, false when it was skipped (no connection
+         * available or the database was busy) or interrupted by the budget.
+         */
+        bool run_now(maintenance_task task);
+
+        /// Snapshot of the counters collected so far.
+        maintenance_stats stats() const;
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        void run();
+        bool pool_is_idle() const;
+        bool execute_task(maintenance_task task);
+
+        connection_pool &pool_;
+        maintenance_options options_;
+        clock::time_point last_optimize_{};
+        clock::time_point last_vacuum_{};
+        clock::time_point last_checkpoint_{};
+
+        mutable std::mutex stats_mutex_;
+        maintenance_stats stats_;
+
+        std::mutex wake_mutex_;
+        std::condition_variable wake_;
+        bool stop_ = false;
+        std::thread worker_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_MAINTENANCE_HPP_INCLUDED
@@ -0,0 +1,131 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_MATERIALIZED_VIEW_HPP_INCLUDED
+#define GUARD_SQLITE_MATERIALIZED_VIEW_HPP_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file sqlite/materialized_view.hpp
+ * @brief Views whose results are stored in a real table and kept up to date.
+ *
+ * Where `sqlite::view` recomputes its query on every read, `sqlite::materialized_view` stores
+ * the result in a table. Simple COUNT/SUM ... GROUP BY shapes are maintained row by row through
+ * generated triggers; arbitrary queries are refreshed on demand and report how stale they are.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    enum class aggregate_kind { count, sum };
+
+    /// One output column of an @ref aggregate_view_definition.
+    struct view_aggregate {
+        aggregate_kind kind = aggregate_kind::count;
+        std::string column; ///< Source column; empty with `count` means COUNT(*)
+        std::string alias;  ///< Output column name
+    };
+
+    /**
+     * @brief `SELECT group_by..., aggregates... FROM source GROUP BY group_by...`
+     *
+     * Group keys and aggregate arguments are plain column names of @c source, which keeps the
+     * shape maintainable by triggers. SUM over no non-NULL values yields 0, like TOTAL().
+     */
+    struct aggregate_view_definition {
+        std::string source;
+        std::vector<std::string> group_by;
+        std::vector<view_aggregate> aggregates;
+    };
+
+    /// How far a materialized view trails its sources.
+    struct view_staleness {
+        bool stale                   = false;
+        std::int64_t pending_changes = 0; ///< Source rows changed since the last refresh.
+        std::chrono::seconds since_refresh{0};
+    };
+
+    /**
+     * @brief A table holding the result of a query, registered in `vsqlite_materialized_views`.
+     *
+     * Aggregate views get AFTER INSERT/UPDATE/DELETE triggers on their source that apply each row
+     * change to the affected group, plus a hidden `__rows` column counting the group's source
+     * rows; groups reaching zero rows are removed. Views over arbitrary SELECT statements get
+     * triggers that only count changes, and refresh() recomputes them. Triggers are persistent,
+     * so writes through any connection are tracked. Sources must live in the main schema.
+     */
+    class materialized_view {
+    public:
+        /// Opens a view created earlier; throws when @p name is not registered.
+        materialized_view(connection &con, std::string_view name);
+
+        /// Creates and populates a trigger-maintained aggregate view.
+        static materialized_view create(connection &con, std::string_view name,
+                                        aggregate_view_definition const &definition);
+
+        /// Creates and populates a view over @p select_sql that is brought up to date by refresh().
+        static materialized_view create(connection &con, std::string_view name,
+                                        std::string_view select_sql);
+
+        std::string const &name() const noexcept {
+            return name_;
+        }
+
+        /// True when triggers keep the stored rows current.
+        bool incremental() const noexcept {
+            return incremental_;
+        }
+
+        /// Recomputes the stored rows from scratch in one savepoint.
+        void refresh();
+
+        view_staleness staleness();
+
+        /// Drops the table, its triggers and the registration.
+        void drop();
+
+    private:
+        materialized_view(connection &con, std::string name, bool incremental);
+
+        connection *con_;
+        std::string name_;
+        bool incremental_ = false;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_MATERIALIZED_VIEW_HPP_INCLUDED
@@ -0,0 +1,236 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_PAGED_QUERY_HPP_INCLUDED
+#define GUARD_SQLITE_PAGED_QUERY_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <sqlite/query.hpp>
+#include <sqlite/typed_rows.hpp>
+
+struct sqlite3_stmt;
+
+/**
+ * @file sqlite/paged_query.hpp
+ * @brief Keyset pagination over an ordered unique key instead of LIMIT/OFFSET.
+ *
+ * `sqlite::paged_query` seeks past the last key it returned with a row-value predicate, so every
+ * page costs one index seek plus the page itself no matter how deep it is. Positions can be
+ * handed to clients as opaque continuation tokens.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Page size and direction used by @ref paged_query.
+    struct paged_query_options {
+        std::size_t page_size = 100;
+        bool descending       = false; ///< Walk the key from the largest value down.
+    };
+
+    /**
+     * @brief Pages through `base_sql` ordered by @c keys.
+     *
+     * @c base_sql is a SELECT without ORDER BY or LIMIT; the keys must be output column names
+     * that together are unique and NOT NULL. Pages are generated as
+     * `SELECT *, keys... FROM (base_sql) WHERE (keys...) > (last...) ORDER BY keys... LIMIT n`
+     * from two statements prepared once, and the last key read is remembered. Parameters of the
+     * base query are bound with @ref bind and re-applied to every page.
+     */
+    class paged_query {
+        struct key_value {
+            int type = 0; ///< SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL
+            std::int64_t integer = 0;
+            double real          = 0.0;
+            std::string bytes;
+        };
+
+    public:
+        /// Columns of the current row of a page; valid until the page advances.
+        class row {
+        public:
+            /// Number of columns produced by the base query.
+            int column_count() const noexcept {
+                return columns_;
+            }
+
+            template <typename T> T get(int column) const {
+                if (column < 0 || column >= columns_) {
+                    detail::throw_column_count_mismatch();
+                }
+                return detail::read_column<T>(stmt_, column);
+            }
+
+            /// The first `sizeof...(Ts)` columns as a tuple.
+            template <typename... Ts> std::tuple<Ts...> as() const {
+                if (static_cast<int>(sizeof...(Ts)) > columns_) {
+                    detail::throw_column_count_mismatch();
+                }
+                return [this]<std::size_t... I>(std::index_sequence<I...>) {
+                    return std::tuple<Ts...>(
+                        detail::read_column<Ts>(stmt_, static_cast<int>(I))...);
+                }(std::index_sequence_for<Ts...>{});
+            }
+
+        private:
+            friend class paged_query;
+            row(sqlite3_stmt *stmt, int columns) noexcept : stmt_(stmt), columns_(columns) {}
+            sqlite3_stmt *stmt_ = nullptr;
+            int columns_        = 0;
+        };
+
+        /// Input range over one page; rows are stepped lazily as the range is iterated.
+        class page {
+        public:
+            struct sentinel {};
+
+            class iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = row;
+                using difference_type   = std::ptrdiff_t;
+
+                iterator() = default;
+
+                row operator*() const {
+                    return owner_->current_row();
+                }
+
+                iterator &operator++() {
+                    valid_ = owner_->advance();
+                    return *this;
+                }
+
+                void operator++(int) {
+                    ++*this;
+                }
+
+                friend bool operator==(iterator const &it, sentinel) noexcept {
+                    return !it.valid_;
+                }
+
+            private:
+                friend class page;
+                explicit iterator(paged_query *owner) : owner_(owner), valid_(owner->advance()) {}
+                paged_query *owner_ = nullptr;
+                bool valid_         = false;
+            };
+
+            /// Starts stepping; a page can be iterated once.
+            iterator begin() {
+                return iterator(owner_);
+            }
+
+            sentinel end() const noexcept {
+                return {};
+            }
+
+        private:
+            friend class paged_query;
+            explicit page(paged_query *owner) noexcept : owner_(owner) {}
+            paged_query *owner_;
+        };
+
+        paged_query(connection &con, std::string_view base_sql, std::vector<std::string> keys,
+                    paged_query_options options = {});
+        ~paged_query();
+
+        paged_query(paged_query const &)            = delete;
+        paged_query &operator=(paged_query const &) = delete;
+
+        /// Stores @p args (by value) as the parameters of the base query.
+        template <typename... Args> paged_query &bind(Args &&...args) {
+            binder_ = [... values = std::forward<Args>(args)](query &q) {
+                (void)(q % ... % values);
+            };
+            return *this;
+        }
+
+        /**
+         * @brief Starts the page after the last key read so far.
+         *
+         * Any page still being iterated ends; stopping early resumes after the last row
+         * actually read.
+         */
+        page next();
+
+        /// True once a page came back shorter than the page size.
+        bool done() const noexcept {
+            return exhausted_;
+        }
+
+        /// Opaque token for the current position; empty before the first row.
+        std::string token() const;
+
+        /// Continues from a token produced by an identical paged_query; empty restarts.
+        void resume(std::string_view token);
+
+        /// Goes back to the first page.
+        void rewind();
+
+    private:
+        bool advance();
+        row current_row() const;
+        void finish_page();
+        void bind_key(query &q);
+        std::uint64_t fingerprint() const;
+
+        connection &con_;
+        std::vector<std::string> keys_;
+        paged_query_options options_;
+        std::string first_sql_;
+        std::string seek_sql_;
+        std::unique_ptr<query> first_;
+        std::unique_ptr<query> seek_;
+        std::function<void(query &)> binder_;
+
+        std::vector<key_value> last_key_;
+        query *current_     = nullptr;
+        sqlite3_stmt *stmt_ = nullptr;
+        int data_columns_   = 0;
+        std::size_t rows_   = 0;
+        bool exhausted_     = false;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_PAGED_QUERY_HPP_INCLUDED
@@ -0,0 +1,200 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_PARALLEL_SCAN_HPP_INCLUDED
+#define GUARD_SQLITE_PARALLEL_SCAN_HPP_INCLUDED
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/snapshot.hpp>
+#include <sqlite/transaction.hpp>
+
+/**
+ * @file sqlite/parallel_scan.hpp
+ * @brief Split a table scan by key range and run the pieces on pooled connections in parallel.
+ *
+ * `sqlite::parallel_scan` leases one connection per partition, pins all of them to a common WAL
+ * snapshot when possible, runs a caller-supplied function per key range and folds the partial
+ * results with a reducer.
+ */
+namespace sqlite {
+inline namespace v2 {
+    /// How partition boundaries are chosen.
+    enum class partition_strategy {
+        /// Split `[MIN(key), MAX(key)]` into equally wide ranges; cheap, assumes dense keys.
+        uniform,
+        /// Pick boundaries at row quantiles (row count from `sqlite_stat1` or `COUNT(*)`); handles
+        /// skewed keys at the cost of one indexed OFFSET probe per boundary.
+        quantiles
+    };
+
+    struct scan_options {
+        std::size_t partitions = 0;   ///< 0 uses the pool capacity; clamped to it
+        std::string columns    = "*"; ///< Select list of the per-partition query
+        std::string where;            ///< Optional extra predicate, ANDed to the key range
+        partition_strategy strategy = partition_strategy::uniform;
+        /// Throw instead of scanning unpinned when no common snapshot can be established
+        /// (snapshot API unavailable or the database is not in WAL mode).
+        bool require_snapshot = false;
+    };
+
+    /// Inclusive key range handled by one partition.
+    struct scan_partition {
+        std::size_t index = 0;
+        std::int64_t lower = 0;
+        std::int64_t upper = 0;
+    };
+
+    /**
+     * @brief Computes up to @p partitions non-overlapping inclusive key ranges covering
+     * @p key_column of @p table. Returns an empty vector for an empty table. NULL keys are not
+     * covered.
+     */
+    std::vector<scan_partition> plan_partitions(connection &con, std::string_view table,
+                                                std::string_view key_column,
+                                                std::size_t partitions,
+                                                partition_strategy strategy =
+                                                    partition_strategy::uniform);
+
+    namespace detail {
+        std::string partition_sql(std::string_view table, std::string_view key_column,
+                                  scan_options const &options);
+
+        /// Takes a snapshot on @p con (which must be inside a read transaction) if possible.
+        snapshot try_pin_snapshot(connection &con, bool required);
+    } // namespace detail
+
+    /**
+     * @brief Runs @p fn over key-range partitions of @p table in parallel and reduces the results.
+     *
+     * Every partition gets its own leased connection and a prepared
+     * `SELECT <columns> FROM <table> WHERE <key> BETWEEN ?1 AND ?2 [AND (<where>)]` with the
+     * bounds bound; `fn(query &, scan_partition const &)` consumes it and returns a partial
+     * result; it runs concurrently on several threads. Partials are folded in partition order
+     * as `acc = reduce(std::move(acc), partial)`.
+     *
+     * The first connection plans the partitions inside a read transaction and, in WAL mode with
+     * snapshot support, captures a snapshot that every other partition opens before reading, so
+     * the combined result reflects a single point in time. The key column must hold integers
+     * (rowid or an indexed INTEGER column); rows whose key is NULL fall in no range and are
+     * skipped.
+     *
+     * All partitions lease from @p pool at once and wait for free connections, so calling this
+     * while the calling thread holds a lease from the same pool can deadlock.
+     */
+    template <typename Result, typename Fn, typename Reduce>
+    Result parallel_scan(connection_pool &pool, std::string_view table,
+                         std::string_view key_column, Fn &&fn, Reduce &&reduce, Result init,
+                         scan_options const &options = {}) {
+        std::size_t wanted = options.partitions == 0 ? pool.capacity() : options.partitions;
+        wanted             = std::max<std::size_t>(1, std::min(wanted, pool.capacity()));
+
+        auto planner = pool.acquire();
+        transaction pin(*planner, transaction_type::deferred);
+        auto partitions = plan_partitions(*planner, table, key_column, wanted, options.strategy);
+        if (partitions.empty()) {
+            pin.commit();
+            return init;
+        }
+        snapshot snap = detail::try_pin_snapshot(*planner, options.require_snapshot);
+
+        std::vector<connection_pool::lease> leases;
+        leases.reserve(partitions.size() - 1);
+        for (std::size_t i = 1; i < partitions.size(); ++i) {
+            leases.push_back(pool.acquire());
+        }
+
+        std::string sql = detail::partition_sql(table, key_column, options);
+        auto run = [&](connection &con, scan_partition const &part) {
+            query q(con, sql);
+            q % part.lower % part.upper;
+            return fn(q, part);
+        };
+
+        using partial_type = decltype(run(*planner, partitions.front()));
+        std::vector<std::future<partial_type>> futures;
+        futures.reserve(leases.size());
+        for (std::size_t i = 0; i < leases.size(); ++i) {
+            futures.push_back(std::async(std::launch::async, [&, i] {
+                connection &con = *leases[i];
+                transaction tx(con, transaction_type::deferred);
+                if (snap) {
+                    snap.open(con);
+                }
+                auto partial = run(con, partitions[i + 1]);
+                tx.commit();
+                return partial;
+            }));
+        }
+
+        std::exception_ptr error;
+        std::vector<partial_type> partials;
+        partials.reserve(partitions.size());
+        try {
+            partials.push_back(run(*planner, partitions.front()));
+        } catch (...) {
+            error = std::current_exception();
+        }
+        for (auto &future : futures) {
+            try {
+                partials.push_back(future.get());
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        pin.commit();
+
+        Result acc = std::move(init);
+        for (auto &partial : partials) {
+            acc = reduce(std::move(acc), std::move(partial));
+        }
+        return acc;
+    }
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_PARALLEL_SCAN_HPP_INCLUDED
@@ -36,6 +36,8 @@ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
 
 namespace sqlite {
 inline namespace v2 {
+    struct query;
+
     /** \brief A internal used class, shall not be used from users
      *
      */
@@ -56,6 +58,11 @@ inline namespace v2 {
         static void clear_statement_cache(connection &con) {
             con.clear_statement_cache();
         }
+        static detail::change_hooks &change_hooks(connection &con) {
+            return con.change_hooks();
+        }
+        /// The prepared statement of @p q, after the same check its own accessors run.
+        static sqlite3_stmt *get_statement(query &q);
     };
 } // namespace v2
 } // namespace sqlite
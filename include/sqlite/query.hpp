@@ -43,6 +43,8 @@
 #include <memory>
 #include <sqlite/command.hpp>
 #include <sqlite/result.hpp>
+#include <sqlite/struct_mapping.hpp>
+#include <sqlite/typed_rows.hpp>
 
 /**
  * @file sqlite/query.hpp
@@ -54,7 +56,6 @@
  */
 namespace sqlite {
 inline namespace v2 {
-
     /** \brief query should be used to execute SQL queries
      * An object of this class is not copyable
      */
@@ -177,8 +178,38 @@ inline namespace v2 {
             return each();
         }
 
+        /** \brief Streams rows as typed tuples straight from the statement.
+         *
+         * Lean alternative to each(): no result object, std::function or column cache is
+         * created, columns are read with direct <code>sqlite3_column_*</code> calls and nothing
+         * is allocated per query or per row (unless a column type such as std::string owns its
+         * data). Conversions follow result::get.
+         * \code
+         * for (auto [id, name] : q.rows<std::int64_t, std::string_view>()) { ... }
+         * \endcode
+         * Any supplied arguments are bound first, like each(args...).
+         */
+        template <typename... Ts, typename... Args> typed_rows<Ts...> rows(Args &&...args) {
+            ((void)(*this % std::forward<Args>(args)), ...);
+            access_check();
+            return typed_rows<Ts...>(stmt);
+        }
+
+        /** \brief Streams rows as instances of \a T, column i filling mapped field i.
+         *
+         * \a T is a struct described with VSQLITE_FIELDS or a plain aggregate. Fields are read
+         * positionally through direct column accessors like rows(); pair it with
+         * struct_sql<T>::select to keep the column order in sync. Arguments are bound first.
+         */
+        template <mappable_struct T, typename... Args> struct_rows<T> as(Args &&...args) {
+            ((void)(*this % std::forward<Args>(args)), ...);
+            access_check();
+            return struct_rows<T>(stmt);
+        }
+
     private:
         friend struct result;
+        friend struct private_accessor;
         void access_check();
         bool step();
     };
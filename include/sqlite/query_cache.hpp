@@ -0,0 +1,220 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_QUERY_CACHE_HPP_INCLUDED
+#define GUARD_SQLITE_QUERY_CACHE_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <sqlite/command.hpp>
+#include <sqlite/detail/type_helpers.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/rowset.hpp>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/**
+ * @file sqlite/query_cache.hpp
+ * @brief Opt-in cache of materialized query results with table-level invalidation.
+ *
+ * `sqlite::query_cache` keys results by SQL text plus bound parameters and keeps them as
+ * `sqlite::rowset` objects under a memory budget, so repeated reads between writes cost a hash
+ * lookup instead of a statement execution.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Limits applied by @ref query_cache.
+    struct query_cache_options {
+        std::size_t memory_budget = 16 * 1024 * 1024; ///< Bytes of cached rowsets before eviction.
+        std::size_t max_entries   = 4096;             ///< Cached results before eviction.
+        bool check_data_version   = true; ///< Detect commits by other connections on every lookup.
+    };
+
+    /// Counters reported by @ref query_cache::stats.
+    struct query_cache_stats {
+        std::uint64_t hits          = 0;
+        std::uint64_t misses        = 0;
+        std::uint64_t bypassed      = 0; ///< Uncached reads: uncommitted changes, virtual tables.
+        std::uint64_t invalidations = 0; ///< Entries dropped because their tables changed.
+        std::uint64_t evictions     = 0; ///< Entries dropped to stay within the limits.
+        std::size_t entries         = 0;
+        std::size_t memory_usage    = 0; ///< Bytes currently held by cached rowsets.
+    };
+
+    namespace detail {
+        inline void append_cache_key_bytes(std::string &key, char tag, void const *data,
+                                           std::size_t size) {
+            key.push_back(tag);
+            auto length = static_cast<std::uint64_t>(size);
+            key.append(reinterpret_cast<char const *>(&length), sizeof(length));
+            key.append(static_cast<char const *>(data), size);
+        }
+
+        /// Appends a type-tagged encoding of @p value that mirrors command::bind_value.
+        template <typename Value> void append_cache_key(std::string &key, Value const &value) {
+            using decayed = decay_t<Value>;
+            if constexpr (std::is_same_v<decayed, null_type>) {
+                key.push_back('n');
+            } else if constexpr (is_optional_v<decayed>) {
+                if (!value) {
+                    key.push_back('n');
+                } else {
+                    append_cache_key(key, *value);
+                }
+            } else if constexpr (is_duration_v<decayed>) {
+                append_cache_key(key, static_cast<std::int64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(value).count()));
+            } else if constexpr (is_time_point_v<decayed>) {
+                append_cache_key(key, static_cast<std::int64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        value.time_since_epoch()).count()));
+            } else if constexpr (std::is_enum_v<decayed> || std::is_integral_v<decayed>) {
+                auto v = static_cast<std::int64_t>(value);
+                append_cache_key_bytes(key, 'i', &v, sizeof(v));
+            } else if constexpr (std::is_floating_point_v<decayed>) {
+                auto v = static_cast<double>(value);
+                append_cache_key_bytes(key, 'r', &v, sizeof(v));
+            } else if constexpr (is_string_like_v<decayed>) {
+                std::string_view text(value);
+                append_cache_key_bytes(key, 't', text.data(), text.size());
+            } else if constexpr (is_byte_vector_v<decayed> || is_unsigned_char_span_v<decayed> ||
+                                 is_byte_span_v<decayed>) {
+                append_cache_key_bytes(key, 'b', value.data(), value.size());
+            } else {
+                static_assert(always_false_v<decayed>,
+                              "Unsupported parameter type for sqlite::query_cache");
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Caches read-only query results for one connection.
+     *
+     * Each statement's table dependencies are discovered once from its EXPLAIN listing, leaving
+     * any authorizer the application installed untouched. Local writes are tracked precisely with
+     * update/commit/rollback hooks: committing drops only the results that read a changed table,
+     * and reads of tables with uncommitted changes bypass the cache. Commits by other connections
+     * or processes are detected through `PRAGMA data_version` and drop every entry. Schema changes
+     * are not tracked; call clear() after DDL. Only deterministic statements should be cached.
+     * Statements that read a virtual table always run, since their writes bypass the hooks.
+     * Writes the update hook misses, such as `DELETE FROM t` without WHERE, drop every entry.
+     *
+     * The cache listens to @p con's update, commit and rollback hooks through the connection's
+     * shared listener registry, so it coexists with row caches and change buses; @p con must
+     * outlive it.
+     */
+    class query_cache {
+    public:
+        explicit query_cache(connection &con, query_cache_options options = {});
+        ~query_cache();
+
+        query_cache(query_cache const &)            = delete;
+        query_cache &operator=(query_cache const &) = delete;
+
+        /// Returns the result of @p sql bound with @p args, running it on a miss.
+        template <typename... Args>
+        std::shared_ptr<rowset const> fetch(std::string_view sql, Args &&...args) {
+            std::string key(sql);
+            key.push_back('\0');
+            (detail::append_cache_key(key, args), ...);
+            return fetch_impl(sql, std::move(key), [&](query &q) { (void)(q % ... % args); });
+        }
+
+        /// Drops every entry that reads @p table (`name` or `schema.name`).
+        void invalidate(std::string_view table);
+
+        /// Drops every entry.
+        void clear();
+
+        query_cache_stats stats() const;
+
+    private:
+        struct entry {
+            std::string key;
+            std::shared_ptr<rowset const> rows;
+            std::shared_ptr<std::vector<std::string> const> tables;
+            std::size_t bytes = 0;
+        };
+
+        using lru_list = std::list<entry>;
+        using iterator = lru_list::iterator;
+
+        static void on_update(void *self, int, char const *schema, char const *table,
+                              long long rowid);
+        static int on_commit(void *self);
+        static void on_rollback(void *self);
+        static void on_missed(void *self);
+
+        std::shared_ptr<rowset const> fetch_impl(std::string_view sql, std::string key,
+                                                 std::function<void(query &)> const &bind);
+        std::shared_ptr<std::vector<std::string> const> dependencies(std::string_view sql);
+        bool data_version_changed();
+        void erase_locked(iterator it);
+        void invalidate_locked(std::string const &table);
+        void clear_locked();
+
+        connection &con_;
+        query_cache_options options_;
+        sqlite3 *db_                    = nullptr;
+        sqlite3_stmt *data_version_     = nullptr;
+        std::int64_t last_data_version_ = 0;
+        std::uint64_t generation_       = 0; ///< Bumped by every invalidation; guarded by mutex_.
+
+        mutable std::mutex mutex_;
+        lru_list lru_;
+        std::unordered_map<std::string, iterator> entries_;
+        std::unordered_map<std::string, std::unordered_set<std::string>> readers_by_table_;
+        std::unordered_map<std::string, std::shared_ptr<std::vector<std::string> const>>
+            dependencies_;
+        std::unordered_set<std::string> pending_;
+        std::size_t memory_usage_ = 0;
+        query_cache_stats stats_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_QUERY_CACHE_HPP_INCLUDED
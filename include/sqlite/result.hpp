@@ -43,6 +43,7 @@ modification, are permitted provided that the following conditions are met:
 #include <type_traits>
 #include <vector>
 
+#include <sqlite/column_batch.hpp>
 #include <sqlite/database_exception.hpp>
 #include <sqlite/deprecated.hpp>
 #include <sqlite/detail/type_helpers.hpp>
@@ -235,7 +236,25 @@ inline namespace v2 {
          */
         template <typename... Ts> std::tuple<Ts...> get_tuple(int start_column = 0);
 
+        /**
+         * @brief Advances through up to @p max_rows rows, appending them column-wise to @p batch.
+         *
+         * The batch is cleared first but keeps its capacity, so a loop over the same batch
+         * allocates only while it grows. Columns are read positionally starting at column 0
+         * with direct `sqlite3_column_*` calls; the access check runs once per batch.
+         *
+         * @returns Number of rows appended; 0 once the result set is exhausted.
+         * @throws database_exception when @p Ts exceeds the column count.
+         */
+        template <typename... Ts>
+        std::size_t fetch_columns(column_batch<Ts...> &batch, std::size_t max_rows);
+
+        /// Convenience overload returning a freshly allocated batch.
+        template <typename... Ts> column_batch<Ts...> fetch_columns(std::size_t max_rows);
+
     private:
+        sqlite3_stmt *checked_statement();
+        bool step_unchecked();
         void access_check(int);
         int get_int(int idx);
         std::int64_t get_int64(int idx);
@@ -307,6 +326,25 @@ inline namespace v2 {
         }
         return detail::tuple_from_row<Ts...>(*this, start_column, std::index_sequence_for<Ts...>{});
     }
+
+    template <typename... Ts>
+    std::size_t result::fetch_columns(column_batch<Ts...> &batch, std::size_t max_rows) {
+        if (static_cast<int>(sizeof...(Ts)) > m_columns) {
+            throw database_exception("Tuple columns exceed result column count.");
+        }
+        batch.clear();
+        sqlite3_stmt *stmt = checked_statement();
+        while (batch.size() < max_rows && step_unchecked()) {
+            batch.append_row(stmt);
+        }
+        return batch.size();
+    }
+
+    template <typename... Ts> column_batch<Ts...> result::fetch_columns(std::size_t max_rows) {
+        column_batch<Ts...> batch;
+        fetch_columns(batch, max_rows);
+        return batch;
+    }
 } // namespace v2
 } // namespace sqlite
 
@@ -0,0 +1,321 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_ROW_CACHE_HPP_INCLUDED
+#define GUARD_SQLITE_ROW_CACHE_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <sqlite/query.hpp>
+#include <sqlite/struct_mapping.hpp>
+#include <sqlite/typed_rows.hpp>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/**
+ * @file sqlite/row_cache.hpp
+ * @brief Read-through cache of single rows keyed by primary key.
+ *
+ * `sqlite::row_cache` serves hot point lookups from a sharded hash map and drops individual rows
+ * as the update hook reports their rowids, so unrelated writes never cost a miss.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Limits applied by @ref row_cache.
+    struct row_cache_options {
+        std::size_t capacity = 65536; ///< Cached rows across all shards before LRU eviction.
+        std::size_t shards   = 16;    ///< Independently locked partitions of the key space.
+    };
+
+    /// Counters reported by @ref row_cache::stats.
+    struct row_cache_stats {
+        std::uint64_t hits          = 0;
+        std::uint64_t misses        = 0;
+        std::uint64_t invalidations = 0; ///< Rows dropped because a write may have changed them.
+        std::uint64_t evictions     = 0; ///< Rows dropped to stay within the capacity.
+        std::size_t entries         = 0;
+    };
+
+    namespace detail {
+        class change_hooks;
+
+        /// `SELECT <fields>, rowid FROM <table> WHERE <key> = ?1`
+        template <typename T> constexpr void write_row_cache_fill(sql_sink &sql) {
+            sql << "SELECT ";
+            write_columns<T>(sql, 0);
+            sql << ", rowid FROM " << describe<T>().table << " WHERE " << key_name<T>() << " = ?1";
+        }
+
+        /// Hook and statement handling shared by every row_cache instantiation.
+        class row_cache_base {
+        public:
+            row_cache_base(row_cache_base const &)            = delete;
+            row_cache_base &operator=(row_cache_base const &) = delete;
+
+        protected:
+            row_cache_base(connection &con, std::string_view table, std::string const &fill_sql);
+            ~row_cache_base();
+
+            /// Starts listening to the hooks of @p con; derived constructors call it last, since
+            /// the hooks may fire on another thread right away.
+            void attach(connection &con);
+            /// Stops listening to the hooks; derived destructors call it before their maps go.
+            void detach() noexcept;
+
+            /// Resets the fill statement for a new lookup.
+            query &fill_query();
+            sqlite3_stmt *fill_statement();
+
+            /// Catches up with changes the update hook missed; lookups call it first.
+            void settle() noexcept;
+
+            /// True when a row fetched at @p epoch may be stored under @p rowid.
+            bool storable(std::int64_t rowid, std::uint64_t epoch) const;
+
+            virtual void erase_rowid(std::int64_t rowid) = 0;
+            virtual void erase_all() = 0;
+
+            std::mutex fill_mutex_;
+            std::atomic<std::uint64_t> epoch_{0};
+            std::atomic<std::uint64_t> hits_{0};
+            std::atomic<std::uint64_t> misses_{0};
+            std::atomic<std::uint64_t> invalidations_{0};
+            std::atomic<std::uint64_t> evictions_{0};
+
+        private:
+            static void on_update(void *self, int, char const *schema, char const *table,
+                                  long long rowid);
+            static int on_commit(void *self);
+            static void on_rollback(void *self);
+            static void on_missed(void *self);
+
+            change_hooks *hooks_ = nullptr;
+            std::string table_;
+            query fill_;
+            bool inserts_may_replace_ = false;
+            mutable std::mutex pending_mutex_;
+            std::unordered_set<std::int64_t> pending_;
+        };
+    } // namespace detail
+
+    /**
+     * @brief Caches rows of @p Row's table by the key in its first described field.
+     *
+     * A miss runs `SELECT <fields>, rowid ... WHERE <key> = ?1` through one prepared statement
+     * and stores the row with its rowid. The update hook on @p con drops rows by rowid as they
+     * change, and rows with uncommitted changes are not cached until the transaction ends, so
+     * lookups stay consistent with what @p con reads. Writes through other connections are not
+     * seen; use @ref invalidate or @ref clear for those. SQLite reports an UPDATE that changes the
+     * rowid itself under the new rowid only, so invalidate the old key explicitly in that case.
+     * Absent keys are not cached, and tables must have a rowid.
+     *
+     * The update hook misses two kinds of deletes. `DELETE FROM t` without WHERE moves the change
+     * counter further than the hook saw; the next lookup after the statement notices that and
+     * drops every row.
+     * Rows that `INSERT OR REPLACE` deletes on a UNIQUE conflict are never reported at all, so on
+     * tables with a UNIQUE index (a non-integer primary key included) every insert drops every
+     * row. Tables whose only key is the rowid keep their cache across inserts.
+     *
+     * Lookups may come from several threads. The cache listens to the update, commit and
+     * rollback hooks of @p con, which must outlive it. The hooks are shared with other caches and
+     * change buses on @p con; hooks installed directly through the C API make construction throw.
+     */
+    template <typename Key, described_struct Row> class row_cache : detail::row_cache_base {
+    public:
+        explicit row_cache(connection &con, row_cache_options options = {}) :
+            row_cache_base(con, describe<Row>().table, fill_sql()),
+            shards_(std::max<std::size_t>(options.shards, 1)),
+            shard_capacity_(std::max<std::size_t>(options.capacity / shards_.size(), 1)) {
+            attach(con);
+        }
+
+        ~row_cache() {
+            detach();
+        }
+
+        /// The row stored under @p key, loading it on a miss.
+        std::optional<Row> get(Key const &key) {
+            settle();
+            auto &s = shard_for(key);
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (auto it = s.by_key.find(key); it != s.by_key.end()) {
+                    s.lru.splice(s.lru.begin(), s.lru, it->second);
+                    ++hits_;
+                    return it->second->row;
+                }
+            }
+            ++misses_;
+
+            std::optional<Row> row;
+            std::int64_t rowid  = 0;
+            std::uint64_t epoch = 0;
+            {
+                std::lock_guard<std::mutex> fill(fill_mutex_);
+                epoch = epoch_.load();
+                fill_query() % key;
+                sqlite3_stmt *stmt = fill_statement();
+                if (detail::stmt_step(stmt)) {
+                    row   = detail::read_struct<Row>(stmt);
+                    rowid = detail::stmt_column_int64(stmt, static_cast<int>(field_count<Row>()));
+                }
+                fill_query().clear();
+            }
+            if (!row) {
+                return row;
+            }
+
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (!storable(rowid, epoch) || s.by_key.count(key) != 0) {
+                return row;
+            }
+            s.lru.push_front(entry{key, rowid, *row});
+            s.by_key.emplace(key, s.lru.begin());
+            s.by_rowid.emplace(rowid, s.lru.begin());
+            if (s.lru.size() > shard_capacity_) {
+                erase(s, std::prev(s.lru.end()));
+                ++evictions_;
+            }
+            return row;
+        }
+
+        /// Drops the row stored under @p key.
+        void invalidate(Key const &key) {
+            auto &s = shard_for(key);
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (auto it = s.by_key.find(key); it != s.by_key.end()) {
+                erase(s, it->second);
+            }
+        }
+
+        /// Drops every row.
+        void clear() {
+            for (auto &s : shards_) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.lru.clear();
+                s.by_key.clear();
+                s.by_rowid.clear();
+            }
+        }
+
+        row_cache_stats stats() const {
+            row_cache_stats out;
+            out.hits          = hits_.load();
+            out.misses        = misses_.load();
+            out.invalidations = invalidations_.load();
+            out.evictions     = evictions_.load();
+            for (auto const &s : shards_) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                out.entries += s.lru.size();
+            }
+            return out;
+        }
+
+    private:
+        struct entry {
+            Key key;
+            std::int64_t rowid = 0;
+            Row row;
+        };
+
+        using lru_list = std::list<entry>;
+        using iterator = typename lru_list::iterator;
+
+        // Rows are sharded by key; the rowid index lives in the same shard so the update hook
+        // probes every shard, which is cheap next to the write that triggered it.
+        struct shard {
+            mutable std::mutex mutex;
+            lru_list lru;
+            std::unordered_map<Key, iterator> by_key;
+            std::unordered_map<std::int64_t, iterator> by_rowid;
+        };
+
+        static std::string fill_sql() {
+            static constexpr auto text = detail::make_sql<&detail::write_row_cache_fill<Row>>();
+            return text.data();
+        }
+
+        shard &shard_for(Key const &key) {
+            return shards_[std::hash<Key>{}(key) % shards_.size()];
+        }
+
+        static void erase(shard &s, iterator it) {
+            s.by_key.erase(it->key);
+            s.by_rowid.erase(it->rowid);
+            s.lru.erase(it);
+        }
+
+        void erase_all() override {
+            for (auto &s : shards_) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                invalidations_ += s.lru.size();
+                s.lru.clear();
+                s.by_key.clear();
+                s.by_rowid.clear();
+            }
+        }
+
+        void erase_rowid(std::int64_t rowid) override {
+            for (auto &s : shards_) {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (auto it = s.by_rowid.find(rowid); it != s.by_rowid.end()) {
+                    erase(s, it->second);
+                    ++invalidations_;
+                    return;
+                }
+            }
+        }
+
+        std::vector<shard> shards_;
+        std::size_t shard_capacity_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_ROW_CACHE_HPP_INCLUDED
@@ -0,0 +1,305 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_ROWSET_HPP_INCLUDED
+#define GUARD_SQLITE_ROWSET_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <sqlite/database_exception.hpp>
+#include <sqlite/detail/type_helpers.hpp>
+#include <sqlite/ext/variant.hpp>
+
+/**
+ * @file sqlite/rowset.hpp
+ * @brief Compact, immutable copy of a whole result set.
+ *
+ * A `sqlite::rowset` stores every cell as a 16-byte tagged value: integers and reals inline,
+ * text and blobs as offset/length into a single byte arena shared by the whole rowset. Reading is
+ * done through `value_view`, which borrows from the rowset and never allocates.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct query;
+
+    namespace detail {
+        /// Storage cell of a rowset; scalars inline, text/blob as a slice of the arena.
+        struct packed_value {
+            union {
+                std::int64_t integer;
+                double real;
+                std::uint64_t offset;
+            };
+            std::uint32_t length = 0;
+            type kind            = null;
+        };
+        static_assert(sizeof(packed_value) == 16, "rowset cells must stay 16 bytes");
+    } // namespace detail
+
+    /// Borrowed view of one cell; valid as long as the owning rowset.
+    class value_view {
+    public:
+        value_view(detail::packed_value const &cell, char const *arena) noexcept :
+            cell_(&cell), arena_(arena) {}
+
+        /// Storage class of the value (`sqlite::null`, `integer`, `real`, `text` or `blob`).
+        type kind() const noexcept {
+            return cell_->kind;
+        }
+
+        bool is_null() const noexcept {
+            return cell_->kind == null;
+        }
+
+        /// Integer value; reals are truncated, everything else yields 0.
+        std::int64_t as_int64() const noexcept {
+            switch (cell_->kind) {
+            case integer:
+                return cell_->integer;
+            case real:
+                return static_cast<std::int64_t>(cell_->real);
+            default:
+                return 0;
+            }
+        }
+
+        /// Floating-point value; integers are widened, everything else yields 0.0.
+        double as_double() const noexcept {
+            switch (cell_->kind) {
+            case integer:
+                return static_cast<double>(cell_->integer);
+            case real:
+                return cell_->real;
+            default:
+                return 0.0;
+            }
+        }
+
+        /// Text or blob bytes as characters; empty for scalars and NULL.
+        std::string_view as_text() const noexcept {
+            if (cell_->kind != text && cell_->kind != blob) {
+                return {};
+            }
+            return {arena_ + cell_->offset, cell_->length};
+        }
+
+        /// Text or blob bytes; empty for scalars and NULL.
+        std::span<const unsigned char> as_blob() const noexcept {
+            auto view = as_text();
+            return {reinterpret_cast<unsigned char const *>(view.data()), view.size()};
+        }
+
+        /// Converts into a @ref variant_t, allocating like @ref result::get_variant.
+        variant_t to_variant() const;
+
+        /**
+         * @brief Typed accessor mirroring the common @ref result::get conversions.
+         *
+         * Supports arithmetic types, enums, `std::string_view`, `std::string`,
+         * `std::span<const unsigned char>`, byte vectors and `std::optional` of those.
+         */
+        template <typename T> T get() const {
+            using decayed = detail::decay_t<T>;
+            if constexpr (detail::is_optional_v<decayed>) {
+                if (is_null()) {
+                    return std::nullopt;
+                }
+                return get<typename detail::optional_value<decayed>::type>();
+            } else if constexpr (std::is_same_v<decayed, bool>) {
+                return as_int64() != 0;
+            } else if constexpr (std::is_enum_v<decayed> || std::is_integral_v<decayed>) {
+                return static_cast<decayed>(as_int64());
+            } else if constexpr (std::is_floating_point_v<decayed>) {
+                return static_cast<decayed>(as_double());
+            } else if constexpr (std::is_same_v<decayed, std::string_view>) {
+                return as_text();
+            } else if constexpr (std::is_same_v<decayed, std::string>) {
+                return std::string(as_text());
+            } else if constexpr (detail::is_unsigned_char_span_v<decayed>) {
+                return as_blob();
+            } else if constexpr (detail::is_byte_vector_v<decayed>) {
+                auto bytes = as_blob();
+                return std::vector<unsigned char>(bytes.begin(), bytes.end());
+            } else {
+                static_assert(detail::always_false_v<decayed>,
+                              "Unsupported type for sqlite::value_view::get<T>");
+            }
+        }
+
+    private:
+        detail::packed_value const *cell_;
+        char const *arena_;
+    };
+
+    class rowset;
+
+    /// One row of a @ref rowset.
+    class rowset_row {
+    public:
+        rowset_row(rowset const &set, std::size_t row) noexcept : set_(&set), row_(row) {}
+
+        value_view operator[](std::size_t column) const noexcept;
+        /// Looks up @p name among the column names; throws database_exception when missing.
+        value_view operator[](std::string_view name) const;
+        std::size_t size() const noexcept;
+
+        template <typename T> T get(std::size_t column) const {
+            return (*this)[column].template get<T>();
+        }
+
+    private:
+        rowset const *set_;
+        std::size_t row_;
+    };
+
+    /**
+     * @brief Immutable, arena-backed copy of a result set.
+     *
+     * Construction steps the query to completion. Afterwards the rowset is independent of the
+     * connection and may be shared read-only between threads, which makes it suitable for caching.
+     */
+    class rowset {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = rowset_row;
+            using difference_type   = std::ptrdiff_t;
+
+            iterator() = default;
+            iterator(rowset const *set, std::size_t row) noexcept : set_(set), row_(row) {}
+
+            rowset_row operator*() const noexcept {
+                return rowset_row(*set_, row_);
+            }
+
+            iterator &operator++() noexcept {
+                ++row_;
+                return *this;
+            }
+
+            iterator operator++(int) noexcept {
+                auto copy = *this;
+                ++row_;
+                return copy;
+            }
+
+            difference_type operator-(iterator const &other) const noexcept {
+                return static_cast<difference_type>(row_) -
+                       static_cast<difference_type>(other.row_);
+            }
+
+            bool operator==(iterator const &other) const noexcept = default;
+
+        private:
+            rowset const *set_ = nullptr;
+            std::size_t row_   = 0;
+        };
+
+        rowset() = default;
+
+        /// Copies every remaining row of @p q into a new rowset.
+        explicit rowset(query &q);
+
+        std::size_t size() const noexcept {
+            return columns_.empty() ? 0 : cells_.size() / columns_.size();
+        }
+
+        bool empty() const noexcept {
+            return cells_.empty();
+        }
+
+        std::size_t column_count() const noexcept {
+            return columns_.size();
+        }
+
+        std::vector<std::string> const &column_names() const noexcept {
+            return columns_;
+        }
+
+        /// Index of column @p name, or `std::nullopt` when absent.
+        std::optional<std::size_t> column_index(std::string_view name) const noexcept;
+
+        value_view at(std::size_t row, std::size_t column) const noexcept {
+            return value_view(cells_[row * columns_.size() + column], arena_.data());
+        }
+
+        rowset_row operator[](std::size_t row) const noexcept {
+            return rowset_row(*this, row);
+        }
+
+        iterator begin() const noexcept {
+            return iterator(this, 0);
+        }
+
+        iterator end() const noexcept {
+            return iterator(this, size());
+        }
+
+        /// Bytes held by cells and the arena (excluding column names).
+        std::size_t memory_usage() const noexcept {
+            return cells_.capacity() * sizeof(detail::packed_value) + arena_.capacity();
+        }
+
+    private:
+        std::vector<std::string> columns_;
+        std::vector<detail::packed_value> cells_;
+        std::vector<char> arena_;
+    };
+
+    inline value_view rowset_row::operator[](std::size_t column) const noexcept {
+        return set_->at(row_, column);
+    }
+
+    inline value_view rowset_row::operator[](std::string_view name) const {
+        auto index = set_->column_index(name);
+        if (!index) {
+            throw database_exception("Unknown column: " + std::string(name));
+        }
+        return set_->at(row_, *index);
+    }
+
+    inline std::size_t rowset_row::size() const noexcept {
+        return set_->column_count();
+    }
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_ROWSET_HPP_INCLUDED
@@ -85,6 +85,12 @@ inline namespace v2 {
         /** \brief Rewind an open read transaction to this snapshot. */
         void open(connection &con, std::string_view schema = "main") const;
 
+        /** \brief Order two snapshots of the same database (sqlite3_snapshot_cmp).
+         * \return negative if this snapshot is older than \a other, 0 if equal, positive if
+         * newer. Only meaningful while the WAL has not been reset between the two.
+         */
+        int compare(snapshot const &other) const;
+
         sqlite3_snapshot *native_handle() const noexcept {
             return handle_;
         }
@@ -0,0 +1,119 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_SNAPSHOT_GROUP_HPP_INCLUDED
+#define GUARD_SQLITE_SNAPSHOT_GROUP_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/snapshot.hpp>
+
+/**
+ * @file sqlite/snapshot_group.hpp
+ * @brief Several pooled reader connections pinned to one WAL snapshot.
+ *
+ * A `sqlite::snapshot_group` lets a report fan out across threads while every reader sees the
+ * exact same database state, and reports how far that state lags behind the current head.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct transaction;
+
+    /// How far a @ref snapshot_group trails the newest committed state.
+    struct snapshot_lag {
+        bool behind = false; ///< Commits exist that the group cannot see
+        std::chrono::steady_clock::duration age{}; ///< Time since the snapshot was taken
+    };
+
+    /**
+     * @brief Leases K connections and keeps each in a read transaction on a shared snapshot.
+     *
+     * The first reader starts a read transaction and captures the snapshot; the others open it
+     * before their first read. Because every reader keeps its read transaction open, no
+     * checkpoint can copy frames past the snapshot or reset the WAL while the group is alive
+     * (RESTART/TRUNCATE checkpoints report busy instead). Destruction ends the transactions,
+     * frees the snapshot and returns the leases. Requires WAL mode and snapshot support.
+     *
+     * Each reader connection must be used by one thread at a time and must not commit or roll
+     * back the group's transaction itself.
+     */
+    class snapshot_group {
+    public:
+        snapshot_group(connection_pool &pool, std::size_t readers,
+                       std::string_view schema = "main");
+        ~snapshot_group();
+
+        snapshot_group(snapshot_group const &)            = delete;
+        snapshot_group &operator=(snapshot_group const &) = delete;
+
+        std::size_t size() const noexcept {
+            return leases_.size();
+        }
+
+        /// Reader @p index; throws std::out_of_range for an invalid index.
+        connection &reader(std::size_t index) const;
+
+        connection &operator[](std::size_t index) const {
+            return reader(index);
+        }
+
+        snapshot const &pinned() const noexcept {
+            return snapshot_;
+        }
+
+        /**
+         * @brief Compares the pinned snapshot with the current head.
+         *
+         * Uses a private observer connection (opened on first use) to capture the head, so it
+         * never disturbs the readers. Only the public `sqlite3_snapshot_cmp` ordering is used;
+         * SQLite exposes no supported way to count the commits in between.
+         */
+        snapshot_lag lag();
+
+    private:
+        std::string schema_;
+        std::vector<connection_pool::lease> leases_;
+        std::vector<std::unique_ptr<transaction>> transactions_;
+        snapshot snapshot_;
+        std::chrono::steady_clock::time_point taken_;
+        std::unique_ptr<connection> observer_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_SNAPSHOT_GROUP_HPP_INCLUDED
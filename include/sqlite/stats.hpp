@@ -0,0 +1,121 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_STATS_HPP_INCLUDED
+#define GUARD_SQLITE_STATS_HPP_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @file sqlite/stats.hpp
+ * @brief Plain snapshots of SQLite's memory and page-cache counters.
+ *
+ * `connection_stats` mirrors `sqlite3_db_status` for a single handle while `process_stats`
+ * mirrors the process-wide `sqlite3_status64` counters. Both are trivially copyable and are
+ * filled without allocating, so a metrics thread can poll them at a high frequency.
+ */
+namespace sqlite {
+inline namespace v2 {
+
+    /// Current and high-water value of a single SQLite status counter.
+    struct status_counter {
+        std::int64_t current   = 0;
+        std::int64_t highwater = 0;
+    };
+
+    /**
+     * @brief Per-connection counters reported by `sqlite3_db_status`.
+     *
+     * The `*_used` fields and `deferred_fks` are current values and `lookaside_used_highwater`
+     * is a peak; the hit, miss, write and spill counters accumulate since the connection opened.
+     */
+    struct connection_stats {
+        std::int64_t lookaside_used           = 0; ///< Lookaside slots currently checked out.
+        std::int64_t lookaside_used_highwater = 0; ///< Peak number of lookaside slots in use.
+        std::int64_t lookaside_hit            = 0; ///< Allocations served from lookaside.
+        std::int64_t lookaside_miss_size      = 0; ///< Misses because the request was too big.
+        std::int64_t lookaside_miss_full      = 0; ///< Misses because lookaside was exhausted.
+        std::int64_t cache_used               = 0; ///< Bytes of page cache used by the handle.
+        std::int64_t cache_used_shared        = 0; ///< Page cache bytes, shared caches split.
+        std::int64_t cache_hit                = 0; ///< Page cache hits.
+        std::int64_t cache_miss               = 0; ///< Page cache misses.
+        std::int64_t cache_write              = 0; ///< Dirty pages written to disk.
+        std::int64_t cache_spill              = 0; ///< Dirty pages spilled mid-transaction.
+        std::int64_t schema_used              = 0; ///< Bytes used to hold the parsed schema.
+        std::int64_t stmt_used                = 0; ///< Bytes used by prepared statements.
+        std::int64_t deferred_fks             = 0; ///< Non-zero while deferred FKs are unresolved.
+
+        /// Accumulates @p other into this snapshot; used to build pool-wide totals. Peaks of
+        /// different connections do not add up, so `lookaside_used_highwater` keeps the larger.
+        connection_stats &operator+=(connection_stats const &other) noexcept {
+            lookaside_used += other.lookaside_used;
+            lookaside_used_highwater =
+                std::max(lookaside_used_highwater, other.lookaside_used_highwater);
+            lookaside_hit += other.lookaside_hit;
+            lookaside_miss_size += other.lookaside_miss_size;
+            lookaside_miss_full += other.lookaside_miss_full;
+            cache_used += other.cache_used;
+            cache_used_shared += other.cache_used_shared;
+            cache_hit += other.cache_hit;
+            cache_miss += other.cache_miss;
+            cache_write += other.cache_write;
+            cache_spill += other.cache_spill;
+            schema_used += other.schema_used;
+            stmt_used += other.stmt_used;
+            deferred_fks += other.deferred_fks;
+            return *this;
+        }
+    };
+
+    /// Process-wide counters reported by `sqlite3_status64`.
+    struct process_stats {
+        status_counter memory_used;        ///< Bytes currently allocated through SQLite.
+        status_counter malloc_count;       ///< Outstanding allocations.
+        status_counter malloc_size;        ///< Largest single allocation request (high-water).
+        status_counter pagecache_used;     ///< Pages used from the SQLITE_CONFIG_PAGECACHE pool.
+        status_counter pagecache_overflow; ///< Page cache bytes that overflowed into malloc.
+        status_counter pagecache_size;     ///< Largest page cache allocation (high-water).
+        status_counter parser_stack;       ///< Deepest parser stack (high-water).
+    };
+
+    /**
+     * @brief Reads the process-wide SQLite memory counters.
+     *
+     * @param reset_highwater When true the high-water marks are reset after they were read.
+     */
+    process_stats global_stats(bool reset_highwater = false);
+
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_STATS_HPP_INCLUDED
@@ -0,0 +1,451 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_STRUCT_MAPPING_HPP_INCLUDED
+#define GUARD_SQLITE_STRUCT_MAPPING_HPP_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <sqlite/typed_rows.hpp>
+
+/**
+ * @file sqlite/struct_mapping.hpp
+ * @brief Compile-time mapping between plain structs, statement parameters and result columns.
+ *
+ * Structs are mapped either through the `VSQLITE_FIELDS` macro, which records the table name,
+ * field names and member pointers, or - for aggregates without a description - positionally via
+ * structured bindings. Columns and parameters are matched by position, so reads and binds never
+ * perform name lookups. Described structs additionally get their CRUD SQL generated as constant
+ * strings in @ref sqlite::struct_sql.
+ */
+
+// clang-format off
+#define VSQLITE_DETAIL_EXPAND(x) x
+#define VSQLITE_DETAIL_FIELD(Type, name) ::sqlite::field_descriptor<Type, decltype(Type::name)>{#name, &Type::name}
+#define VSQLITE_DETAIL_F1(T, a) VSQLITE_DETAIL_FIELD(T, a)
+#define VSQLITE_DETAIL_F2(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F1(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F3(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F2(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F4(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F3(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F5(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F4(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F6(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F5(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F7(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F6(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F8(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F7(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F9(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F8(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F10(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F9(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F11(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F10(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F12(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F11(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F13(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F12(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F14(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F13(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F15(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F14(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F16(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F15(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F17(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F16(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F18(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F17(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F19(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F18(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F20(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F19(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F21(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F20(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F22(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F21(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F23(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F22(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F24(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F23(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F25(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F24(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F26(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F25(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F27(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F26(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F28(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F27(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F29(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F28(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F30(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F29(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F31(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F30(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_F32(T, a, ...) VSQLITE_DETAIL_FIELD(T, a), VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_F31(T, __VA_ARGS__))
+#define VSQLITE_DETAIL_PICK(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, NAME, ...) NAME
+#define VSQLITE_DETAIL_FIELDS(T, ...) \
+    VSQLITE_DETAIL_EXPAND(VSQLITE_DETAIL_PICK(__VA_ARGS__, VSQLITE_DETAIL_F32, VSQLITE_DETAIL_F31, VSQLITE_DETAIL_F30, VSQLITE_DETAIL_F29, VSQLITE_DETAIL_F28, VSQLITE_DETAIL_F27, VSQLITE_DETAIL_F26, VSQLITE_DETAIL_F25, VSQLITE_DETAIL_F24, VSQLITE_DETAIL_F23, VSQLITE_DETAIL_F22, VSQLITE_DETAIL_F21, VSQLITE_DETAIL_F20, VSQLITE_DETAIL_F19, VSQLITE_DETAIL_F18, VSQLITE_DETAIL_F17, VSQLITE_DETAIL_F16, VSQLITE_DETAIL_F15, VSQLITE_DETAIL_F14, VSQLITE_DETAIL_F13, VSQLITE_DETAIL_F12, VSQLITE_DETAIL_F11, VSQLITE_DETAIL_F10, VSQLITE_DETAIL_F9, VSQLITE_DETAIL_F8, VSQLITE_DETAIL_F7, VSQLITE_DETAIL_F6, VSQLITE_DETAIL_F5, VSQLITE_DETAIL_F4, VSQLITE_DETAIL_F3, VSQLITE_DETAIL_F2, VSQLITE_DETAIL_F1)(T, __VA_ARGS__))
+// clang-format on
+
+/**
+ * @brief Describes @p Type as a row of table @p Table with the listed fields.
+ *
+ * Place the macro at namespace scope next to the struct (it defines a function found via ADL):
+ * \code
+ * struct user { std::int64_t id; std::string name; double score; };
+ * VSQLITE_FIELDS(user, "users", id, name, score)
+ * \endcode
+ * The first field is treated as the primary key by @ref sqlite::struct_sql. Up to 32 fields.
+ */
+#define VSQLITE_FIELDS(Type, Table, ...)                                                           \
+    [[maybe_unused]] constexpr auto vsqlite_describe(Type const *) {                               \
+        return ::sqlite::describe_fields<Type>(Table, VSQLITE_DETAIL_FIELDS(Type, __VA_ARGS__));   \
+    }
+
+namespace sqlite {
+inline namespace v2 {
+    /// Name and member pointer of one mapped field.
+    template <typename T, typename M> struct field_descriptor {
+        using value_type = M;
+        std::string_view name;
+        M T::*member;
+    };
+
+    /// Table name plus the ordered field descriptors of a described struct.
+    template <typename T, typename... Fields> struct struct_description {
+        std::string_view table;
+        std::tuple<Fields...> fields;
+    };
+
+    template <typename T, typename... Fields>
+    constexpr struct_description<T, Fields...> describe_fields(std::string_view table,
+                                                               Fields... fields) {
+        return {table, std::tuple<Fields...>(fields...)};
+    }
+
+    /// True for structs described with `VSQLITE_FIELDS`.
+    template <typename T>
+    concept described_struct = requires(T const *p) { vsqlite_describe(p); };
+
+    template <described_struct T> constexpr auto describe() {
+        return vsqlite_describe(static_cast<T const *>(nullptr));
+    }
+
+    namespace detail {
+        struct any_field {
+            template <typename U> operator U() const noexcept;
+        };
+
+        template <typename T, std::size_t N> constexpr bool brace_constructible_with() {
+            return []<std::size_t... I>(std::index_sequence<I...>) {
+                return requires { T{((void)I, any_field{})...}; };
+            }(std::make_index_sequence<N>{});
+        }
+
+        /// Number of fields of aggregate @p T, detected by brace-initialization.
+        template <typename T, std::size_t N = 0> constexpr std::size_t aggregate_arity() {
+            if constexpr (N < 32 && brace_constructible_with<T, N + 1>()) {
+                return aggregate_arity<T, N + 1>();
+            } else {
+                return N;
+            }
+        }
+
+        template <typename T> constexpr auto aggregate_tie(T &obj) {
+            constexpr std::size_t arity = aggregate_arity<std::remove_cv_t<T>>();
+            if constexpr (arity == 1) {
+                auto &[f0] = obj;
+                return std::tie(f0);
+            } else if constexpr (arity == 2) {
+                auto &[f0, f1] = obj;
+                return std::tie(f0, f1);
+            } else if constexpr (arity == 3) {
+                auto &[f0, f1, f2] = obj;
+                return std::tie(f0, f1, f2);
+            } else if constexpr (arity == 4) {
+                auto &[f0, f1, f2, f3] = obj;
+                return std::tie(f0, f1, f2, f3);
+            } else if constexpr (arity == 5) {
+                auto &[f0, f1, f2, f3, f4] = obj;
+                return std::tie(f0, f1, f2, f3, f4);
+            } else if constexpr (arity == 6) {
+                auto &[f0, f1, f2, f3, f4, f5] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5);
+            } else if constexpr (arity == 7) {
+                auto &[f0, f1, f2, f3, f4, f5, f6] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6);
+            } else if constexpr (arity == 8) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+            } else if constexpr (arity == 9) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+            } else if constexpr (arity == 10) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+            } else if constexpr (arity == 11) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+            } else if constexpr (arity == 12) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+            } else if constexpr (arity == 13) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+            } else if constexpr (arity == 14) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+            } else if constexpr (arity == 15) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+            } else if constexpr (arity == 16) {
+                auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = obj;
+                return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+            } else {
+                static_assert(arity > 0 && arity <= 16,
+                              "aggregate has too many fields; describe it with VSQLITE_FIELDS");
+            }
+        }
+    } // namespace detail
+
+    /// True for described structs and for aggregates usable through structured bindings.
+    template <typename T>
+    concept mappable_struct =
+        described_struct<T> ||
+        (std::is_aggregate_v<T> && std::is_default_constructible_v<T> &&
+         detail::aggregate_arity<T>() > 0);
+
+    /// Number of mapped fields of @p T.
+    template <mappable_struct T> constexpr std::size_t field_count() {
+        if constexpr (described_struct<T>) {
+            return std::tuple_size_v<decltype(describe<T>().fields)>;
+        } else {
+            return detail::aggregate_arity<T>();
+        }
+    }
+
+    /// Tuple of references to the mapped fields of @p obj, in mapping order.
+    template <typename T>
+        requires mappable_struct<std::remove_const_t<T>>
+    constexpr auto tie_fields(T &obj) {
+        if constexpr (described_struct<std::remove_const_t<T>>) {
+            return std::apply([&obj](auto const &...field) { return std::tie(obj.*field.member...); },
+                              describe<std::remove_const_t<T>>().fields);
+        } else {
+            return detail::aggregate_tie(obj);
+        }
+    }
+
+    namespace detail {
+        /// Counts or writes SQL text; used twice per statement to size and then fill a buffer.
+        struct sql_sink {
+            char *out        = nullptr;
+            std::size_t size = 0;
+
+            constexpr sql_sink &operator<<(std::string_view text) {
+                for (char c : text) {
+                    if (out) {
+                        out[size] = c;
+                    }
+                    ++size;
+                }
+                return *this;
+            }
+
+            constexpr sql_sink &operator<<(std::size_t number) {
+                char digits[20] = {};
+                std::size_t n   = 0;
+                do {
+                    digits[n++] = static_cast<char>('0' + number % 10);
+                    number /= 10;
+                } while (number != 0);
+                while (n > 0) {
+                    char c[1] = {digits[--n]};
+                    *this << std::string_view(c, 1);
+                }
+                return *this;
+            }
+        };
+
+        template <typename T> constexpr void write_columns(sql_sink &sql, std::size_t first) {
+            std::size_t index = 0;
+            std::apply(
+                [&](auto const &...field) {
+                    ((index >= first ? (void)(sql << (index > first ? ", " : "") << field.name)
+                                     : (void)0,
+                      ++index),
+                     ...);
+                },
+                describe<T>().fields);
+        }
+
+        template <typename T> constexpr std::string_view key_name() {
+            return std::get<0>(describe<T>().fields).name;
+        }
+
+        template <typename T> constexpr void write_select(sql_sink &sql) {
+            sql << "SELECT ";
+            write_columns<T>(sql, 0);
+            sql << " FROM " << describe<T>().table;
+        }
+
+        template <typename T> constexpr void write_select_by_key(sql_sink &sql) {
+            write_select<T>(sql);
+            sql << " WHERE " << key_name<T>() << " = ?1";
+        }
+
+        template <typename T> constexpr void write_insert(sql_sink &sql) {
+            sql << "INSERT INTO " << describe<T>().table << "(";
+            write_columns<T>(sql, 0);
+            sql << ") VALUES(";
+            for (std::size_t i = 1; i <= field_count<T>(); ++i) {
+                sql << (i > 1 ? ", ?" : "?") << i;
+            }
+            sql << ")";
+        }
+
+        template <typename T> constexpr void write_update(sql_sink &sql) {
+            sql << "UPDATE " << describe<T>().table << " SET ";
+            std::size_t index = 0;
+            std::apply(
+                [&](auto const &...field) {
+                    ((index > 0 ? (void)(sql << (index > 1 ? ", " : "") << field.name << " = ?"
+                                             << index + 1)
+                                : (void)0,
+                      ++index),
+                     ...);
+                },
+                describe<T>().fields);
+            sql << " WHERE " << key_name<T>() << " = ?1";
+        }
+
+        template <typename T> constexpr void write_remove(sql_sink &sql) {
+            sql << "DELETE FROM " << describe<T>().table << " WHERE " << key_name<T>() << " = ?1";
+        }
+
+        template <auto Writer> constexpr auto make_sql() {
+            constexpr std::size_t length = [] {
+                sql_sink counter;
+                Writer(counter);
+                return counter.size;
+            }();
+            std::array<char, length + 1> buffer{};
+            sql_sink writer{buffer.data()};
+            Writer(writer);
+            return buffer;
+        }
+    } // namespace detail
+
+    /**
+     * @brief SQL generated at compile time for a described struct.
+     *
+     * Parameters are numbered in field order (`?1` is the first field), so every statement -
+     * including UPDATE, whose key comes last in the text - is bound with a single
+     * @ref command::bind_struct call. SELECT statements list the columns in field order, as
+     * expected by @ref query::as. The strings are NUL-terminated and usable as cache keys as-is.
+     */
+    template <described_struct T> struct struct_sql {
+    private:
+        static constexpr auto select_text        = detail::make_sql<&detail::write_select<T>>();
+        static constexpr auto select_by_key_text = detail::make_sql<&detail::write_select_by_key<T>>();
+        static constexpr auto insert_text        = detail::make_sql<&detail::write_insert<T>>();
+        static constexpr auto update_text        = detail::make_sql<&detail::write_update<T>>();
+        static constexpr auto remove_text        = detail::make_sql<&detail::write_remove<T>>();
+
+    public:
+        /// `SELECT <fields> FROM <table>`; append a WHERE/ORDER BY clause as needed.
+        static constexpr char const *select = select_text.data();
+        /// `SELECT <fields> FROM <table> WHERE <key> = ?1`
+        static constexpr char const *select_by_key = select_by_key_text.data();
+        /// `INSERT INTO <table>(<fields>) VALUES(?1, ...)`
+        static constexpr char const *insert = insert_text.data();
+        /// `UPDATE <table> SET <field> = ?2, ... WHERE <key> = ?1`
+        static constexpr char const *update = update_text.data();
+        /// `DELETE FROM <table> WHERE <key> = ?1`; bind the key alone.
+        static constexpr char const *remove = remove_text.data();
+    };
+
+    namespace detail {
+        template <typename T> T read_struct(sqlite3_stmt *stmt) {
+            T out{};
+            auto fields = tie_fields(out);
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                ((std::get<I>(fields) =
+                      read_column<std::remove_reference_t<std::tuple_element_t<I, decltype(fields)>>>(
+                          stmt, static_cast<int>(I))),
+                 ...);
+            }(std::make_index_sequence<std::tuple_size_v<decltype(fields)>>{});
+            return out;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Input range returned by @ref query::as that yields one @p T per row.
+     *
+     * Column @c i is converted into field @c i with the same rules as @ref typed_rows; the range
+     * borrows the query's statement and must not outlive it.
+     */
+    template <mappable_struct T> class struct_rows {
+    public:
+        struct sentinel {};
+
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+
+            iterator() = default;
+            explicit iterator(sqlite3_stmt *stmt) : stmt_(stmt), done_(!detail::stmt_step(stmt)) {}
+
+            T operator*() const {
+                return detail::read_struct<T>(stmt_);
+            }
+
+            iterator &operator++() {
+                done_ = !detail::stmt_step(stmt_);
+                return *this;
+            }
+
+            void operator++(int) {
+                ++*this;
+            }
+
+            friend bool operator==(iterator const &it, sentinel) noexcept {
+                return it.done_;
+            }
+
+        private:
+            sqlite3_stmt *stmt_ = nullptr;
+            bool done_          = true;
+        };
+
+        explicit struct_rows(sqlite3_stmt *stmt) : stmt_(stmt) {
+            if (detail::stmt_column_count(stmt_) < static_cast<int>(field_count<T>())) {
+                detail::throw_column_count_mismatch();
+            }
+        }
+
+        /// Executes the first step; call once per range.
+        iterator begin() {
+            return iterator(stmt_);
+        }
+
+        sentinel end() const noexcept {
+            return {};
+        }
+
+    private:
+        sqlite3_stmt *stmt_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_STRUCT_MAPPING_HPP_INCLUDED
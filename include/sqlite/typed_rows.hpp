@@ -0,0 +1,191 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_TYPED_ROWS_HPP_INCLUDED
+#define GUARD_SQLITE_TYPED_ROWS_HPP_INCLUDED
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sqlite/detail/type_helpers.hpp>
+
+struct sqlite3_stmt;
+
+/**
+ * @file sqlite/typed_rows.hpp
+ * @brief Allocation-free typed row streaming straight from a prepared statement.
+ *
+ * `sqlite::typed_rows` is what `query::rows<Ts...>()` returns: a stack-only range that borrows the
+ * query's `sqlite3_stmt*` and converts columns with direct `sqlite3_column_*` calls, without the
+ * shared state and access-check indirection of @ref result.
+ */
+namespace sqlite {
+inline namespace v2 {
+    namespace detail {
+        bool stmt_step(sqlite3_stmt *stmt);
+        int stmt_column_count(sqlite3_stmt *stmt);
+        bool stmt_column_is_null(sqlite3_stmt *stmt, int idx);
+        std::int64_t stmt_column_int64(sqlite3_stmt *stmt, int idx);
+        double stmt_column_double(sqlite3_stmt *stmt, int idx);
+        std::string_view stmt_column_text(sqlite3_stmt *stmt, int idx);
+        std::span<const unsigned char> stmt_column_blob(sqlite3_stmt *stmt, int idx);
+        [[noreturn]] void throw_column_count_mismatch();
+
+        /// Column conversion shared by the typed cursors; mirrors @ref result::get.
+        template <typename T> T read_column(sqlite3_stmt *stmt, int idx) {
+            using decayed = decay_t<T>;
+            if constexpr (is_optional_v<decayed>) {
+                if (stmt_column_is_null(stmt, idx)) {
+                    return std::nullopt;
+                }
+                return read_column<typename optional_value<decayed>::type>(stmt, idx);
+            } else if constexpr (is_duration_v<decayed>) {
+                auto micros = std::chrono::microseconds{stmt_column_int64(stmt, idx)};
+                return std::chrono::duration_cast<decayed>(micros);
+            } else if constexpr (is_time_point_v<decayed>) {
+                auto micros = std::chrono::microseconds{stmt_column_int64(stmt, idx)};
+                return decayed(std::chrono::duration_cast<typename decayed::duration>(micros));
+            } else if constexpr (std::is_enum_v<decayed>) {
+                return static_cast<decayed>(stmt_column_int64(stmt, idx));
+            } else if constexpr (std::is_same_v<decayed, bool>) {
+                return stmt_column_int64(stmt, idx) != 0;
+            } else if constexpr (std::is_integral_v<decayed>) {
+                return static_cast<decayed>(stmt_column_int64(stmt, idx));
+            } else if constexpr (std::is_floating_point_v<decayed>) {
+                return static_cast<decayed>(stmt_column_double(stmt, idx));
+            } else if constexpr (std::is_same_v<decayed, std::string_view>) {
+                return stmt_column_text(stmt, idx);
+            } else if constexpr (std::is_same_v<decayed, std::string>) {
+                return std::string(stmt_column_text(stmt, idx));
+            } else if constexpr (is_unsigned_char_span_v<decayed>) {
+                return stmt_column_blob(stmt, idx);
+            } else if constexpr (is_byte_span_v<decayed>) {
+                auto blob = stmt_column_blob(stmt, idx);
+                return std::span<const std::byte>(reinterpret_cast<std::byte const *>(blob.data()),
+                                                  blob.size());
+            } else if constexpr (is_byte_vector_v<decayed>) {
+                auto blob = stmt_column_blob(stmt, idx);
+                return std::vector<unsigned char>(blob.begin(), blob.end());
+            } else {
+                static_assert(always_false_v<decayed>, "Unsupported type for sqlite::typed_rows");
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief Input range of typed rows over a borrowed statement.
+     *
+     * Each row is returned by value: a `std::tuple<Ts...>` (or plain `T` for a single column),
+     * so structured bindings work directly. `std::string_view` and span columns point into
+     * SQLite's buffers and are only valid until the iterator advances. The owning query must
+     * outlive the range and must not be stepped through another interface meanwhile.
+     */
+    template <typename... Ts> class typed_rows {
+        static_assert(sizeof...(Ts) > 0, "typed_rows needs at least one column type");
+
+    public:
+        using value_type = std::conditional_t<sizeof...(Ts) == 1,
+                                              std::tuple_element_t<0, std::tuple<Ts...>>,
+                                              std::tuple<Ts...>>;
+
+        struct sentinel {};
+
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = typed_rows::value_type;
+            using difference_type   = std::ptrdiff_t;
+
+            iterator() = default;
+            explicit iterator(sqlite3_stmt *stmt) : stmt_(stmt), done_(!detail::stmt_step(stmt)) {}
+
+            value_type operator*() const {
+                return read(std::index_sequence_for<Ts...>{});
+            }
+
+            iterator &operator++() {
+                done_ = !detail::stmt_step(stmt_);
+                return *this;
+            }
+
+            void operator++(int) {
+                ++*this;
+            }
+
+            friend bool operator==(iterator const &it, sentinel) noexcept {
+                return it.done_;
+            }
+
+        private:
+            template <std::size_t... Index> value_type read(std::index_sequence<Index...>) const {
+                if constexpr (sizeof...(Ts) == 1) {
+                    return detail::read_column<value_type>(stmt_, 0);
+                } else {
+                    return value_type(detail::read_column<Ts>(stmt_, static_cast<int>(Index))...);
+                }
+            }
+
+            sqlite3_stmt *stmt_ = nullptr;
+            bool done_          = true;
+        };
+
+        explicit typed_rows(sqlite3_stmt *stmt) : stmt_(stmt) {
+            if (detail::stmt_column_count(stmt_) < static_cast<int>(sizeof...(Ts))) {
+                detail::throw_column_count_mismatch();
+            }
+        }
+
+        /// Executes the first step; call once per range.
+        iterator begin() {
+            return iterator(stmt_);
+        }
+
+        sentinel end() const noexcept {
+            return {};
+        }
+
+    private:
+        sqlite3_stmt *stmt_;
+    };
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_TYPED_ROWS_HPP_INCLUDED
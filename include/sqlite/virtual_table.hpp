@@ -0,0 +1,643 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#ifndef GUARD_SQLITE_VIRTUAL_TABLE_HPP_INCLUDED
+#define GUARD_SQLITE_VIRTUAL_TABLE_HPP_INCLUDED
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sqlite/database_exception.hpp>
+#include <sqlite/function.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/struct_mapping.hpp>
+
+#include <sqlite3.h>
+
+/**
+ * @file sqlite/virtual_table.hpp
+ * @brief Read-only virtual tables backed by C++ cursors, plus a zero-copy `std::vector` adapter.
+ *
+ * `create_module<Cursor>()` generates the `sqlite3_module` glue for a cursor type: schema
+ * declaration, constraint negotiation in `xBestIndex`, typed constraint values in `xFilter`, and
+ * typed results in `xColumn`. Modules are eponymous, so `SELECT * FROM name` works without
+ * `CREATE VIRTUAL TABLE`.
+ */
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    /// Comparison operators negotiated through `xBestIndex`.
+    enum class constraint_op { eq, gt, ge, lt, le };
+
+    /// How a cursor uses a constraint offered by SQLite.
+    enum class constraint_use {
+        ignore, ///< Not passed to the cursor.
+        hint,   ///< Passed to @c filter; SQLite still checks every returned row.
+        exact   ///< Passed to @c filter, which guarantees it; SQLite skips the check.
+    };
+
+    /// A constraint as seen by `xBestIndex`; column -1 is the rowid.
+    struct index_constraint {
+        int column;
+        constraint_op op;
+    };
+
+    /// A negotiated constraint with its right-hand value, as passed to the cursor's @c filter.
+    struct constraint {
+        int column;
+        constraint_op op;
+        sqlite3_value *value;
+
+        bool is_null() const noexcept {
+            return sqlite3_value_type(value) == SQLITE_NULL;
+        }
+
+        /// SQLite storage class of the value (`SQLITE_INTEGER`, `SQLITE_TEXT`, ...).
+        int type() const noexcept {
+            return sqlite3_value_type(value);
+        }
+
+        /// Converts the value with the same rules as SQL function arguments.
+        template <typename T> T as() const {
+            return detail::argument_converter<detail::decay_t<T>>::convert(value);
+        }
+    };
+
+    /// Typed setter for the value of one column of the current row.
+    class column_result {
+    public:
+        explicit column_result(sqlite3_context *ctx) noexcept : ctx_(ctx) {}
+
+        template <typename T> void set(T const &value) {
+            detail::result_writer<detail::decay_t<T>>::apply(ctx_, value);
+        }
+
+        void set_null() {
+            sqlite3_result_null(ctx_);
+        }
+
+        /// Text that stays valid and unchanged while the statement runs; not copied.
+        void set_static(std::string_view text) {
+            sqlite3_result_text(ctx_, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+        }
+
+        /// Blob that stays valid and unchanged while the statement runs; not copied.
+        void set_static(std::span<const unsigned char> blob) {
+            sqlite3_result_blob(ctx_, blob.data(), static_cast<int>(blob.size()), SQLITE_STATIC);
+        }
+
+        sqlite3_context *native_handle() const noexcept {
+            return ctx_;
+        }
+
+    private:
+        sqlite3_context *ctx_;
+    };
+
+    /**
+     * @brief Requirements for a cursor type exposed through @ref create_module.
+     *
+     * `context_type` is the module-wide state handed to @ref create_module; every cursor is
+     * constructed from a reference to it. `schema()` returns the `CREATE TABLE` statement given
+     * to `sqlite3_declare_vtab`. `filter()` positions the cursor on the first row matching the
+     * negotiated constraints. A cursor may also provide
+     * `static constraint_use accepts(context_type const &, index_constraint)` to opt into
+     * constraints (the default ignores them all), and
+     * `static double estimate(context_type const &, std::span<index_constraint const>)` to
+     * cost a plan. Exceptions thrown by any of these become SQLite errors; `eof()` is checked
+     * right after `filter()` and `next()`, so its errors are reported by those calls.
+     */
+    template <typename C>
+    concept virtual_table_cursor =
+        requires(C &cursor, C const &ccursor, typename C::context_type &ctx,
+                 std::span<constraint const> constraints, column_result &out, int column) {
+            { C::schema(std::as_const(ctx)) } -> std::convertible_to<std::string>;
+            C(ctx);
+            cursor.filter(constraints);
+            cursor.next();
+            { ccursor.eof() } -> std::convertible_to<bool>;
+            { ccursor.rowid() } -> std::convertible_to<std::int64_t>;
+            ccursor.column(out, column);
+        };
+
+    namespace detail {
+        template <typename Cursor> struct module_holder {
+            typename Cursor::context_type context;
+        };
+
+        template <typename Cursor> struct vtab_instance : sqlite3_vtab {
+            explicit vtab_instance(typename Cursor::context_type &ctx) :
+                sqlite3_vtab{}, context(ctx) {}
+            typename Cursor::context_type &context;
+        };
+
+        template <typename Cursor> struct cursor_instance : sqlite3_vtab_cursor {
+            explicit cursor_instance(typename Cursor::context_type &ctx) :
+                sqlite3_vtab_cursor{}, cursor(ctx) {}
+            Cursor cursor;
+            std::vector<constraint> constraints;
+            bool at_end = true; ///< eof() as of the last filter/next; xEof cannot report errors.
+        };
+
+        inline std::optional<constraint_op> to_constraint_op(unsigned char op) {
+            switch (op) {
+            case SQLITE_INDEX_CONSTRAINT_EQ:
+                return constraint_op::eq;
+            case SQLITE_INDEX_CONSTRAINT_GT:
+                return constraint_op::gt;
+            case SQLITE_INDEX_CONSTRAINT_GE:
+                return constraint_op::ge;
+            case SQLITE_INDEX_CONSTRAINT_LT:
+                return constraint_op::lt;
+            case SQLITE_INDEX_CONSTRAINT_LE:
+                return constraint_op::le;
+            default:
+                return std::nullopt;
+            }
+        }
+
+        inline void set_vtab_error(sqlite3_vtab *vtab, char const *message) {
+            sqlite3_free(vtab->zErrMsg);
+            vtab->zErrMsg = sqlite3_mprintf("%s", message);
+        }
+
+        /// Default cost: a full scan of a million rows, cut down by each usable constraint.
+        inline double default_estimate(std::span<index_constraint const> used) {
+            double cost = 1e6;
+            for (auto const &c : used) {
+                cost /= c.op == constraint_op::eq ? 100.0 : 4.0;
+            }
+            return std::max(cost, 1.0);
+        }
+
+        template <typename Cursor>
+        int vtab_connect(sqlite3 *db, void *aux, int, char const *const *, sqlite3_vtab **out,
+                         char **error) {
+            auto *holder = static_cast<module_holder<Cursor> *>(aux);
+            try {
+                std::string schema = Cursor::schema(std::as_const(holder->context));
+                int rc             = sqlite3_declare_vtab(db, schema.c_str());
+                if (rc != SQLITE_OK) {
+                    *error = sqlite3_mprintf("%s", sqlite3_errmsg(db));
+                    return rc;
+                }
+                *out = new vtab_instance<Cursor>(holder->context);
+                return SQLITE_OK;
+            } catch (std::exception const &ex) {
+                *error = sqlite3_mprintf("%s", ex.what());
+                return SQLITE_ERROR;
+            }
+        }
+
+        template <typename Cursor> int vtab_disconnect(sqlite3_vtab *vtab) {
+            delete static_cast<vtab_instance<Cursor> *>(vtab);
+            return SQLITE_OK;
+        }
+
+        template <typename Cursor>
+        int vtab_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+            auto &context = static_cast<vtab_instance<Cursor> *>(vtab)->context;
+            try {
+                std::vector<index_constraint> used;
+                std::string plan; // "column:op;" per argv slot, decoded again in xFilter
+                for (int i = 0; i < info->nConstraint; ++i) {
+                    auto const &offered = info->aConstraint[i];
+                    auto op             = to_constraint_op(offered.op);
+                    if (!offered.usable || !op) {
+                        continue;
+                    }
+                    // Cursors compare bytewise; leave other collations to SQLite.
+                    char const *collation = sqlite3_vtab_collation(info, i);
+                    if (collation != nullptr && sqlite3_stricmp(collation, "BINARY") != 0) {
+                        continue;
+                    }
+                    index_constraint candidate{offered.iColumn, *op};
+                    auto use = constraint_use::ignore;
+                    if constexpr (requires {
+                                      Cursor::accepts(std::as_const(context), candidate);
+                                  }) {
+                        use = Cursor::accepts(std::as_const(context), candidate);
+                    }
+                    if (use == constraint_use::ignore) {
+                        continue;
+                    }
+                    used.push_back(candidate);
+                    info->aConstraintUsage[i].argvIndex = static_cast<int>(used.size());
+                    info->aConstraintUsage[i].omit      = use == constraint_use::exact;
+                    plan += std::to_string(candidate.column) + ':' +
+                            std::to_string(static_cast<int>(candidate.op)) + ';';
+                }
+                std::span<index_constraint const> negotiated(used);
+                double cost = 0.0;
+                if constexpr (requires { Cursor::estimate(std::as_const(context), negotiated); }) {
+                    cost = Cursor::estimate(std::as_const(context), negotiated);
+                } else {
+                    cost = default_estimate(used);
+                }
+                info->estimatedCost = cost;
+                info->estimatedRows = static_cast<sqlite3_int64>(cost);
+                if (!plan.empty()) {
+                    info->idxStr           = sqlite3_mprintf("%s", plan.c_str());
+                    info->needToFreeIdxStr = 1;
+                }
+                return SQLITE_OK;
+            } catch (std::exception const &ex) {
+                set_vtab_error(vtab, ex.what());
+                return SQLITE_ERROR;
+            }
+        }
+
+        template <typename Cursor> int vtab_open(sqlite3_vtab *vtab, sqlite3_vtab_cursor **out) {
+            try {
+                auto &context = static_cast<vtab_instance<Cursor> *>(vtab)->context;
+                *out          = new cursor_instance<Cursor>(context);
+                return SQLITE_OK;
+            } catch (std::exception const &ex) {
+                set_vtab_error(vtab, ex.what());
+                return SQLITE_ERROR;
+            }
+        }
+
+        template <typename Cursor> int vtab_close(sqlite3_vtab_cursor *cursor) {
+            delete static_cast<cursor_instance<Cursor> *>(cursor);
+            return SQLITE_OK;
+        }
+
+        template <typename Cursor>
+        int vtab_filter(sqlite3_vtab_cursor *base, int, char const *plan, int argc,
+                        sqlite3_value **argv) {
+            auto &instance  = *static_cast<cursor_instance<Cursor> *>(base);
+            instance.at_end = true;
+            try {
+                instance.constraints.clear();
+                for (int i = 0; plan != nullptr && *plan != '\0' && i < argc; ++i) {
+                    char *next = nullptr;
+                    int column = static_cast<int>(std::strtol(plan, &next, 10));
+                    int op     = static_cast<int>(std::strtol(next + 1, &next, 10));
+                    plan       = next + 1;
+                    instance.constraints.push_back(
+                        {column, static_cast<constraint_op>(op), argv[i]});
+                }
+                instance.cursor.filter(std::span<constraint const>(instance.constraints));
+                instance.at_end = std::as_const(instance.cursor).eof();
+                return SQLITE_OK;
+            } catch (std::exception const &ex) {
+                set_vtab_error(base->pVtab, ex.what());
+                return SQLITE_ERROR;
+            }
+        }
+
+        template <typename Cursor> int vtab_next(sqlite3_vtab_cursor *base) {
+            auto &instance  = *static_cast<cursor_instance<Cursor> *>(base);
+            instance.at_end = true;
+            try {
+                instance.cursor.next();
+                instance.at_end = std::as_const(instance.cursor).eof();
+                return SQLITE_OK;
+            } catch (std::exception const &ex) {
+                set_vtab_error(base->pVtab, ex.what());
+                return SQLITE_ERROR;
+            }
+        }
+
+        template <typename Cursor> int vtab_eof(sqlite3_vtab_cursor *base) {
+            return static_cast<cursor_instance<Cursor> *>(base)->at_end ? 1 : 0;
+        }
+
+        template <typename Cursor>
+        int vtab_column(sqlite3_vtab_cursor *base, sqlite3_context *ctx, int column) {
+            try {
+                auto const &cursor = static_cast<cursor_instance<Cursor> *>(base)->cursor;
+                column_result out(ctx);
+                cursor.column(out, column);
+            } catch (std::exception const &ex) {
+                sqlite3_result_error(ctx, ex.what(), -1);
+            }
+            return SQLITE_OK;
+        }
+
+        template <typename Cursor> int vtab_rowid(sqlite3_vtab_cursor *base, sqlite3_int64 *rowid) {
+            try {
+                *rowid = static_cast<sqlite3_int64>(
+                    std::as_const(static_cast<cursor_instance<Cursor> *>(base)->cursor).rowid());
+                return SQLITE_OK;
+            } catch (std::exception const &ex) {
+                set_vtab_error(base->pVtab, ex.what());
+                return SQLITE_ERROR;
+            }
+        }
+
+        template <typename Cursor> sqlite3_module const &module_for() {
+            static sqlite3_module const module = [] {
+                sqlite3_module m{};
+                m.iVersion    = 1;
+                m.xCreate     = &vtab_connect<Cursor>;
+                m.xConnect    = &vtab_connect<Cursor>;
+                m.xBestIndex  = &vtab_best_index<Cursor>;
+                m.xDisconnect = &vtab_disconnect<Cursor>;
+                m.xDestroy    = &vtab_disconnect<Cursor>;
+                m.xOpen       = &vtab_open<Cursor>;
+                m.xClose      = &vtab_close<Cursor>;
+                m.xFilter     = &vtab_filter<Cursor>;
+                m.xNext       = &vtab_next<Cursor>;
+                m.xEof        = &vtab_eof<Cursor>;
+                m.xColumn     = &vtab_column<Cursor>;
+                m.xRowid      = &vtab_rowid<Cursor>;
+                return m;
+            }();
+            return module;
+        }
+
+        template <typename Cursor> void destroy_module_holder(void *data) {
+            delete static_cast<module_holder<Cursor> *>(data);
+        }
+    } // namespace detail
+
+    /**
+     * @brief Registers @p Cursor as the read-only, eponymous module @p name on @p con.
+     *
+     * @p context is moved into the module and lives until the module is replaced or the
+     * connection closes. Whatever it refers to must stay valid and unmodified while statements
+     * read from the table.
+     */
+    template <virtual_table_cursor Cursor>
+    void create_module(connection &con, std::string_view name,
+                       typename Cursor::context_type context = {}) {
+        auto holder = std::make_unique<detail::module_holder<Cursor>>(
+            detail::module_holder<Cursor>{std::move(context)});
+        private_accessor::acccess_check(con);
+        auto handle = private_accessor::get_handle(con);
+        std::string name_buffer(name);
+        // SQLite owns the holder from here on and destroys it even if registration fails.
+        int rc = sqlite3_create_module_v2(handle, name_buffer.c_str(),
+                                          &detail::module_for<Cursor>(), holder.release(),
+                                          &detail::destroy_module_holder<Cursor>);
+        if (rc != SQLITE_OK) {
+            throw database_exception_code(sqlite3_errmsg(handle), rc);
+        }
+    }
+
+    namespace detail {
+        template <typename T> constexpr std::string_view declared_type() {
+            using value_type = decay_t<T>;
+            if constexpr (is_optional<value_type>::value) {
+                return declared_type<typename value_type::value_type>();
+            } else if constexpr (std::is_integral_v<value_type>) {
+                return "INTEGER";
+            } else if constexpr (std::is_floating_point_v<value_type>) {
+                return "REAL";
+            } else if constexpr (std::is_convertible_v<value_type const &, std::string_view>) {
+                return "TEXT";
+            } else {
+                return "BLOB";
+            }
+        }
+
+        template <typename T> void set_field(column_result &out, T const &value) {
+            if constexpr (is_optional<T>::value) {
+                if (!value) {
+                    out.set_null();
+                } else {
+                    set_field(out, *value);
+                }
+            } else if constexpr (std::is_convertible_v<T const &, std::string_view>) {
+                out.set_static(std::string_view(value));
+            } else if constexpr (std::is_same_v<T, std::vector<unsigned char>>) {
+                out.set_static(std::span<const unsigned char>(value));
+            } else {
+                out.set(value);
+            }
+        }
+    } // namespace detail
+
+    /// Rows and layout of a @ref vector_table.
+    template <described_struct T> struct vector_table_source {
+        std::vector<T> const *rows = nullptr;
+        /// Rows are sorted ascending by their first field, enabling binary search on it.
+        bool sorted_by_key = false;
+    };
+
+    /**
+     * @brief Cursor exposing a `std::vector` of described structs as a table, without copying.
+     *
+     * Columns follow the `VSQLITE_FIELDS` order and names; text and blob fields are returned as
+     * static pointers into the vector. The rowid is the 1-based position. Constraints on the
+     * rowid, and on the first field when the rows are sorted by it, narrow the scanned range by
+     * binary search. They are used as hints, so SQLite's own comparison stays authoritative.
+     */
+    template <described_struct T> class vector_table {
+    public:
+        using context_type = vector_table_source<T>;
+
+        explicit vector_table(context_type &source) : source_(source) {}
+
+        static std::string schema(context_type const &) {
+            std::string sql = "CREATE TABLE x(";
+            std::size_t index = 0;
+            std::apply(
+                [&](auto const &...field) {
+                    ((sql += (index++ ? ", \"" : "\"") + escape(field.name) + "\" " +
+                             std::string(detail::declared_type<
+                                         typename std::decay_t<decltype(field)>::value_type>())),
+                     ...);
+                },
+                describe<T>().fields);
+            return sql + ")";
+        }
+
+        static constraint_use accepts(context_type const &source, index_constraint c) {
+            bool key = c.column == 0 && source.sorted_by_key && key_searchable;
+            return c.column == -1 || key ? constraint_use::hint : constraint_use::ignore;
+        }
+
+        static double estimate(context_type const &source, std::span<index_constraint const> used) {
+            double rows = source.rows ? static_cast<double>(source.rows->size()) : 0.0;
+            for (auto const &c : used) {
+                rows /= c.op == constraint_op::eq ? std::max(rows, 1.0) : 4.0;
+            }
+            return std::max(rows, 1.0);
+        }
+
+        void filter(std::span<constraint const> constraints) {
+            auto const &rows = *source_.rows;
+            pos_             = 0;
+            end_             = rows.size();
+            for (auto const &c : constraints) {
+                if (c.is_null()) { // comparisons with NULL never match
+                    end_ = pos_;
+                } else if (c.column == -1) {
+                    narrow_rowid(c);
+                } else {
+                    narrow_key(c);
+                }
+            }
+            if (pos_ > end_) {
+                pos_ = end_;
+            }
+        }
+
+        void next() {
+            ++pos_;
+        }
+
+        bool eof() const {
+            return pos_ >= end_;
+        }
+
+        std::int64_t rowid() const {
+            return static_cast<std::int64_t>(pos_) + 1;
+        }
+
+        void column(column_result &out, int index) const {
+            auto const &row = (*source_.rows)[pos_];
+            int current     = 0;
+            std::apply(
+                [&](auto const &...field) {
+                    ((current++ == index ? detail::set_field(out, row.*field.member) : void()),
+                     ...);
+                },
+                describe<T>().fields);
+        }
+
+    private:
+        using key_type = detail::decay_t<std::remove_reference_t<
+            std::tuple_element_t<0, decltype(tie_fields(std::declval<T const &>()))>>>;
+
+        static constexpr bool key_integral =
+            std::is_integral_v<key_type> && !std::is_same_v<key_type, bool>;
+        static constexpr bool key_numeric    = key_integral || std::is_floating_point_v<key_type>;
+        static constexpr bool key_text       = std::is_same_v<key_type, std::string>;
+        static constexpr bool key_searchable = key_numeric || key_text;
+
+        // Probes are read at full width so narrow key types never see a truncated value.
+        using probe_type = std::conditional_t<
+            key_integral, std::int64_t,
+            std::conditional_t<std::is_floating_point_v<key_type>, double, std::string_view>>;
+
+        static bool less(auto const &lhs, auto const &rhs) {
+            if constexpr (key_integral) {
+                return std::cmp_less(lhs, rhs);
+            } else {
+                return lhs < rhs;
+            }
+        }
+
+        static std::string escape(std::string_view name) {
+            std::string out;
+            for (char c : name) {
+                out += c == '"' ? "\"\"" : std::string(1, c);
+            }
+            return out;
+        }
+
+        // Bounds are widened to be inclusive, so truncated numeric probes (2.5 -> 2) still
+        // select a superset of the matching rows.
+        void narrow_rowid(constraint const &c) {
+            if (c.type() != SQLITE_INTEGER && c.type() != SQLITE_FLOAT) {
+                return;
+            }
+            auto value = c.as<std::int64_t>();
+            auto index = value < 1 ? std::size_t{0} : static_cast<std::size_t>(value - 1);
+            switch (c.op) {
+            case constraint_op::eq:
+                pos_ = std::max(pos_, index);
+                end_ = std::min(end_, value < 1 ? std::size_t{0} : index + 1);
+                break;
+            case constraint_op::gt:
+            case constraint_op::ge:
+                pos_ = std::max(pos_, index);
+                break;
+            case constraint_op::lt:
+            case constraint_op::le:
+                end_ = std::min(end_, value < 1 ? std::size_t{0} : index + 1);
+                break;
+            }
+        }
+
+        void narrow_key(constraint const &c) {
+            if constexpr (key_searchable) {
+                bool comparable = key_numeric
+                                      ? (c.type() == SQLITE_INTEGER || c.type() == SQLITE_FLOAT)
+                                      : c.type() == SQLITE_TEXT;
+                if (!comparable) {
+                    return;
+                }
+                auto const &rows = *source_.rows;
+                auto probe       = c.as<probe_type>();
+                auto key_less    = [](T const &row, probe_type const &key) {
+                    return less(std::get<0>(tie_fields(row)), key);
+                };
+                auto key_greater = [](probe_type const &key, T const &row) {
+                    return less(key, std::get<0>(tie_fields(row)));
+                };
+                auto lower = static_cast<std::size_t>(
+                    std::lower_bound(rows.begin(), rows.end(), probe, key_less) - rows.begin());
+                auto upper = static_cast<std::size_t>(
+                    std::upper_bound(rows.begin(), rows.end(), probe, key_greater) - rows.begin());
+                if (c.op != constraint_op::lt && c.op != constraint_op::le) {
+                    pos_ = std::max(pos_, lower);
+                }
+                if (c.op != constraint_op::gt && c.op != constraint_op::ge) {
+                    end_ = std::min(end_, upper);
+                }
+            }
+        }
+
+        context_type &source_;
+        std::size_t pos_ = 0;
+        std::size_t end_ = 0;
+    };
+
+    /// Exposes @p rows as the eponymous table @p name; @p rows must outlive the connection's use.
+    template <described_struct T>
+    void create_vector_table(connection &con, std::string_view name, std::vector<T> const &rows,
+                             bool sorted_by_key = false) {
+        create_module<vector_table<T>>(con, name, vector_table_source<T>{&rows, sorted_by_key});
+    }
+} // namespace v2
+} // namespace sqlite
+
+#endif // GUARD_SQLITE_VIRTUAL_TABLE_HPP_INCLUDED
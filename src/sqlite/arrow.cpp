@@ -0,0 +1,399 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/arrow.hpp>
+#include <sqlite/column_batch.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <string_view>
+#include <variant>
+
+namespace sqlite {
+inline namespace v2 {
+    namespace {
+        using column_data = std::variant<fixed_column<std::int64_t>, fixed_column<double>,
+                                         text_column, blob_column>;
+
+        // Arrow requires non-null data buffers; empty vectors hand out this instead.
+        alignas(8) std::int64_t const empty_buffer[1] = {0};
+
+        template <typename T> void const *buffer_of(std::vector<T> const &v) {
+            return v.empty() ? static_cast<void const *>(empty_buffer) : v.data();
+        }
+
+        void const *buffer_of(validity_bitmap const &bits) {
+            return bits.null_count() == 0 ? nullptr : bits.data();
+        }
+
+        char const *format_of(arrow_type type) {
+            switch (type) {
+            case arrow_type::int64:
+                return "l";
+            case arrow_type::float64:
+                return "g";
+            case arrow_type::large_utf8:
+                return "U";
+            case arrow_type::large_binary:
+                return "Z";
+            }
+            return "U";
+        }
+
+        std::optional<arrow_type> declared_type(char const *decltype_name) {
+            if (!decltype_name || !*decltype_name) {
+                return std::nullopt;
+            }
+            std::string upper(decltype_name);
+            std::transform(upper.begin(), upper.end(), upper.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+            auto has = [&](char const *token) { return upper.find(token) != std::string::npos; };
+            // SQLite's column affinity rules, in their documented order of precedence.
+            if (has("INT")) {
+                return arrow_type::int64;
+            }
+            if (has("CHAR") || has("CLOB") || has("TEXT")) {
+                return arrow_type::large_utf8;
+            }
+            if (has("BLOB")) {
+                return arrow_type::large_binary;
+            }
+            if (has("REAL") || has("FLOA") || has("DOUB")) {
+                return arrow_type::float64;
+            }
+            return std::nullopt;
+        }
+
+        std::optional<arrow_type> storage_type(int sqlite_type) {
+            switch (sqlite_type) {
+            case SQLITE_INTEGER:
+                return arrow_type::int64;
+            case SQLITE_FLOAT:
+                return arrow_type::float64;
+            case SQLITE_TEXT:
+                return arrow_type::large_utf8;
+            case SQLITE_BLOB:
+                return arrow_type::large_binary;
+            default:
+                return std::nullopt;
+            }
+        }
+
+        column_data make_storage(arrow_type type) {
+            switch (type) {
+            case arrow_type::int64:
+                return fixed_column<std::int64_t>{};
+            case arrow_type::float64:
+                return fixed_column<double>{};
+            case arrow_type::large_utf8:
+                return text_column{};
+            case arrow_type::large_binary:
+                return blob_column{};
+            }
+            return text_column{};
+        }
+
+        struct schema_holder {
+            std::string name;
+            std::vector<ArrowSchema> children;
+            std::vector<ArrowSchema *> child_ptrs;
+        };
+
+        void release_schema(ArrowSchema *schema) {
+            if (!schema || !schema->release) {
+                return;
+            }
+            for (std::int64_t i = 0; i < schema->n_children; ++i) {
+                ArrowSchema *child = schema->children[i];
+                if (child->release) {
+                    child->release(child);
+                }
+            }
+            delete static_cast<schema_holder *>(schema->private_data);
+            schema->release = nullptr;
+        }
+
+        void init_schema(ArrowSchema *out, char const *format, schema_holder *holder,
+                         std::int64_t flags) {
+            out->format       = format;
+            out->name         = holder->name.c_str();
+            out->metadata     = nullptr;
+            out->flags        = flags;
+            out->n_children   = static_cast<std::int64_t>(holder->child_ptrs.size());
+            out->children     = holder->child_ptrs.empty() ? nullptr : holder->child_ptrs.data();
+            out->dictionary   = nullptr;
+            out->release      = &release_schema;
+            out->private_data = holder;
+        }
+
+        struct array_holder {
+            column_data data;
+            void const *buffers[3] = {nullptr, nullptr, nullptr};
+            std::vector<ArrowArray> children;
+            std::vector<ArrowArray *> child_ptrs;
+        };
+
+        void release_array(ArrowArray *array) {
+            if (!array || !array->release) {
+                return;
+            }
+            for (std::int64_t i = 0; i < array->n_children; ++i) {
+                ArrowArray *child = array->children[i];
+                if (child->release) {
+                    child->release(child);
+                }
+            }
+            delete static_cast<array_holder *>(array->private_data);
+            array->release = nullptr;
+        }
+
+        void export_column(ArrowArray *out, column_data data) {
+            auto holder     = new array_holder{};
+            holder->data    = std::move(data);
+            out->offset     = 0;
+            out->n_children = 0;
+            out->children   = nullptr;
+            out->dictionary = nullptr;
+            std::visit(
+                [&](auto &col) {
+                    using column_type  = std::decay_t<decltype(col)>;
+                    out->length        = static_cast<std::int64_t>(col.size());
+                    out->null_count    = static_cast<std::int64_t>(col.validity.null_count());
+                    holder->buffers[0] = buffer_of(col.validity);
+                    if constexpr (std::is_same_v<column_type, text_column> ||
+                                  std::is_same_v<column_type, blob_column>) {
+                        out->n_buffers     = 3;
+                        holder->buffers[1] = col.offsets.data();
+                        holder->buffers[2] = buffer_of(col.arena);
+                    } else {
+                        out->n_buffers     = 2;
+                        holder->buffers[1] = buffer_of(col.values);
+                    }
+                },
+                holder->data);
+            out->buffers      = holder->buffers;
+            out->release      = &release_array;
+            out->private_data = holder;
+        }
+    } // namespace
+
+    class arrow_exporter::column_builder {
+    public:
+        explicit column_builder(std::optional<arrow_type> declared) : type_(declared) {
+            if (type_) {
+                data_ = make_storage(*type_);
+            }
+        }
+
+        bool resolved() const noexcept {
+            return type_.has_value();
+        }
+
+        arrow_type type() const noexcept {
+            return *type_;
+        }
+
+        void append(sqlite3_stmt *stmt, int idx) {
+            int storage = sqlite3_column_type(stmt, idx);
+            if (!type_) {
+                if (storage == SQLITE_NULL) {
+                    ++pending_nulls_;
+                    return;
+                }
+                resolve(*storage_type(storage));
+            }
+            bool valid = storage != SQLITE_NULL;
+            std::visit(
+                [&](auto &col) {
+                    using column_type = std::decay_t<decltype(col)>;
+                    if constexpr (std::is_same_v<column_type, text_column>) {
+                        auto text = valid ? detail::stmt_column_text(stmt, idx) : std::string_view{};
+                        col.push_back(std::span<const char>(text.data(), text.size()), valid);
+                    } else if constexpr (std::is_same_v<column_type, blob_column>) {
+                        col.push_back(valid ? detail::stmt_column_blob(stmt, idx)
+                                            : std::span<const unsigned char>{},
+                                      valid);
+                    } else if constexpr (std::is_same_v<column_type, fixed_column<double>>) {
+                        col.values.push_back(sqlite3_column_double(stmt, idx));
+                        col.validity.push_back(valid);
+                    } else {
+                        col.values.push_back(sqlite3_column_int64(stmt, idx));
+                        col.validity.push_back(valid);
+                    }
+                },
+                data_);
+        }
+
+        /// Fixes the column type and back-fills the NULLs seen before the first value.
+        void resolve(arrow_type type) {
+            type_ = type;
+            data_ = make_storage(type);
+            std::visit(
+                [&](auto &col) {
+                    using column_type = std::decay_t<decltype(col)>;
+                    for (; pending_nulls_ > 0; --pending_nulls_) {
+                        if constexpr (std::is_same_v<column_type, text_column> ||
+                                      std::is_same_v<column_type, blob_column>) {
+                            col.push_back({}, false);
+                        } else {
+                            col.values.emplace_back();
+                            col.validity.push_back(false);
+                        }
+                    }
+                },
+                data_);
+        }
+
+        /// Hands the filled buffers over and starts a fresh column of the same type.
+        column_data take() {
+            column_data out = std::move(data_);
+            data_           = make_storage(*type_);
+            return out;
+        }
+
+    private:
+        std::optional<arrow_type> type_;
+        std::size_t pending_nulls_ = 0;
+        column_data data_;
+    };
+
+    arrow_exporter::arrow_exporter(query &q, arrow_export_options options) :
+        options_(options), stmt_(nullptr) {
+        if (options_.batch_size == 0) {
+            throw database_exception("arrow_exporter batch_size must be positive");
+        }
+        stmt_       = private_accessor::get_statement(q);
+        int columns = sqlite3_column_count(stmt_);
+        names_.reserve(static_cast<std::size_t>(columns));
+        builders_.reserve(static_cast<std::size_t>(columns));
+        bool all_declared = true;
+        for (int i = 0; i < columns; ++i) {
+            char const *name = sqlite3_column_name(stmt_, i);
+            names_.emplace_back(name ? name : "");
+            auto declared = declared_type(sqlite3_column_decltype(stmt_, i));
+            all_declared  = all_declared && declared.has_value();
+            builders_.emplace_back(declared);
+        }
+        if (all_declared) {
+            for (auto &builder : builders_) {
+                types_.push_back(builder.type());
+            }
+            inferred_ = true;
+        }
+    }
+
+    arrow_exporter::~arrow_exporter() = default;
+
+    bool arrow_exporter::fill_batch() {
+        batch_rows_ = 0;
+        int columns = static_cast<int>(builders_.size());
+        while (!done_ && batch_rows_ < options_.batch_size) {
+            int rc = sqlite3_step(stmt_);
+            if (rc == SQLITE_DONE) {
+                done_ = true;
+            } else if (rc == SQLITE_ROW) {
+                for (int i = 0; i < columns; ++i) {
+                    builders_[static_cast<std::size_t>(i)].append(stmt_, i);
+                }
+                ++batch_rows_;
+            } else {
+                throw database_exception_code(sqlite3_errmsg(sqlite3_db_handle(stmt_)), rc,
+                                              sqlite3_sql(stmt_));
+            }
+        }
+        if (!inferred_) {
+            for (auto &builder : builders_) {
+                if (!builder.resolved()) {
+                    builder.resolve(arrow_type::large_utf8);
+                }
+                types_.push_back(builder.type());
+            }
+            inferred_ = true;
+        }
+        return batch_rows_ > 0;
+    }
+
+    std::vector<arrow_type> const &arrow_exporter::types() {
+        if (!inferred_) {
+            pending_ = fill_batch();
+        }
+        return types_;
+    }
+
+    std::vector<std::string> const &arrow_exporter::names() const noexcept {
+        return names_;
+    }
+
+    void arrow_exporter::export_schema(ArrowSchema *out) {
+        auto const &column_types = types();
+        auto root                = new schema_holder{};
+        root->children.resize(column_types.size());
+        for (std::size_t i = 0; i < column_types.size(); ++i) {
+            auto child  = new schema_holder{};
+            child->name = names_[i];
+            init_schema(&root->children[i], format_of(column_types[i]), child, ARROW_FLAG_NULLABLE);
+            root->child_ptrs.push_back(&root->children[i]);
+        }
+        init_schema(out, "+s", root, 0);
+    }
+
+    bool arrow_exporter::export_next(ArrowArray *out) {
+        if (!pending_ && !fill_batch()) {
+            return false;
+        }
+        pending_  = false;
+        auto root = new array_holder{};
+        root->children.resize(builders_.size());
+        for (std::size_t i = 0; i < builders_.size(); ++i) {
+            export_column(&root->children[i], builders_[i].take());
+            root->child_ptrs.push_back(&root->children[i]);
+        }
+        out->length       = static_cast<std::int64_t>(batch_rows_);
+        out->null_count   = 0;
+        out->offset       = 0;
+        out->n_buffers    = 1;
+        out->n_children   = static_cast<std::int64_t>(root->child_ptrs.size());
+        out->buffers      = root->buffers;
+        out->children     = root->child_ptrs.empty() ? nullptr : root->child_ptrs.data();
+        out->dictionary   = nullptr;
+        out->release      = &release_array;
+        out->private_data = root;
+        return true;
+    }
+} // namespace v2
+} // namespace sqlite
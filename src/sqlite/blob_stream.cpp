@@ -0,0 +1,287 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/blob_stream.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace {
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    blob_stream::blob_stream(connection &con, std::string_view table, std::string_view column,
+                             std::int64_t rowid, blob_mode mode, std::string_view schema) :
+        con_(&con), handle_(nullptr), mode_(mode), rowid_(rowid), size_(0) {
+        sqlite3 *db = to_handle(con);
+        std::string schema_name(schema.empty() ? std::string_view("main") : schema);
+        std::string table_name(table);
+        std::string column_name(column);
+        int rc = sqlite3_blob_open(db, schema_name.c_str(), table_name.c_str(),
+                                   column_name.c_str(), rowid,
+                                   mode == blob_mode::read_write ? 1 : 0, &handle_);
+        if (rc != SQLITE_OK) {
+            // sqlite3_blob_open may hand back a handle even on failure.
+            sqlite3_blob_close(handle_);
+            handle_ = nullptr;
+            throw database_exception_code(sqlite3_errmsg(db), rc);
+        }
+        size_ = static_cast<std::size_t>(sqlite3_blob_bytes(handle_));
+    }
+
+    blob_stream::~blob_stream() {
+        close();
+    }
+
+    blob_stream::blob_stream(blob_stream &&other) noexcept :
+        con_(other.con_), handle_(std::exchange(other.handle_, nullptr)), mode_(other.mode_),
+        rowid_(other.rowid_), size_(std::exchange(other.size_, 0)) {}
+
+    blob_stream &blob_stream::operator=(blob_stream &&other) noexcept {
+        if (this != &other) {
+            close();
+            con_    = other.con_;
+            handle_ = std::exchange(other.handle_, nullptr);
+            mode_   = other.mode_;
+            rowid_  = other.rowid_;
+            size_   = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    void blob_stream::close() noexcept {
+        if (handle_) {
+            sqlite3_blob_close(handle_);
+            handle_ = nullptr;
+        }
+    }
+
+    void blob_stream::throw_error(int rc, char const *what) const {
+        if (!handle_) {
+            throw database_exception(std::string(what) + ": blob handle is closed");
+        }
+        throw database_exception_code(sqlite3_errmsg(private_accessor::get_handle(*con_)), rc);
+    }
+
+    std::size_t blob_stream::read(std::span<unsigned char> buffer, std::size_t offset) {
+        if (!handle_) {
+            throw_error(SQLITE_MISUSE, "blob_stream::read");
+        }
+        if (offset >= size_ || buffer.empty()) {
+            return 0;
+        }
+        std::size_t count = std::min(buffer.size(), size_ - offset);
+        int rc = sqlite3_blob_read(handle_, buffer.data(), static_cast<int>(count),
+                                   static_cast<int>(offset));
+        if (rc != SQLITE_OK) {
+            throw_error(rc, "blob_stream::read");
+        }
+        return count;
+    }
+
+    void blob_stream::write(std::span<const unsigned char> data, std::size_t offset) {
+        if (!handle_) {
+            throw_error(SQLITE_MISUSE, "blob_stream::write");
+        }
+        if (mode_ != blob_mode::read_write) {
+            throw database_exception("blob_stream::write: handle was opened read-only");
+        }
+        if (offset > size_ || data.size() > size_ - offset) {
+            throw database_exception("blob_stream::write: range exceeds the blob size");
+        }
+        if (data.empty()) {
+            return;
+        }
+        int rc = sqlite3_blob_write(handle_, data.data(), static_cast<int>(data.size()),
+                                    static_cast<int>(offset));
+        if (rc != SQLITE_OK) {
+            throw_error(rc, "blob_stream::write");
+        }
+    }
+
+    void blob_stream::reopen(std::int64_t rowid) {
+        if (!handle_) {
+            throw_error(SQLITE_MISUSE, "blob_stream::reopen");
+        }
+        int rc = sqlite3_blob_reopen(handle_, rowid);
+        if (rc != SQLITE_OK) {
+            // The handle is aborted after a failed reopen; keep it so close() releases it.
+            size_ = 0;
+            throw_error(rc, "blob_stream::reopen");
+        }
+        rowid_ = rowid;
+        size_  = static_cast<std::size_t>(sqlite3_blob_bytes(handle_));
+    }
+
+    blob_streambuf::blob_streambuf(blob_stream &blob, std::size_t buffer_size) :
+        blob_(blob), buffer_(std::max<std::size_t>(buffer_size, 1)) {}
+
+    blob_streambuf::~blob_streambuf() {
+        try {
+            flush_writes();
+        } catch (...) {
+        }
+    }
+
+    std::size_t blob_streambuf::position() const {
+        if (pbase()) {
+            return buffer_offset_ + static_cast<std::size_t>(pptr() - pbase());
+        }
+        if (eback()) {
+            return buffer_offset_ + static_cast<std::size_t>(gptr() - eback());
+        }
+        return buffer_offset_;
+    }
+
+    bool blob_streambuf::flush_writes() {
+        if (!pbase()) {
+            return true;
+        }
+        auto pending = static_cast<std::size_t>(pptr() - pbase());
+        blob_.write(std::span<const unsigned char>(
+                        reinterpret_cast<unsigned char const *>(pbase()), pending),
+                    buffer_offset_);
+        buffer_offset_ += pending;
+        setp(nullptr, nullptr);
+        return true;
+    }
+
+    blob_streambuf::int_type blob_streambuf::underflow() {
+        if (gptr() && gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        std::size_t pos = position();
+        flush_writes();
+        buffer_offset_  = pos;
+        std::size_t got = blob_.read(
+            std::span<unsigned char>(reinterpret_cast<unsigned char *>(buffer_.data()),
+                                     buffer_.size()),
+            pos);
+        if (got == 0) {
+            setg(nullptr, nullptr, nullptr);
+            return traits_type::eof();
+        }
+        setg(buffer_.data(), buffer_.data(), buffer_.data() + got);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::streamsize blob_streambuf::xsgetn(char_type *s, std::streamsize count) {
+        std::streamsize copied = 0;
+        if (gptr() && gptr() < egptr()) {
+            auto available = std::min<std::streamsize>(egptr() - gptr(), count);
+            std::memcpy(s, gptr(), static_cast<std::size_t>(available));
+            gbump(static_cast<int>(available));
+            copied = available;
+        }
+        auto remaining = static_cast<std::size_t>(count - copied);
+        if (remaining >= buffer_.size()) {
+            // Large reads go straight into the caller's buffer.
+            std::size_t pos = position();
+            flush_writes();
+            setg(nullptr, nullptr, nullptr);
+            std::size_t got = blob_.read(
+                std::span<unsigned char>(reinterpret_cast<unsigned char *>(s + copied), remaining),
+                pos);
+            buffer_offset_ = pos + got;
+            return copied + static_cast<std::streamsize>(got);
+        }
+        return copied + std::streambuf::xsgetn(s + copied, static_cast<std::streamsize>(remaining));
+    }
+
+    blob_streambuf::int_type blob_streambuf::overflow(int_type ch) {
+        if (!blob_.writable()) {
+            return traits_type::eof();
+        }
+        std::size_t pos = position();
+        flush_writes();
+        setg(nullptr, nullptr, nullptr);
+        buffer_offset_ = pos;
+        if (pos >= blob_.size()) {
+            return traits_type::eof();
+        }
+        std::size_t room = std::min(buffer_.size(), blob_.size() - pos);
+        setp(buffer_.data(), buffer_.data() + room);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int blob_streambuf::sync() {
+        try {
+            std::size_t pos = position();
+            flush_writes();
+            buffer_offset_ = pos;
+            return 0;
+        } catch (database_exception const &) {
+            return -1;
+        }
+    }
+
+    blob_streambuf::pos_type blob_streambuf::seekoff(off_type off, std::ios_base::seekdir dir,
+                                                     std::ios_base::openmode) {
+        std::size_t current = position();
+        off_type base       = 0;
+        if (dir == std::ios_base::cur) {
+            base = static_cast<off_type>(current);
+        } else if (dir == std::ios_base::end) {
+            base = static_cast<off_type>(blob_.size());
+        }
+        off_type target = base + off;
+        if (target < 0 || target > static_cast<off_type>(blob_.size())) {
+            return pos_type(off_type(-1));
+        }
+        flush_writes();
+        setg(nullptr, nullptr, nullptr);
+        buffer_offset_ = static_cast<std::size_t>(target);
+        return pos_type(target);
+    }
+
+    blob_streambuf::pos_type blob_streambuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,368 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/bulk_export.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+
+#include <sqlite3.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+constexpr char hex_digits[] = "0123456789abcdef";
+
+/// Appender over a std::string, used to pre-render the column prefixes.
+struct string_out {
+    std::string &text;
+
+    void put(char c) {
+        text.push_back(c);
+    }
+    void append(char const *data, std::size_t size) {
+        text.append(data, size);
+    }
+};
+
+template <typename Out>
+void csv_text(Out &out, char const *data, std::size_t size, char delimiter) {
+    bool quote = size == 0; // keeps empty text apart from NULL
+    for (std::size_t i = 0; i < size && !quote; ++i) {
+        char c = data[i];
+        quote  = c == delimiter || c == '"' || c == '\n' || c == '\r';
+    }
+    if (!quote) {
+        out.append(data, size);
+        return;
+    }
+    out.put('"');
+    char const *end = data + size;
+    while (data < end) {
+        auto hit  = static_cast<char const *>(
+            std::memchr(data, '"', static_cast<std::size_t>(end - data)));
+        char const *stop = hit ? hit + 1 : end;
+        out.append(data, static_cast<std::size_t>(stop - data));
+        if (hit) {
+            out.put('"');
+        }
+        data = stop;
+    }
+    out.put('"');
+}
+
+template <typename Out> void json_text(Out &out, char const *data, std::size_t size) {
+    out.put('"');
+    char const *end = data + size;
+    while (data < end) {
+        char const *run = data;
+        while (run < end && static_cast<unsigned char>(*run) >= 0x20 && *run != '"' &&
+               *run != '\\') {
+            ++run;
+        }
+        out.append(data, static_cast<std::size_t>(run - data));
+        if (run == end) {
+            break;
+        }
+        auto c = static_cast<unsigned char>(*run);
+        out.put('\\');
+        switch (c) {
+        case '"':
+        case '\\':
+            out.put(static_cast<char>(c));
+            break;
+        case '\n':
+            out.put('n');
+            break;
+        case '\r':
+            out.put('r');
+            break;
+        case '\t':
+            out.put('t');
+            break;
+        case '\b':
+            out.put('b');
+            break;
+        case '\f':
+            out.put('f');
+            break;
+        default:
+            out.append("u00", 3);
+            out.put(hex_digits[c >> 4]);
+            out.put(hex_digits[c & 0xF]);
+            break;
+        }
+        data = run + 1;
+    }
+    out.put('"');
+}
+
+template <typename Out> void hex_blob(Out &out, unsigned char const *data, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        out.put(hex_digits[data[i] >> 4]);
+        out.put(hex_digits[data[i] & 0xF]);
+    }
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    /// Fixed-size staging area in front of the sink.
+    class stream_exporter::output {
+    public:
+        output(std::vector<char> &buffer, export_sink const &sink, export_stats &stats) :
+            buffer_(buffer), sink_(sink), stats_(stats) {}
+
+        void put(char c) {
+            if (pos_ == buffer_.size()) {
+                flush();
+            }
+            buffer_[pos_++] = c;
+        }
+
+        void append(char const *data, std::size_t size) {
+            while (size != 0) {
+                if (pos_ == buffer_.size()) {
+                    flush();
+                }
+                auto chunk = std::min(size, buffer_.size() - pos_);
+                std::memcpy(buffer_.data() + pos_, data, chunk);
+                pos_ += chunk;
+                data += chunk;
+                size -= chunk;
+            }
+        }
+
+        /// Contiguous room for @p size bytes (small, e.g. a formatted number).
+        char *reserve(std::size_t size) {
+            if (buffer_.size() - pos_ < size) {
+                flush();
+            }
+            return buffer_.data() + pos_;
+        }
+
+        void commit(char const *end) {
+            pos_ = static_cast<std::size_t>(end - buffer_.data());
+        }
+
+        void flush() {
+            if (pos_ == 0) {
+                return;
+            }
+            sink_(std::string_view(buffer_.data(), pos_));
+            stats_.bytes += pos_;
+            ++stats_.flushes;
+            pos_ = 0;
+        }
+
+    private:
+        std::vector<char> &buffer_;
+        export_sink const &sink_;
+        export_stats &stats_;
+        std::size_t pos_ = 0;
+    };
+
+    stream_exporter::stream_exporter(query &q, export_options options) :
+        stmt_(nullptr), options_(options) {
+        stmt_       = private_accessor::get_statement(q);
+        int columns = sqlite3_column_count(stmt_);
+        for (int i = 0; i < columns; ++i) {
+            char const *name = sqlite3_column_name(stmt_, i);
+            std::string prefix;
+            string_out out{prefix};
+            if (options_.format == export_format::csv) {
+                csv_text(out, name ? name : "", name ? std::strlen(name) : 0, options_.delimiter);
+            } else {
+                out.put(i == 0 ? '{' : ',');
+                json_text(out, name ? name : "", name ? std::strlen(name) : 0);
+                out.put(':');
+            }
+            prefixes_.push_back(std::move(prefix));
+        }
+        buffer_.resize(std::max<std::size_t>(options_.buffer_size, 256));
+    }
+
+    void stream_exporter::end_row(output &out) {
+        if (options_.crlf) {
+            out.put('\r');
+        }
+        out.put('\n');
+    }
+
+    void stream_exporter::write_header(output &out) {
+        for (std::size_t i = 0; i < prefixes_.size(); ++i) {
+            if (i != 0) {
+                out.put(options_.delimiter);
+            }
+            out.append(prefixes_[i].data(), prefixes_[i].size());
+        }
+        end_row(out);
+    }
+
+    void stream_exporter::write_row(output &out) {
+        bool json = options_.format == export_format::ndjson;
+        int columns = static_cast<int>(prefixes_.size());
+        if (json && columns == 0) {
+            out.put('{');
+        }
+        for (int i = 0; i < columns; ++i) {
+            if (json) {
+                auto const &prefix = prefixes_[static_cast<std::size_t>(i)];
+                out.append(prefix.data(), prefix.size());
+            } else if (i != 0) {
+                out.put(options_.delimiter);
+            }
+            switch (sqlite3_column_type(stmt_, i)) {
+            case SQLITE_NULL:
+                if (json) {
+                    out.append("null", 4);
+                }
+                break;
+            case SQLITE_INTEGER: {
+                char *first    = out.reserve(24);
+                auto [last, ec] = std::to_chars(first, first + 24, sqlite3_column_int64(stmt_, i));
+                out.commit(last);
+                break;
+            }
+            case SQLITE_FLOAT: {
+                double value = sqlite3_column_double(stmt_, i);
+                if (json && !std::isfinite(value)) {
+                    out.append("null", 4);
+                    break;
+                }
+                char *first    = out.reserve(40);
+                auto [last, ec] = std::to_chars(first, first + 38, value);
+                if (std::find_if(first, last, [](char c) {
+                        return c == '.' || c == 'e' || c == 'n' || c == 'i';
+                    }) == last) {
+                    *last++ = '.';
+                    *last++ = '0';
+                }
+                out.commit(last);
+                break;
+            }
+            case SQLITE_TEXT: {
+                auto text = reinterpret_cast<char const *>(sqlite3_column_text(stmt_, i));
+                auto size = static_cast<std::size_t>(sqlite3_column_bytes(stmt_, i));
+                if (json) {
+                    json_text(out, text, size);
+                } else {
+                    csv_text(out, text, size, options_.delimiter);
+                }
+                break;
+            }
+            default: {
+                auto data = static_cast<unsigned char const *>(sqlite3_column_blob(stmt_, i));
+                auto size = static_cast<std::size_t>(sqlite3_column_bytes(stmt_, i));
+                if (json) {
+                    out.put('"');
+                }
+                hex_blob(out, data, size);
+                if (json) {
+                    out.put('"');
+                }
+                break;
+            }
+            }
+        }
+        if (json) {
+            out.put('}');
+        }
+        end_row(out);
+    }
+
+    export_stats stream_exporter::write(export_sink const &sink) {
+        auto started = clock_type::now();
+        export_stats stats;
+        output out(buffer_, sink, stats);
+        if (options_.format == export_format::csv && options_.header) {
+            write_header(out);
+        }
+        try {
+            for (;;) {
+                int rc = sqlite3_step(stmt_);
+                if (rc == SQLITE_DONE) {
+                    break;
+                }
+                if (rc != SQLITE_ROW) {
+                    throw database_exception_code(sqlite3_errmsg(sqlite3_db_handle(stmt_)), rc,
+                                                  sqlite3_sql(stmt_));
+                }
+                write_row(out);
+                ++stats.rows;
+            }
+            out.flush();
+        } catch (...) {
+            // Never hand a half-stepped statement back to the statement cache; bindings stay.
+            sqlite3_reset(stmt_);
+            throw;
+        }
+        stats.elapsed =
+            std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - started);
+        return stats;
+    }
+
+    export_stats stream_exporter::write(int fd) {
+        return write([fd](std::string_view chunk) {
+            while (!chunk.empty()) {
+#if defined(_WIN32)
+                auto size    = std::min<std::size_t>(chunk.size(), INT_MAX);
+                auto written = ::_write(fd, chunk.data(), static_cast<unsigned>(size));
+#else
+                auto written = ::write(fd, chunk.data(), chunk.size());
+#endif
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw database_exception(std::string("Failed to write export output: ") +
+                                             std::strerror(errno));
+                }
+                chunk.remove_prefix(static_cast<std::size_t>(written));
+            }
+        });
+    }
+} // namespace v2
+} // namespace sqlite
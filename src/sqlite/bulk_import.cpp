@@ -0,0 +1,755 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/bulk_import.hpp>
+#include <sqlite/command.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/transaction.hpp>
+
+#include "csv_reader.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+using sqlite::detail::csv_field;
+using sqlite::detail::csv_reader;
+using sqlite::detail::find;
+
+std::string quote_identifier(std::string_view identifier) {
+    std::string quoted;
+    quoted.reserve(identifier.size() + 2);
+    quoted.push_back('"');
+    for (char c : identifier) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+std::chrono::microseconds micros(clock_type::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d);
+}
+
+struct cell {
+    enum class kind : unsigned char { null, integer, real, text };
+    kind type            = kind::null;
+    std::int64_t integer = 0;
+    double real          = 0.0;
+    std::string_view text;
+};
+
+/// Rows parsed by one parser. Text cells point into the mapping or into @c owned.
+struct row_batch {
+    std::vector<cell> cells; ///< rows * columns, row-major
+    std::deque<std::string> owned;
+    std::size_t rows  = 0;
+    std::size_t bytes = 0;
+};
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+cell infer(std::string_view field) {
+    cell out;
+    if (field.empty()) {
+        return out;
+    }
+    std::size_t digits = field.front() == '-' ? 1 : 0;
+    bool numeric       = digits < field.size() && (is_digit(field[digits]) || field[digits] == '.');
+    // "007" is an identifier, not seven.
+    if (numeric && field[digits] == '0' && digits + 1 < field.size() &&
+        is_digit(field[digits + 1])) {
+        numeric = false;
+    }
+    if (numeric) {
+        auto last = field.data() + field.size();
+        auto [ptr, ec] = std::from_chars(field.data(), last, out.integer);
+        if (ec == std::errc() && ptr == last) {
+            out.type = cell::kind::integer;
+            return out;
+        }
+        auto [rptr, rec] = std::from_chars(field.data(), last, out.real);
+        if (rec == std::errc() && rptr == last) {
+            out.type = cell::kind::real;
+            return out;
+        }
+    }
+    out.type = cell::kind::text;
+    out.text = field;
+    return out;
+}
+
+cell text_cell(std::string_view text) {
+    cell out;
+    out.type = cell::kind::text;
+    out.text = text;
+    return out;
+}
+
+void append_utf8(std::string &out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+/// Parser for a single NDJSON line holding one object.
+class json_line {
+public:
+    json_line(char const *begin, char const *end, std::size_t offset,
+              std::deque<std::string> &owned) :
+        p_(begin), begin_(begin), end_(end), offset_(offset), owned_(owned) {}
+
+    bool blank() {
+        skip_ws();
+        return p_ == end_;
+    }
+
+    /// Calls @p on_member(key, value) for every member of the object.
+    template <typename F> void object(F &&on_member) {
+        skip_ws();
+        expect('{');
+        skip_ws();
+        if (peek() == '}') {
+            ++p_;
+        } else {
+            for (;;) {
+                skip_ws();
+                expect('"');
+                auto key = string();
+                skip_ws();
+                expect(':');
+                skip_ws();
+                on_member(key, value());
+                skip_ws();
+                if (peek() == ',') {
+                    ++p_;
+                    continue;
+                }
+                expect('}');
+                break;
+            }
+        }
+        skip_ws();
+        if (p_ != end_) {
+            fail("trailing characters after the object");
+        }
+    }
+
+private:
+    char peek() const {
+        return p_ < end_ ? *p_ : '\0';
+    }
+
+    void skip_ws() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n')) {
+            ++p_;
+        }
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            fail(std::format("expected '{}'", c));
+        }
+        ++p_;
+    }
+
+    [[noreturn]] void fail(std::string const &what) const {
+        throw sqlite::database_exception(std::format("Invalid NDJSON at byte {}: {}.",
+                                                     offset_ + (p_ - begin_), what));
+    }
+
+    // Called after the opening quote.
+    std::string_view string() {
+        char const *start = p_;
+        char const *quote = find(p_, end_, '"');
+        char const *slash = find(p_, quote, '\\');
+        if (quote == end_) {
+            fail("unterminated string");
+        }
+        if (slash == quote) {
+            p_ = quote + 1;
+            return std::string_view(start, quote - start);
+        }
+        std::string &out = owned_.emplace_back(start, slash);
+        p_               = slash;
+        for (;;) {
+            if (p_ == end_) {
+                fail("unterminated string");
+            }
+            char c = *p_++;
+            if (c == '"') {
+                return out;
+            }
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+            if (p_ == end_) {
+                fail("unterminated escape");
+            }
+            switch (char e = *p_++) {
+            case '"':
+            case '\\':
+            case '/':
+                out.push_back(e);
+                break;
+            case 'b':
+                out.push_back('\b');
+                break;
+            case 'f':
+                out.push_back('\f');
+                break;
+            case 'n':
+                out.push_back('\n');
+                break;
+            case 'r':
+                out.push_back('\r');
+                break;
+            case 't':
+                out.push_back('\t');
+                break;
+            case 'u': {
+                auto cp = hex4();
+                if (cp >= 0xD800 && cp <= 0xDBFF && end_ - p_ >= 6 && p_[0] == '\\' &&
+                    p_[1] == 'u') {
+                    p_ += 2;
+                    auto low = hex4();
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        fail("invalid surrogate pair");
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                fail("invalid escape");
+            }
+        }
+    }
+
+    std::uint32_t hex4() {
+        if (end_ - p_ < 4) {
+            fail("truncated \\u escape");
+        }
+        std::uint32_t cp = 0;
+        auto [ptr, ec]   = std::from_chars(p_, p_ + 4, cp, 16);
+        if (ec != std::errc() || ptr != p_ + 4) {
+            fail("invalid \\u escape");
+        }
+        p_ += 4;
+        return cp;
+    }
+
+    void literal(std::string_view word) {
+        if (static_cast<std::size_t>(end_ - p_) < word.size() ||
+            std::string_view(p_, word.size()) != word) {
+            fail("invalid literal");
+        }
+        p_ += word.size();
+    }
+
+    // Skips a nested object or array, which is stored as its JSON text.
+    std::string_view composite() {
+        char const *start = p_;
+        int depth         = 0;
+        do {
+            if (p_ == end_) {
+                fail("unterminated array or object");
+            }
+            char c = *p_++;
+            if (c == '"') {
+                string();
+            } else if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                --depth;
+            }
+        } while (depth > 0);
+        return std::string_view(start, p_ - start);
+    }
+
+    cell value() {
+        cell out;
+        switch (peek()) {
+        case '"':
+            ++p_;
+            return text_cell(string());
+        case '{':
+        case '[':
+            return text_cell(composite());
+        case 't':
+            literal("true");
+            out.type    = cell::kind::integer;
+            out.integer = 1;
+            return out;
+        case 'f':
+            literal("false");
+            out.type = cell::kind::integer;
+            return out;
+        case 'n':
+            literal("null");
+            return out;
+        default:
+            break;
+        }
+        char const *start = p_;
+        bool integral     = true;
+        while (p_ < end_ && (is_digit(*p_) || *p_ == '-' || *p_ == '+' || *p_ == '.' ||
+                             *p_ == 'e' || *p_ == 'E')) {
+            integral = integral && (is_digit(*p_) || *p_ == '-');
+            ++p_;
+        }
+        if (start == p_) {
+            fail("expected a value");
+        }
+        if (integral) {
+            auto [ptr, ec] = std::from_chars(start, p_, out.integer);
+            if (ec == std::errc() && ptr == p_) {
+                out.type = cell::kind::integer;
+                return out;
+            }
+        }
+        auto [ptr, ec] = std::from_chars(start, p_, out.real);
+        if (ec != std::errc() || ptr != p_) {
+            fail("invalid number");
+        }
+        out.type = cell::kind::real;
+        return out;
+    }
+
+    char const *p_;
+    char const *begin_;
+    char const *end_;
+    std::size_t offset_;
+    std::deque<std::string> &owned_;
+};
+
+/// Bounded hand-off between the parser threads and the writer.
+class batch_queue {
+public:
+    batch_queue(std::size_t capacity, std::size_t producers) :
+        capacity_(std::max<std::size_t>(capacity, 1)), producers_(producers) {}
+
+    /// Blocks while the queue is full; returns false once the import was cancelled.
+    bool push(row_batch batch) {
+        std::unique_lock lock(mutex_);
+        if (batches_.size() >= capacity_ && !cancelled_) {
+            auto start = clock_type::now();
+            not_full_.wait(lock, [this] { return batches_.size() < capacity_ || cancelled_; });
+            blocked_ += clock_type::now() - start;
+        }
+        if (cancelled_) {
+            return false;
+        }
+        batches_.push_back(std::move(batch));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /// Next batch, or nothing once every producer finished or the import was cancelled.
+    std::optional<row_batch> pop(clock_type::duration &idle) {
+        std::unique_lock lock(mutex_);
+        if (batches_.empty() && producers_ != 0 && !cancelled_) {
+            auto start = clock_type::now();
+            not_empty_.wait(lock, [this] {
+                return !batches_.empty() || producers_ == 0 || cancelled_;
+            });
+            idle += clock_type::now() - start;
+        }
+        if (cancelled_ || batches_.empty()) {
+            return std::nullopt;
+        }
+        auto batch = std::move(batches_.front());
+        batches_.pop_front();
+        not_full_.notify_one();
+        return batch;
+    }
+
+    void producer_done() {
+        std::lock_guard lock(mutex_);
+        --producers_;
+        not_empty_.notify_all();
+    }
+
+    void cancel() {
+        std::lock_guard lock(mutex_);
+        cancelled_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    clock_type::duration blocked() const {
+        std::lock_guard lock(mutex_);
+        return blocked_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<row_batch> batches_;
+    std::size_t capacity_;
+    std::size_t producers_;
+    bool cancelled_ = false;
+    clock_type::duration blocked_{};
+};
+
+struct import_plan {
+    std::string_view input;
+    std::string_view body; ///< Input after the CSV header
+    std::vector<std::string> columns;
+    std::unordered_map<std::string_view, std::size_t> column_index; ///< NDJSON key lookup
+    std::size_t width = 0;
+};
+
+class range_parser {
+public:
+    range_parser(import_plan const &plan, sqlite::import_options const &options,
+                 batch_queue &queue) :
+        plan_(plan), options_(options), queue_(queue),
+        batch_rows_(std::max<std::size_t>(options.batch_rows, 1)) {}
+
+    void run(char const *begin, char const *end) {
+        char const *pos   = begin;
+        char const *mark  = begin;
+        row_batch batch   = fresh_batch();
+        auto hand_off = [&] {
+            batch.bytes = static_cast<std::size_t>(pos - mark);
+            mark        = pos;
+            return queue_.push(std::exchange(batch, fresh_batch()));
+        };
+        if (options_.format == sqlite::import_format::csv) {
+            csv_reader reader(plan_.input, options_.delimiter);
+            std::vector<csv_field> fields;
+            while (pos < end) {
+                char const *record = pos;
+                reader.read(pos, fields, batch.owned);
+                if (fields.size() == 1 && !fields[0].quoted && fields[0].text.empty()) {
+                    continue; // blank line
+                }
+                if (fields.size() != plan_.width) {
+                    throw sqlite::database_exception(
+                        std::format("CSV record at byte {} has {} fields, expected {}.",
+                                    reader.offset(record), fields.size(), plan_.width));
+                }
+                for (auto const &field : fields) {
+                    bool as_text = field.quoted || !options_.infer_types;
+                    batch.cells.push_back(as_text ? text_cell(field.text) : infer(field.text));
+                }
+                if (++batch.rows == batch_rows_ && !hand_off()) {
+                    return;
+                }
+            }
+        } else {
+            while (pos < end) {
+                char const *line_end = find(pos, end, '\n');
+                json_line line(pos, line_end, static_cast<std::size_t>(pos - plan_.input.data()),
+                               batch.owned);
+                pos = line_end == end ? end : line_end + 1;
+                if (line.blank()) {
+                    continue;
+                }
+                auto row = batch.cells.size();
+                batch.cells.resize(row + plan_.width);
+                line.object([&](std::string_view key, cell const &value) {
+                    auto it = plan_.column_index.find(key);
+                    if (it != plan_.column_index.end()) {
+                        batch.cells[row + it->second] = value;
+                    }
+                });
+                if (++batch.rows == batch_rows_ && !hand_off()) {
+                    return;
+                }
+            }
+        }
+        if (batch.rows != 0) {
+            hand_off();
+        }
+    }
+
+private:
+    row_batch fresh_batch() const {
+        row_batch batch;
+        batch.cells.reserve(batch_rows_ * plan_.width);
+        return batch;
+    }
+
+    import_plan const &plan_;
+    sqlite::import_options const &options_;
+    batch_queue &queue_;
+    std::size_t batch_rows_;
+};
+
+import_plan make_plan(std::string_view input, sqlite::import_options const &options) {
+    import_plan plan;
+    plan.input   = input;
+    plan.body    = input;
+    plan.columns = options.columns;
+    std::deque<std::string> scratch;
+    if (options.format == sqlite::import_format::csv) {
+        csv_reader reader(input, options.delimiter);
+        std::vector<csv_field> fields;
+        char const *pos = input.data();
+        if (!input.empty()) {
+            reader.read(pos, fields, scratch);
+        }
+        if (options.header) {
+            plan.body = std::string_view(pos, input.data() + input.size() - pos);
+            if (plan.columns.empty()) {
+                for (auto const &field : fields) {
+                    plan.columns.emplace_back(field.text);
+                }
+            }
+        }
+        plan.width = plan.columns.empty() ? fields.size() : plan.columns.size();
+    } else {
+        if (plan.columns.empty()) {
+            char const *pos = input.data();
+            char const *end = input.data() + input.size();
+            while (pos < end) {
+                char const *line_end = find(pos, end, '\n');
+                json_line line(pos, line_end, static_cast<std::size_t>(pos - input.data()),
+                               scratch);
+                pos = line_end == end ? end : line_end + 1;
+                if (!line.blank()) {
+                    line.object([&](std::string_view key, cell const &) {
+                        if (std::find(plan.columns.begin(), plan.columns.end(), key) ==
+                            plan.columns.end()) {
+                            plan.columns.emplace_back(key);
+                        }
+                    });
+                    break;
+                }
+            }
+        }
+        for (std::size_t i = 0; i < plan.columns.size(); ++i) {
+            plan.column_index[plan.columns[i]] = i;
+        }
+        plan.width = plan.columns.size();
+    }
+    return plan;
+}
+
+std::string insert_sql(std::string_view table, import_plan const &plan) {
+    std::string sql = "INSERT INTO " + quote_identifier(table);
+    if (!plan.columns.empty()) {
+        sql += '(';
+        for (std::size_t i = 0; i < plan.columns.size(); ++i) {
+            sql += (i ? ", " : "") + quote_identifier(plan.columns[i]);
+        }
+        sql += ')';
+    }
+    sql += " VALUES(";
+    for (std::size_t i = 0; i < plan.width; ++i) {
+        sql += i ? ", ?" : "?";
+    }
+    return sql + ");";
+}
+
+/// Splits the body into @p parts ranges that each start at the beginning of a line.
+std::vector<std::string_view> split_lines(std::string_view body, std::size_t parts) {
+    std::vector<std::string_view> ranges;
+    char const *begin = body.data();
+    char const *end   = body.data() + body.size();
+    for (std::size_t i = 1; i <= parts; ++i) {
+        char const *cut = i == parts ? end : body.data() + body.size() * i / parts;
+        if (cut < begin) {
+            cut = begin;
+        }
+        if (cut != end && cut != body.data()) {
+            char const *nl = find(cut - 1, end, '\n');
+            cut            = nl == end ? end : nl + 1;
+        }
+        if (cut > begin) {
+            ranges.emplace_back(begin, cut - begin);
+        }
+        begin = cut;
+    }
+    return ranges;
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    import_stats import_file(connection &con, std::string_view table,
+                             std::filesystem::path const &path, import_options const &options) {
+        detail::mapped_file file(path);
+        return import_data(con, table, file.view(), options);
+    }
+
+    import_stats import_data(connection &con, std::string_view table, std::string_view data,
+                             import_options const &options) {
+        auto started = clock_type::now();
+        auto plan    = make_plan(data, options);
+        import_stats stats;
+        if (plan.width == 0) {
+            if (!plan.body.empty()) {
+                throw database_exception("import could not determine the target columns.");
+            }
+            return stats;
+        }
+
+        auto ranges = split_lines(plan.body, std::max<std::size_t>(options.parser_threads, 1));
+        batch_queue queue(options.queue_depth, ranges.size());
+        std::mutex error_mutex;
+        std::exception_ptr parse_error;
+        std::vector<std::thread> parsers;
+        struct stop_guard {
+            batch_queue &queue;
+            std::vector<std::thread> &threads;
+            ~stop_guard() {
+                queue.cancel();
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+            }
+        } guard{queue, parsers};
+        for (auto range : ranges) {
+            parsers.emplace_back([&, range] {
+                try {
+                    range_parser(plan, options, queue)
+                        .run(range.data(), range.data() + range.size());
+                } catch (...) {
+                    {
+                        std::lock_guard lock(error_mutex);
+                        if (!parse_error) {
+                            parse_error = std::current_exception();
+                        }
+                    }
+                    queue.cancel();
+                }
+                queue.producer_done();
+            });
+        }
+
+        std::optional<bulk_load_session> bulk;
+        if (options.bulk) {
+            bulk.emplace(con, table, *options.bulk);
+        }
+        std::optional<transaction> tx;
+        command insert(con, insert_sql(table, plan));
+        std::size_t in_transaction = 0;
+        clock_type::duration idle{};
+        while (auto batch = queue.pop(idle)) {
+            if (!bulk && !tx) {
+                tx.emplace(con, transaction_type::immediate);
+            }
+            auto const *cells = batch->cells.data();
+            for (std::size_t row = 0; row < batch->rows; ++row, cells += plan.width) {
+                insert.clear();
+                for (std::size_t col = 0; col < plan.width; ++col) {
+                    int idx = static_cast<int>(col) + 1;
+                    switch (cells[col].type) {
+                    case cell::kind::null:
+                        insert.bind(idx);
+                        break;
+                    case cell::kind::integer:
+                        insert.bind(idx, cells[col].integer);
+                        break;
+                    case cell::kind::real:
+                        insert.bind(idx, cells[col].real);
+                        break;
+                    case cell::kind::text:
+                        insert.bind(idx, cells[col].text);
+                        break;
+                    }
+                }
+                insert.step_once();
+            }
+            stats.rows += batch->rows;
+            stats.bytes += batch->bytes;
+            ++stats.batches;
+            if (bulk) {
+                bulk->rows_added(batch->rows);
+            } else if ((in_transaction += batch->rows) >= options.rows_per_transaction) {
+                tx->commit();
+                tx.reset();
+                in_transaction = 0;
+                ++stats.transactions;
+            }
+            if (options.progress) {
+                stats.elapsed         = micros(clock_type::now() - started);
+                stats.writer_idle     = micros(idle);
+                stats.parsers_blocked = micros(queue.blocked());
+                options.progress(stats);
+            }
+        }
+        insert.clear();
+        for (auto &thread : parsers) {
+            thread.join();
+        }
+        parsers.clear();
+        if (parse_error) {
+            std::rethrow_exception(parse_error);
+        }
+        if (tx) {
+            tx->commit();
+            ++stats.transactions;
+        }
+        if (bulk) {
+            bulk->finish();
+        }
+        stats.elapsed         = micros(clock_type::now() - started);
+        stats.writer_idle     = micros(idle);
+        stats.parsers_blocked = micros(queue.blocked());
+        return stats;
+    }
+} // namespace v2
+} // namespace sqlite
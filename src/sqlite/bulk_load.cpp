@@ -0,0 +1,239 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/bulk_load.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+
+#include <sqlite3.h>
+
+#include <exception>
+#include <format>
+
+namespace {
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+std::string quote_identifier(std::string_view identifier) {
+    std::string quoted;
+    quoted.reserve(identifier.size() + 2);
+    quoted.push_back('"');
+    for (char c : identifier) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+// Runs a PRAGMA (read or assignment) and returns its first column. The statement is reset
+// afterwards so it does not keep a later COMMIT from completing.
+template <typename T> T pragma_value(sqlite::connection &con, std::string const &sql) {
+    sqlite::query q(con, sql);
+    auto res = q.get_result();
+    if (!res->next_row()) {
+        throw sqlite::database_exception("No value returned by " + sql);
+    }
+    auto value = res->get<T>(0);
+    q.clear();
+    return value;
+}
+
+bool keeps_journal(std::string const &mode) {
+    // WAL is persistent and shared by every connection; switching it away would affect them too.
+    return mode == "wal" || mode == "wal2";
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    bulk_load_session::bulk_load_session(connection &con, std::string_view table,
+                                         bulk_load_options const &options) :
+        con_(con), table_(table), options_(options) {
+        if (table_.empty()) {
+            throw database_exception("bulk_load_session needs a table name.");
+        }
+        if (sqlite3_get_autocommit(to_handle(con_)) == 0) {
+            throw database_exception("bulk_load_session cannot start inside a transaction.");
+        }
+        previous_synchronous_ = pragma_value<int>(con_, "PRAGMA synchronous;");
+        previous_cache_size_  = pragma_value<std::int64_t>(con_, "PRAGMA cache_size;");
+        previous_journal_     = pragma_value<std::string>(con_, "PRAGMA journal_mode;");
+
+        try {
+            if (options_.relax_durability) {
+                execute(con_, "PRAGMA synchronous = OFF;", true);
+            }
+            if (options_.cache_kib > 0) {
+                execute(con_, std::format("PRAGMA cache_size = -{};", options_.cache_kib), true);
+            }
+            if (options_.journal != bulk_journal::keep && !keeps_journal(previous_journal_)) {
+                pragma_value<std::string>(
+                    con_, options_.journal == bulk_journal::off ? "PRAGMA journal_mode = OFF;"
+                                                                : "PRAGMA journal_mode = MEMORY;");
+            }
+
+            if (options_.drop_indexes) {
+                // Indexes without SQL back UNIQUE/PRIMARY KEY constraints and cannot be dropped.
+                query q(con_, "SELECT m.name, m.sql, l.\"unique\" FROM sqlite_master m "
+                              "JOIN pragma_index_list(?1) l ON l.name = m.name "
+                              "WHERE m.type = 'index' AND m.tbl_name = ?1 AND m.sql IS NOT NULL "
+                              "ORDER BY m.rowid;");
+                q % table_;
+                auto res = q.get_result();
+                while (res->next_row()) {
+                    if (res->get<int>(2) == 0 || options_.drop_unique_indexes) {
+                        indexes_.push_back({res->get<std::string>(0), res->get<std::string>(1)});
+                    }
+                }
+                q.clear();
+                for (auto &index : indexes_) {
+                    execute(con_, std::format("DROP INDEX {};", quote_identifier(index.name)),
+                            true);
+                    index.dropped = true;
+                }
+            }
+
+            tx_.emplace(con_, transaction_type::immediate);
+        } catch (...) {
+            try {
+                rebuild_indexes();
+            } catch (...) {
+            }
+            restore_pragmas();
+            throw;
+        }
+    }
+
+    bulk_load_session::~bulk_load_session() {
+        if (finished_) {
+            return;
+        }
+        try {
+            tx_.reset();
+            rebuild_indexes();
+        } catch (...) {
+            // Destructors can't surface the error; best effort only.
+        }
+        restore_pragmas();
+    }
+
+    void bulk_load_session::rows_added(std::size_t rows) {
+        batch_rows_ += rows;
+        if (options_.rows_per_transaction != 0 && batch_rows_ >= options_.rows_per_transaction) {
+            commit_batch();
+        }
+    }
+
+    void bulk_load_session::commit_batch() {
+        if (!tx_) {
+            throw database_exception("bulk_load_session has already committed its rows.");
+        }
+        tx_->commit();
+        tx_.emplace(con_, transaction_type::immediate);
+        batch_rows_ = 0;
+    }
+
+    void bulk_load_session::finish() {
+        if (finished_) {
+            return;
+        }
+        if (tx_) {
+            tx_->commit();
+            tx_.reset();
+        }
+        try {
+            rebuild_indexes();
+        } catch (...) {
+            // The rows are committed; the failed indexes stay in dropped_indexes() for a retry.
+            restore_pragmas();
+            throw;
+        }
+        finished_ = true;
+        restore_pragmas();
+    }
+
+    std::vector<std::string> bulk_load_session::dropped_indexes() const {
+        std::vector<std::string> names;
+        for (auto const &index : indexes_) {
+            if (index.dropped) {
+                names.push_back(index.name);
+            }
+        }
+        return names;
+    }
+
+    void bulk_load_session::rebuild_indexes() {
+        // Each CREATE INDEX is atomic on its own; keep going so one violated UNIQUE index does
+        // not hold back the others, and report the first failure once all were attempted.
+        std::exception_ptr error;
+        for (auto &index : indexes_) {
+            if (!index.dropped) {
+                continue;
+            }
+            try {
+                execute(con_, index.sql, true);
+                index.dropped = false;
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void bulk_load_session::restore_pragmas() noexcept {
+        try {
+            if (options_.journal != bulk_journal::keep && !keeps_journal(previous_journal_)) {
+                pragma_value<std::string>(
+                    con_, std::format("PRAGMA journal_mode = {};", previous_journal_));
+            }
+        } catch (...) {
+        }
+        try {
+            execute(con_, std::format("PRAGMA cache_size = {};", previous_cache_size_), true);
+            execute(con_, std::format("PRAGMA synchronous = {};", previous_synchronous_), true);
+        } catch (...) {
+        }
+    }
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,264 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/change_bus.hpp>
+#include <sqlite/connection.hpp>
+
+#include <sqlite3.h>
+
+#include "change_hooks.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+std::string lowered(std::string_view text) {
+    std::string out(text);
+    for (auto &c : out) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+bool same_name(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           sqlite3_strnicmp(a.data(), b.data(), static_cast<int>(a.size())) == 0;
+}
+
+sqlite::change_kind to_kind(int op) {
+    switch (op) {
+    case SQLITE_INSERT:
+        return sqlite::change_kind::insert;
+    case SQLITE_DELETE:
+        return sqlite::change_kind::remove;
+    default:
+        return sqlite::change_kind::update;
+    }
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    change_bus::subscription::subscription(subscription &&other) noexcept :
+        bus_(other.bus_), id_(other.id_) {
+        other.bus_ = nullptr;
+    }
+
+    change_bus::subscription &change_bus::subscription::operator=(subscription &&other) noexcept {
+        if (this != &other) {
+            reset();
+            bus_       = other.bus_;
+            id_        = other.id_;
+            other.bus_ = nullptr;
+        }
+        return *this;
+    }
+
+    change_bus::subscription::~subscription() {
+        reset();
+    }
+
+    void change_bus::subscription::reset() {
+        if (bus_) {
+            bus_->unsubscribe(id_);
+            bus_ = nullptr;
+        }
+    }
+
+    change_bus::change_bus(connection &con) : con_(con), hooks_(&detail::hooks_of(con)) {
+        hooks_->add({this, &change_bus::on_update, &change_bus::on_commit,
+                     &change_bus::on_rollback, &change_bus::on_missed});
+        try {
+            dispatcher_ = std::thread([this] { run(); });
+        } catch (...) {
+            hooks_->remove(this);
+            throw;
+        }
+    }
+
+    change_bus::~change_bus() {
+        // Detach from the writer first so no commit can queue into a dying bus.
+        hooks_->remove(this);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (dispatcher_.joinable()) {
+            dispatcher_.join();
+        }
+    }
+
+    change_bus::subscription change_bus::subscribe(std::string_view table,
+                                                   change_callback callback, rowid_range range) {
+        auto sub = std::make_shared<subscriber>();
+        auto dot = table.find('.');
+        if (dot != std::string_view::npos) {
+            sub->schema = lowered(table.substr(0, dot));
+            table       = table.substr(dot + 1);
+        }
+        sub->table    = lowered(table);
+        sub->range    = range;
+        sub->callback = std::move(callback);
+        std::lock_guard<std::mutex> lock(mutex_);
+        sub->id = next_id_++;
+        subscribers_.push_back(sub);
+        return subscription(this, sub->id);
+    }
+
+    void change_bus::unsubscribe(std::uint64_t id) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::erase_if(subscribers_, [id](auto const &sub) { return sub->id == id; });
+        // A delivery may still hold the callback; wait it out unless we are inside it.
+        if (std::this_thread::get_id() != dispatcher_.get_id()) {
+            idle_.wait(lock, [this] { return !dispatching_; });
+        }
+    }
+
+    void change_bus::flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return queue_.empty() && !dispatching_ && !settle_; });
+    }
+
+    change_bus_stats change_bus::stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto out           = stats_;
+        out.queued_batches = queue_.size();
+        return out;
+    }
+
+    std::string_view change_bus::intern(char const *name) {
+        return *names_.emplace(name ? name : "").first;
+    }
+
+    void change_bus::on_update(void *self, int op, char const *schema, char const *table,
+                               long long rowid) {
+        auto *bus = static_cast<change_bus *>(self);
+        bus->pending_.push_back(
+            table_change{bus->intern(schema), bus->intern(table), to_kind(op), rowid});
+    }
+
+    int change_bus::on_commit(void *self) {
+        auto *bus = static_cast<change_bus *>(self);
+        {
+            std::lock_guard<std::mutex> lock(bus->mutex_);
+            // A truncation is only counted once the writer's statement ends; check after it.
+            bus->settle_ = true;
+            if (!bus->pending_.empty()) {
+                ++bus->stats_.committed_batches;
+                bus->stats_.changes += bus->pending_.size();
+                bus->queue_.push_back(std::move(bus->pending_));
+            }
+        }
+        bus->pending_ = {};
+        bus->wake_.notify_one();
+        return 0;
+    }
+
+    void change_bus::on_rollback(void *self) {
+        auto *bus = static_cast<change_bus *>(self);
+        if (bus->pending_.empty()) {
+            return;
+        }
+        bus->pending_.clear();
+        std::lock_guard<std::mutex> lock(bus->mutex_);
+        ++bus->stats_.discarded_batches;
+    }
+
+    void change_bus::on_missed(void *self) {
+        auto *bus = static_cast<change_bus *>(self);
+        {
+            std::lock_guard<std::mutex> lock(bus->mutex_);
+            ++bus->stats_.unknown_changes;
+            bus->queue_.push_back({table_change{{}, {}, change_kind::unknown, 0}});
+        }
+        bus->wake_.notify_one();
+    }
+
+    void change_bus::run() {
+        std::vector<table_change> matched;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [this] { return stop_ || settle_ || !queue_.empty(); });
+            if (settle_) {
+                // Waits for the writer's statement to end, then may queue an unknown marker.
+                settle_      = false;
+                dispatching_ = true;
+                lock.unlock();
+                hooks_->settle();
+                lock.lock();
+                dispatching_ = false;
+                idle_.notify_all();
+                continue;
+            }
+            if (queue_.empty()) {
+                return;
+            }
+            auto batch       = std::move(queue_.front());
+            auto subscribers = subscribers_;
+            queue_.pop_front();
+            dispatching_ = true;
+            lock.unlock();
+
+            std::uint64_t calls  = 0;
+            std::uint64_t errors = 0;
+            for (auto const &sub : subscribers) {
+                matched.clear();
+                for (auto const &change : batch) {
+                    // Unknown changes have no table or rowid to filter on.
+                    if (change.kind == change_kind::unknown ||
+                        ((sub->table.empty() || same_name(change.table, sub->table)) &&
+                         (sub->schema.empty() || same_name(change.schema, sub->schema)) &&
+                         change.rowid >= sub->range.first && change.rowid <= sub->range.last)) {
+                        matched.push_back(change);
+                    }
+                }
+                if (matched.empty()) {
+                    continue;
+                }
+                ++calls;
+                try {
+                    sub->callback(std::span<table_change const>(matched));
+                } catch (...) {
+                    ++errors;
+                }
+            }
+
+            lock.lock();
+            stats_.callbacks += calls;
+            stats_.callback_errors += errors;
+            dispatching_ = false;
+            idle_.notify_all();
+        }
+    }
+} // namespace v2
+} // namespace sqlite
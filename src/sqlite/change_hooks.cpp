@@ -0,0 +1,197 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+
+#include "change_hooks.hpp"
+
+#include <algorithm>
+
+namespace {
+// Holds a connection's own mutex; a no-op for connections opened without one.
+class db_lock {
+public:
+    explicit db_lock(sqlite3 *db) : mutex_(db ? sqlite3_db_mutex(db) : nullptr) {
+        sqlite3_mutex_enter(mutex_);
+    }
+    ~db_lock() {
+        sqlite3_mutex_leave(mutex_);
+    }
+    db_lock(db_lock const &)            = delete;
+    db_lock &operator=(db_lock const &) = delete;
+
+private:
+    sqlite3_mutex *mutex_;
+};
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    namespace detail {
+        change_hooks::~change_hooks() {
+            reset(nullptr);
+        }
+
+        void change_hooks::add(change_listener listener) {
+            db_lock lock(db_);
+            if (!db_) {
+                throw database_exception("Database is not open.");
+            }
+            if (listeners_.empty()) {
+                // The setters return the previous user data, which is how foreign hooks show up.
+                void *update   = sqlite3_update_hook(db_, &change_hooks::on_update, this);
+                void *commit   = sqlite3_commit_hook(db_, &change_hooks::on_commit, this);
+                void *rollback = sqlite3_rollback_hook(db_, &change_hooks::on_rollback, this);
+                if (update || commit || rollback) {
+                    uninstall();
+                    throw database_exception("Another update, commit or rollback hook is already "
+                                             "installed on this connection.");
+                }
+                changes_mark_ = sqlite3_total_changes(db_);
+                hooked_       = 0;
+                unsettled_    = false;
+            }
+            listeners_.push_back(listener);
+        }
+
+        void change_hooks::remove(void *self) noexcept {
+            db_lock lock(db_);
+            std::erase_if(listeners_, [self](change_listener const &listener) {
+                return listener.self == self;
+            });
+            if (listeners_.empty()) {
+                uninstall();
+            }
+        }
+
+        void change_hooks::reset(sqlite3 *db) noexcept {
+            {
+                db_lock lock(db_);
+                listeners_.clear();
+                uninstall();
+            }
+            db_ = db;
+        }
+
+        void change_hooks::settle() noexcept {
+            if (!unsettled_.load()) {
+                return;
+            }
+            db_lock lock(db_);
+            // Inside a transaction the counter includes changes that may still roll back.
+            if (db_ && unsettled_.load() && sqlite3_get_autocommit(db_) && !writing()) {
+                reconcile();
+            }
+        }
+
+        bool change_hooks::writing() const noexcept {
+            for (auto *stmt = sqlite3_next_stmt(db_, nullptr); stmt;
+                 stmt       = sqlite3_next_stmt(db_, stmt)) {
+                if (sqlite3_stmt_busy(stmt) && !sqlite3_stmt_readonly(stmt)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void change_hooks::reconcile() noexcept {
+            std::int64_t total = sqlite3_total_changes(db_);
+            bool missed        = total - changes_mark_ > hooked_;
+            changes_mark_      = total;
+            hooked_            = 0;
+            unsettled_         = false;
+            if (!missed) {
+                return;
+            }
+            for (auto const &listener : listeners_) {
+                if (listener.missed) {
+                    listener.missed(listener.self);
+                }
+            }
+        }
+
+        void change_hooks::uninstall() noexcept {
+            if (!db_) {
+                return;
+            }
+            sqlite3_update_hook(db_, nullptr, nullptr);
+            sqlite3_commit_hook(db_, nullptr, nullptr);
+            sqlite3_rollback_hook(db_, nullptr, nullptr);
+        }
+
+        void change_hooks::on_update(void *self, int op, char const *schema, char const *table,
+                                     sqlite3_int64 rowid) {
+            auto *hooks = static_cast<change_hooks *>(self);
+            ++hooks->hooked_;
+            for (auto const &listener : hooks->listeners_) {
+                if (listener.update) {
+                    listener.update(listener.self, op, schema, table, rowid);
+                }
+            }
+        }
+
+        int change_hooks::on_commit(void *self) {
+            auto *hooks = static_cast<change_hooks *>(self);
+            // An autocommit statement is still running and not yet counted; check once it ends.
+            if (hooks->writing()) {
+                hooks->unsettled_ = true;
+            } else {
+                hooks->reconcile();
+            }
+            int veto = 0;
+            for (auto const &listener : hooks->listeners_) {
+                if (listener.commit && listener.commit(listener.self) != 0) {
+                    veto = 1;
+                }
+            }
+            return veto;
+        }
+
+        void change_hooks::on_rollback(void *self) {
+            auto *hooks = static_cast<change_hooks *>(self);
+            // A failing statement is never counted, so the counter is final here.
+            hooks->reconcile();
+            for (auto const &listener : hooks->listeners_) {
+                if (listener.rollback) {
+                    listener.rollback(listener.self);
+                }
+            }
+        }
+
+        change_hooks &hooks_of(connection &con) {
+            return private_accessor::change_hooks(con);
+        }
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
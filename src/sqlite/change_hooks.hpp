@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <sqlite3.h>
+
+namespace sqlite {
+inline namespace v2 {
+    struct connection;
+
+    namespace detail {
+        /// One subscriber to a connection's change hooks; null callbacks are skipped. `missed` runs
+        /// when SQLite counted row changes the update hook never reported.
+        struct change_listener {
+            void *self = nullptr;
+            void (*update)(void *, int, char const *, char const *, sqlite3_int64) = nullptr;
+            int (*commit)(void *)    = nullptr;
+            void (*rollback)(void *) = nullptr;
+            void (*missed)(void *)   = nullptr;
+        };
+
+        /**
+         * Owns the single update, commit and rollback hook slot of one connection and fans each
+         * event out to every registered listener, so caches and buses can share a connection.
+         * The hooks are installed with the first listener and removed with the last. A commit is
+         * vetoed when any listener's commit callback returns non-zero.
+         *
+         * The listener list is guarded by the connection's own mutex, which SQLite already holds
+         * while it runs the hooks. Listeners are thus never called under a second lock, and once
+         * remove() returns no hook is still running for that listener. Connections opened without
+         * a mutex must not be used concurrently anyway.
+         *
+         * The update hook misses `DELETE FROM t` without WHERE and writes to WITHOUT ROWID tables,
+         * but `sqlite3_total_changes` counts them. It only counts a statement once the statement
+         * has finished, though, which is after the commit hook of an autocommit statement. So the
+         * registry compares the counter with the hook calls at COMMIT and ROLLBACK when no write
+         * statement is still running, and otherwise leaves the comparison to settle(), which
+         * readers call before they trust what they cached.
+         */
+        class change_hooks {
+        public:
+            explicit change_hooks(sqlite3 *db) : db_(db) {}
+            ~change_hooks();
+
+            change_hooks(change_hooks const &)            = delete;
+            change_hooks &operator=(change_hooks const &) = delete;
+
+            /// Throws when hooks set through the C API already occupy the slots. SQLite cannot hand
+            /// those callbacks back, so they are cleared rather than silently replaced.
+            void add(change_listener listener);
+            void remove(void *self) noexcept;
+
+            /// Drops every listener and rebinds to @p db; called before the handle is closed.
+            void reset(sqlite3 *db) noexcept;
+
+            /// Runs the `missed` callbacks if a finished commit changed rows the hook did not
+            /// report. Cheap when there is nothing to check; must not be called from a hook.
+            void settle() noexcept;
+
+            sqlite3 *handle() const noexcept {
+                return db_;
+            }
+
+        private:
+            static void on_update(void *self, int op, char const *schema, char const *table,
+                                  sqlite3_int64 rowid);
+            static int on_commit(void *self);
+            static void on_rollback(void *self);
+
+            void uninstall() noexcept;
+            bool writing() const noexcept;
+            void reconcile() noexcept;
+
+            sqlite3 *db_;
+            std::vector<change_listener> listeners_;
+            // Guarded by the connection mutex, like the listeners.
+            std::int64_t changes_mark_ = 0;
+            std::int64_t hooked_       = 0;
+            std::atomic<bool> unsettled_{false};
+        };
+
+        /// The hook registry of @p con, created on first use.
+        change_hooks &hooks_of(connection &con);
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
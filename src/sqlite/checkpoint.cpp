@@ -0,0 +1,273 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <algorithm>
+#include <string>
+
+#include <sqlite/checkpoint.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/snapshot.hpp>
+
+#include <sqlite3.h>
+
+namespace {
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+int read_pragma_int(sqlite::connection &con, std::string const &pragma) {
+    sqlite::query q(con, "PRAGMA " + pragma + ";");
+    auto res = q.get_result();
+    if (!res->next_row()) {
+        throw sqlite::database_exception("Failed to read PRAGMA " + pragma + ".");
+    }
+    return res->get<int>(0);
+}
+
+int to_native(sqlite::checkpoint_mode mode) {
+    switch (mode) {
+    case sqlite::checkpoint_mode::full:
+        return SQLITE_CHECKPOINT_FULL;
+    case sqlite::checkpoint_mode::restart:
+        return SQLITE_CHECKPOINT_RESTART;
+    case sqlite::checkpoint_mode::truncate:
+        return SQLITE_CHECKPOINT_TRUNCATE;
+    case sqlite::checkpoint_mode::passive:
+    default:
+        return SQLITE_CHECKPOINT_PASSIVE;
+    }
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    checkpoint_manager::checkpoint_manager(connection &writer, checkpoint_options options) :
+        writer_(writer), options_(std::move(options)) {
+        if (options_.schema.empty()) {
+            options_.schema = "main";
+        }
+        auto *db         = to_handle(writer_);
+        char const *file = sqlite3_db_filename(db, options_.schema.c_str());
+        if (!file || !*file) {
+            throw database_exception("checkpoint_manager requires a file-backed database.");
+        }
+        checkpointer_ = std::make_unique<connection>(std::string(file), open_mode::open_existing);
+        auto mode     = get_wal_mode(*checkpointer_);
+        if (mode != wal_mode::wal && mode != wal_mode::wal2) {
+            throw database_exception("checkpoint_manager requires a database in WAL mode.");
+        }
+        sqlite3_busy_timeout(to_handle(*checkpointer_),
+                             static_cast<int>(options_.busy_timeout.count()));
+        // Every WAL frame carries a 24 byte header in front of the page image.
+        frame_bytes_ = static_cast<std::int64_t>(read_pragma_int(*checkpointer_, "page_size")) + 24;
+
+        previous_autocheckpoint_ = read_pragma_int(writer_, "wal_autocheckpoint");
+
+        worker_ = std::thread([this] { run(); });
+        sqlite3_wal_autocheckpoint(db, 0);
+        sqlite3_wal_hook(db, &checkpoint_manager::on_wal_commit, this);
+    }
+
+    checkpoint_manager::~checkpoint_manager() {
+        // Detach from the writer first so no commit can call back into a dying manager.
+        try {
+            auto *db = to_handle(writer_);
+            sqlite3_wal_hook(db, nullptr, nullptr);
+            sqlite3_wal_autocheckpoint(db, previous_autocheckpoint_);
+        } catch (...) {
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    int checkpoint_manager::on_wal_commit(void *self, sqlite3 *, char const *schema, int frames) {
+        auto *manager = static_cast<checkpoint_manager *>(self);
+        if (schema && manager->options_.schema != schema) {
+            return SQLITE_OK;
+        }
+        manager->wal_frames_.store(frames, std::memory_order_relaxed);
+        manager->dirty_.store(true, std::memory_order_relaxed);
+        if (frames >= manager->options_.passive_frames) {
+            try {
+                manager->request();
+            } catch (...) {
+                // The idle interval picks the work up if the wake-up could not be delivered.
+            }
+        }
+        return SQLITE_OK;
+    }
+
+    void checkpoint_manager::request() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            wake_requested_ = true;
+        }
+        wake_.notify_one();
+    }
+
+    checkpoint_mode checkpoint_manager::pick_mode(int frames) const {
+        if (options_.truncate_frames > 0 && frames >= options_.truncate_frames) {
+            return checkpoint_mode::truncate;
+        }
+        if (options_.restart_frames > 0 && frames >= options_.restart_frames) {
+            return checkpoint_mode::restart;
+        }
+        return checkpoint_mode::passive;
+    }
+
+    void checkpoint_manager::run() {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (!stop_) {
+            wake_.wait_for(lock, options_.interval, [this] { return stop_ || wake_requested_; });
+            if (stop_) {
+                break;
+            }
+            bool requested  = wake_requested_;
+            wake_requested_ = false;
+            lock.unlock();
+
+            bool dirty = dirty_.exchange(false, std::memory_order_relaxed);
+            if (requested || dirty) {
+                try {
+                    std::lock_guard<std::mutex> guard(checkpoint_mutex_);
+                    auto result =
+                        checkpoint_locked(pick_mode(wal_frames_.load(std::memory_order_relaxed)));
+                    if (result.busy || result.checkpointed_frames < result.wal_frames) {
+                        // Readers pinned part of the WAL; retry on the next interval.
+                        dirty_.store(true, std::memory_order_relaxed);
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+                    ++stats_.failures;
+                }
+            }
+            lock.lock();
+        }
+    }
+
+    checkpoint_result checkpoint_manager::checkpoint_now(checkpoint_mode mode) {
+        std::lock_guard<std::mutex> guard(checkpoint_mutex_);
+        return checkpoint_locked(mode);
+    }
+
+    checkpoint_result checkpoint_manager::checkpoint_locked(checkpoint_mode mode) {
+        auto *db   = to_handle(*checkpointer_);
+        int log    = 0;
+        int copied = 0;
+        auto start = std::chrono::steady_clock::now();
+        int rc     = sqlite3_wal_checkpoint_v2(db, "main", to_native(mode), &log, &copied);
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+        if (rc != SQLITE_OK && rc != SQLITE_BUSY) {
+            throw database_exception_code(sqlite3_errmsg(db), rc);
+        }
+
+        checkpoint_result result;
+        result.mode                = mode;
+        result.busy                = rc == SQLITE_BUSY;
+        result.wal_frames          = std::max(log, 0);
+        result.checkpointed_frames = std::max(copied, 0);
+        result.duration            = elapsed;
+
+        wal_frames_.store(result.wal_frames, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        switch (mode) {
+        case checkpoint_mode::passive:
+            ++stats_.passive_runs;
+            break;
+        case checkpoint_mode::full:
+        case checkpoint_mode::restart:
+            ++stats_.restart_runs;
+            break;
+        case checkpoint_mode::truncate:
+            ++stats_.truncate_runs;
+            break;
+        }
+        if (result.busy) {
+            ++stats_.busy_runs;
+        }
+        // A smaller WAL, or fewer checkpointed frames than already counted, means the WAL was
+        // restarted or truncated in between and the count starts over.
+        if (result.wal_frames < counted_wal_frames_ ||
+            result.checkpointed_frames < counted_frames_) {
+            counted_frames_ = 0;
+        }
+        stats_.checkpointed_frames +=
+            static_cast<std::uint64_t>(result.checkpointed_frames - counted_frames_);
+        counted_frames_     = result.checkpointed_frames;
+        counted_wal_frames_ = result.wal_frames;
+        stats_.last_duration = elapsed;
+        stats_.max_duration  = std::max(stats_.max_duration, elapsed);
+        return result;
+    }
+
+    checkpoint_stats checkpoint_manager::stats() const {
+        checkpoint_stats out;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            out = stats_;
+        }
+        // The WAL hook reports the size after every commit, which is fresher than the last run.
+        out.wal_frames = wal_frames_.load(std::memory_order_relaxed);
+        // 32 byte WAL header followed by the frames.
+        out.wal_bytes = out.wal_frames > 0 ? 32 + out.wal_frames * frame_bytes_ : 0;
+        return out;
+    }
+
+    std::string_view to_string(checkpoint_mode mode) {
+        switch (mode) {
+        case checkpoint_mode::passive:
+            return "PASSIVE";
+        case checkpoint_mode::full:
+            return "FULL";
+        case checkpoint_mode::restart:
+            return "RESTART";
+        case checkpoint_mode::truncate:
+            return "TRUNCATE";
+        default:
+            break;
+        }
+        throw database_exception("Unknown checkpoint mode requested.");
+    }
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,237 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/chunked_mutation.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <format>
+#include <limits>
+#include <thread>
+
+namespace {
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+std::string quote_identifier(std::string_view identifier) {
+    std::string quoted;
+    quoted.reserve(identifier.size() + 2);
+    quoted.push_back('"');
+    for (char c : identifier) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+// "rowid" and its aliases must stay unquoted, or SQLite would look for a real column.
+std::string key_expression(std::string const &key) {
+    if (sqlite3_stricmp(key.c_str(), "rowid") == 0 || sqlite3_stricmp(key.c_str(), "oid") == 0 ||
+        sqlite3_stricmp(key.c_str(), "_rowid_") == 0) {
+        return key;
+    }
+    return quote_identifier(key);
+}
+
+int to_native(sqlite::checkpoint_mode mode) {
+    switch (mode) {
+    case sqlite::checkpoint_mode::full:
+        return SQLITE_CHECKPOINT_FULL;
+    case sqlite::checkpoint_mode::restart:
+        return SQLITE_CHECKPOINT_RESTART;
+    case sqlite::checkpoint_mode::truncate:
+        return SQLITE_CHECKPOINT_TRUNCATE;
+    case sqlite::checkpoint_mode::passive:
+    default:
+        return SQLITE_CHECKPOINT_PASSIVE;
+    }
+}
+
+std::chrono::microseconds micros(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d);
+}
+
+std::size_t clamp_chunk(std::size_t size, sqlite::chunked_mutation_options const &options) {
+    auto lower = std::max<std::size_t>(options.min_chunk, 1);
+    return std::clamp(size, lower, std::max(options.max_chunk, lower));
+}
+
+std::size_t next_chunk_size(std::size_t current, std::chrono::microseconds took,
+                            sqlite::chunked_mutation_options const &options) {
+    auto budget = std::chrono::duration_cast<std::chrono::microseconds>(options.time_budget);
+    double scale = 2.0;
+    if (took.count() > 0 && budget.count() > 0) {
+        // Aim for the budget but never more than double or less than a quarter per step.
+        scale = std::clamp(static_cast<double>(budget.count()) / static_cast<double>(took.count()),
+                           0.25, 2.0);
+    }
+    return clamp_chunk(static_cast<std::size_t>(static_cast<double>(current) * scale), options);
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    chunked_mutation::chunked_mutation(connection &con, std::string table, std::string assignments,
+                                       std::string where) :
+        con_(con), table_(std::move(table)), assignments_(std::move(assignments)),
+        where_(std::move(where)) {
+        if (table_.empty()) {
+            throw database_exception("chunked_mutation needs a table name.");
+        }
+        if (where_.empty()) {
+            where_ = "1";
+        }
+    }
+
+    chunked_mutation chunked_mutation::remove(connection &con, std::string_view table,
+                                              std::string_view where) {
+        return chunked_mutation(con, std::string(table), std::string(), std::string(where));
+    }
+
+    chunked_mutation chunked_mutation::update(connection &con, std::string_view table,
+                                              std::string_view assignments,
+                                              std::string_view where) {
+        if (assignments.empty()) {
+            throw database_exception("chunked_mutation::update needs SET assignments.");
+        }
+        return chunked_mutation(con, std::string(table), std::string(assignments),
+                                std::string(where));
+    }
+
+    chunked_mutation_progress chunked_mutation::run(chunked_mutation_options const &options) {
+        auto key   = key_expression(options.key);
+        auto table = quote_identifier(table_);
+        // The predicate comes first so its positional parameters keep the numbers 1..n.
+        auto range = std::format("({}) AND {} >= :vsqlite_from", where_, key);
+        query upper(con_, std::format("SELECT max(k) FROM (SELECT {} AS k FROM {} WHERE {} "
+                                      "ORDER BY {} LIMIT :vsqlite_limit);",
+                                      key, table, range, key));
+        auto bounded = std::format("{} AND {} <= :vsqlite_upper", range, key);
+        command mutate(con_, assignments_.empty()
+                                 ? std::format("DELETE FROM {} WHERE {};", table, bounded)
+                                 : std::format("UPDATE {} SET {} WHERE {};", table, assignments_,
+                                               bounded));
+        auto *db = to_handle(con_);
+
+        chunked_mutation_progress progress;
+        progress.chunk_size = clamp_chunk(options.chunk_size, options);
+        // Inclusive, so a key of INT64_MIN is covered by the first chunk.
+        std::int64_t from = std::numeric_limits<std::int64_t>::min();
+        auto started       = std::chrono::steady_clock::now();
+
+        for (;;) {
+            auto chunk_start = std::chrono::steady_clock::now();
+            std::optional<std::int64_t> last;
+            {
+                transaction tx(con_, transaction_type::immediate);
+                try {
+                    upper.clear();
+                    if (binder_) {
+                        binder_(upper);
+                    }
+                    upper.bind(":vsqlite_from", from);
+                    upper.bind(":vsqlite_limit", static_cast<std::int64_t>(progress.chunk_size));
+                    for (auto value : upper.rows<std::optional<std::int64_t>>()) {
+                        last = value;
+                    }
+                    upper.clear();
+                    if (last) {
+                        mutate.clear();
+                        if (binder_) {
+                            binder_(mutate);
+                        }
+                        mutate.bind(":vsqlite_from", from);
+                        mutate.bind(":vsqlite_upper", *last);
+                        mutate();
+                        progress.rows += static_cast<std::uint64_t>(sqlite3_changes(db));
+                    }
+                    tx.commit();
+                } catch (...) {
+                    // Never hand a half-stepped statement back to the statement cache.
+                    upper.clear();
+                    throw;
+                }
+            }
+            auto now            = std::chrono::steady_clock::now();
+            progress.last_chunk = micros(now - chunk_start);
+            progress.elapsed    = micros(now - started);
+            if (!last) {
+                progress.finished = true;
+                if (options.progress) {
+                    options.progress(progress);
+                }
+                return progress;
+            }
+
+            progress.last_key = *last;
+            ++progress.chunks;
+            progress.chunk_size = next_chunk_size(progress.chunk_size, progress.last_chunk,
+                                                  options);
+            if (*last == std::numeric_limits<std::int64_t>::max()) {
+                // No key lies beyond this chunk, and last + 1 would overflow.
+                progress.finished = true;
+                if (options.progress) {
+                    options.progress(progress);
+                }
+                return progress;
+            }
+            from = *last + 1;
+            if (options.progress && !options.progress(progress)) {
+                return progress;
+            }
+            if (options.checkpoint_every > 0 && progress.chunks % options.checkpoint_every == 0) {
+                int rc = sqlite3_wal_checkpoint_v2(db, nullptr, to_native(options.checkpoint),
+                                                   nullptr, nullptr);
+                if (rc != SQLITE_OK && rc != SQLITE_BUSY) {
+                    throw database_exception_code(sqlite3_errmsg(db), rc);
+                }
+            }
+            if (options.pause.count() > 0) {
+                std::this_thread::sleep_for(options.pause);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+} // namespace v2
+} // namespace sqlite
@@ -247,6 +247,13 @@ inline namespace v2 {
         bind(idx, ptr);
     }
 
+    void command::bind(int idx, zeroblob blob) {
+        access_check();
+        int err = sqlite3_bind_zeroblob64(stmt, idx, static_cast<sqlite3_uint64>(blob.size));
+        if (err != SQLITE_OK)
+            throw database_exception_code(sqlite3_errmsg(get_handle()), err, m_sql);
+    }
+
     int command::parameter_index(std::string_view name) const {
         access_check();
         std::string owned(name);
@@ -298,6 +305,11 @@ inline namespace v2 {
         return *this;
     }
 
+    command &command::operator%(zeroblob v) {
+        bind(++last_arg_idx, v);
+        return *this;
+    }
+
     struct sqlite3 *command::get_handle() {
         return private_accessor::get_handle(m_con);
     }
@@ -42,6 +42,8 @@
 #include <sqlite3.h>
 #include <iostream>
 
+#include "change_hooks.hpp"
+
 namespace {
 bool is_special_database(std::string_view db) {
     if (db == ":memory:") {
@@ -140,6 +142,18 @@ int make_open_flags(bool readonly, bool allow_create) {
     return flags;
 }
 
+std::int64_t db_status(sqlite3 *db, int op, std::int64_t *highwater = nullptr) {
+    int current = 0;
+    int peak    = 0;
+    if (sqlite3_db_status(db, op, &current, &peak, 0) != SQLITE_OK) {
+        return 0;
+    }
+    if (highwater) {
+        *highwater = peak;
+    }
+    return current;
+}
+
 std::string quote_identifier(std::string_view identifier) {
     std::string quoted;
     quoted.reserve(identifier.size() + 2);
@@ -269,6 +283,10 @@ inline namespace v2 {
 
     void connection::close() {
         access_check();
+        // Caches and buses still alive detach from the registry later; keep it, minus the handle.
+        if (hooks_) {
+            hooks_->reset(nullptr);
+        }
         cache_.clear(handle);
         int err = sqlite3_close(handle);
         if (err != SQLITE_OK)
@@ -281,6 +299,25 @@ inline namespace v2 {
             throw database_exception("Database is not open.");
     }
 
+    detail::change_hooks &connection::change_hooks() {
+        access_check();
+        // Caches may be created from several threads; the connection's mutex orders them.
+        sqlite3_mutex *mutex = sqlite3_db_mutex(handle);
+        sqlite3_mutex_enter(mutex);
+        try {
+            if (!hooks_) {
+                hooks_ = std::make_unique<detail::change_hooks>(handle);
+            } else if (!hooks_->handle()) {
+                hooks_->reset(handle);
+            }
+        } catch (...) {
+            sqlite3_mutex_leave(mutex);
+            throw;
+        }
+        sqlite3_mutex_leave(mutex);
+        return *hooks_;
+    }
+
     void connection::attach(std::string const &db, std::string const &alias) {
         if (alias.empty()) {
             throw database_exception("Database alias must not be empty.");
@@ -305,6 +342,32 @@ inline namespace v2 {
         return static_cast<std::int64_t>(sqlite3_last_insert_rowid(handle));
     }
 
+    connection_stats connection::stats() const {
+        if (!handle)
+            throw database_exception("Database is not open.");
+        connection_stats out;
+        out.lookaside_used =
+            db_status(handle, SQLITE_DBSTATUS_LOOKASIDE_USED, &out.lookaside_used_highwater);
+        // The hit/miss counters only report a meaningful high-water value.
+        db_status(handle, SQLITE_DBSTATUS_LOOKASIDE_HIT, &out.lookaside_hit);
+        db_status(handle, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, &out.lookaside_miss_size);
+        db_status(handle, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, &out.lookaside_miss_full);
+        out.cache_used = db_status(handle, SQLITE_DBSTATUS_CACHE_USED);
+#ifdef SQLITE_DBSTATUS_CACHE_USED_SHARED
+        out.cache_used_shared = db_status(handle, SQLITE_DBSTATUS_CACHE_USED_SHARED);
+#endif
+        out.cache_hit   = db_status(handle, SQLITE_DBSTATUS_CACHE_HIT);
+        out.cache_miss  = db_status(handle, SQLITE_DBSTATUS_CACHE_MISS);
+        out.cache_write = db_status(handle, SQLITE_DBSTATUS_CACHE_WRITE);
+#ifdef SQLITE_DBSTATUS_CACHE_SPILL
+        out.cache_spill = db_status(handle, SQLITE_DBSTATUS_CACHE_SPILL);
+#endif
+        out.schema_used  = db_status(handle, SQLITE_DBSTATUS_SCHEMA_USED);
+        out.stmt_used    = db_status(handle, SQLITE_DBSTATUS_STMT_USED);
+        out.deferred_fks = db_status(handle, SQLITE_DBSTATUS_DEFERRED_FKS);
+        return out;
+    }
+
     void connection::configure_statement_cache(statement_cache_config const &cfg) {
         cache_.reset(cfg);
     }
@@ -99,23 +99,100 @@ inline namespace v2 {
         }
 
         if (needs_creation) {
-            try {
-                conn = factory_();
-            } catch (...) {
-                std::lock_guard<std::mutex> guard(mutex_);
-                --created_;
-                cv_.notify_one();
-                throw;
+            conn = create();
+        }
+
+        return lease(this, std::move(conn));
+    }
+
+    connection_pool::lease connection_pool::try_acquire() {
+        return try_acquire(nullptr);
+    }
+
+    connection_pool::lease connection_pool::try_acquire(std::function<void()> on_available) {
+        std::shared_ptr<connection> conn;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty()) {
+                conn = std::move(idle_.back());
+                idle_.pop_back();
+            } else if (created_ < capacity_) {
+                ++created_;
+            } else {
+                // Queued under the same lock as the check, so a release cannot slip in between.
+                if (on_available) {
+                    waiters_.push_back(std::move(on_available));
+                }
+                return lease();
             }
         }
 
+        if (!conn) {
+            conn = create();
+        }
+
         return lease(this, std::move(conn));
     }
 
+    std::shared_ptr<connection> connection_pool::create() {
+        std::shared_ptr<connection> conn;
+        try {
+            conn = factory_();
+        } catch (...) {
+            std::unique_lock<std::mutex> guard(mutex_);
+            --created_;
+            wake_one(guard);
+            throw;
+        }
+        // Gives stats() a baseline for connections that stay leased from the start.
+        try {
+            auto sample = conn->stats();
+            std::lock_guard<std::mutex> lock(mutex_);
+            remember(conn, sample);
+        } catch (database_exception const &) {
+        }
+        return conn;
+    }
+
+    void connection_pool::remember(std::shared_ptr<connection> const &conn,
+                                   connection_stats const &stats) const {
+        // Owner comparison never confuses a connection with a later one at the same address.
+        std::erase_if(samples_, [](stats_sample const &s) { return s.conn.expired(); });
+        for (auto &s : samples_) {
+            if (!s.conn.owner_before(conn) && !conn.owner_before(s.conn)) {
+                s.stats = stats;
+                return;
+            }
+        }
+        samples_.push_back({conn, stats});
+    }
+
     void connection_pool::release(std::shared_ptr<connection> conn) {
-        std::lock_guard<std::mutex> lock(mutex_);
+        // Sampled here, while no statement can be running, so stats() never waits on a lease.
+        connection_stats sample;
+        bool sampled = false;
+        try {
+            sample  = conn->stats();
+            sampled = true;
+        } catch (...) {
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (sampled) {
+            remember(conn, sample);
+        }
         idle_.push_back(std::move(conn));
+        wake_one(lock);
+    }
+
+    void connection_pool::wake_one(std::unique_lock<std::mutex> &lock) {
         cv_.notify_one();
+        if (waiters_.empty()) {
+            return;
+        }
+        auto waiter = std::move(waiters_.front());
+        waiters_.pop_front();
+        lock.unlock();
+        waiter();
     }
 
     std::size_t connection_pool::capacity() const {
@@ -132,5 +209,27 @@ inline namespace v2 {
         return created_;
     }
 
+    std::size_t connection_pool::leased_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return created_ - idle_.size();
+    }
+
+    pool_stats connection_pool::stats() const {
+        pool_stats out;
+        out.capacity = capacity_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.created = created_;
+        out.idle    = idle_.size();
+        // Idle connections cannot be acquired while we hold the lock, so sampling them is
+        // uncontended.
+        for (auto const &conn : idle_) {
+            remember(conn, conn->stats());
+        }
+        for (auto const &s : samples_) {
+            out.totals += s.stats;
+        }
+        return out;
+    }
+
 } // namespace v2
 } // namespace sqlite
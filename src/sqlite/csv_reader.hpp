@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sqlite/database_exception.hpp>
+
+namespace sqlite {
+inline namespace v2 {
+    namespace detail {
+
+        // memchr is vectorized by every mainstream libc; all delimiter, quote and newline scans go
+        // through it instead of a byte loop.
+        inline char const *find(char const *first, char const *last, char c) {
+            auto hit = first < last ? std::memchr(first, c, static_cast<std::size_t>(last - first))
+                                    : nullptr;
+            return hit ? static_cast<char const *>(hit) : last;
+        }
+
+        struct csv_field {
+            std::string_view text;
+            bool quoted = false;
+        };
+
+        /// RFC 4180 record reader over an in-memory buffer. Fields are views into the input,
+        /// except quoted fields with doubled quotes, which are unescaped into @c owned.
+        class csv_reader {
+        public:
+            csv_reader(std::string_view input, char delimiter) :
+                base_(input.data()), end_(input.data() + input.size()), delimiter_(delimiter) {}
+
+            /// Parses the record starting at @p pos and moves @p pos past its line end. Quoted
+            /// fields may run past any range limit up to the end of the input.
+            void read(char const *&pos, std::vector<csv_field> &fields,
+                      std::deque<std::string> &owned) const {
+                fields.clear();
+                char const *p        = pos;
+                char const *line_end = find(p, end_, '\n');
+                for (;;) {
+                    if (p < end_ && *p == '"') {
+                        char const *start = ++p;
+                        std::string *unescaped = nullptr;
+                        for (;;) {
+                            char const *q = find(p, end_, '"');
+                            if (q == end_) {
+                                throw database_exception(
+                                    std::format("Unterminated quoted CSV field at byte {}.",
+                                                start - 1 - base_));
+                            }
+                            if (q + 1 < end_ && q[1] == '"') {
+                                if (unescaped == nullptr) {
+                                    unescaped = &owned.emplace_back(start, q + 1);
+                                } else {
+                                    unescaped->append(p, q + 1);
+                                }
+                                p = q + 2;
+                                continue;
+                            }
+                            if (unescaped != nullptr) {
+                                unescaped->append(p, q);
+                                fields.push_back({*unescaped, true});
+                            } else {
+                                fields.push_back({std::string_view(start, q - start), true});
+                            }
+                            p = q + 1;
+                            break;
+                        }
+                        if (p > line_end) {
+                            line_end = find(p, end_, '\n');
+                        }
+                        if (p < end_ && *p == delimiter_) {
+                            ++p;
+                            continue;
+                        }
+                        if (p < end_ && *p == '\r') {
+                            ++p;
+                        }
+                        if (p == end_ || *p == '\n') {
+                            pos = p == end_ ? end_ : p + 1;
+                            return;
+                        }
+                        throw database_exception(std::format(
+                            "Unexpected character after quoted CSV field at byte {}.", p - base_));
+                    }
+                    char const *field_end = find(p, line_end, delimiter_);
+                    if (field_end != line_end) {
+                        fields.push_back({std::string_view(p, field_end - p), false});
+                        p = field_end + 1;
+                        continue;
+                    }
+                    std::string_view last(p, line_end - p);
+                    if (!last.empty() && last.back() == '\r') {
+                        last.remove_suffix(1);
+                    }
+                    fields.push_back({last, false});
+                    pos = line_end == end_ ? end_ : line_end + 1;
+                    return;
+                }
+            }
+
+            std::size_t offset(char const *p) const noexcept {
+                return static_cast<std::size_t>(p - base_);
+            }
+
+        private:
+            char const *base_;
+            char const *end_;
+            char delimiter_;
+        };
+
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,465 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/csv_table.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+
+#include <sqlite3.h>
+
+#include "csv_reader.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <deque>
+#include <format>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+using sqlite::detail::csv_field;
+using sqlite::detail::csv_reader;
+using sqlite::detail::mapped_file;
+
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+std::string quote_identifier(std::string_view identifier) {
+    std::string quoted;
+    quoted.reserve(identifier.size() + 2);
+    quoted.push_back('"');
+    for (char c : identifier) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Module arguments arrive as raw SQL tokens: 'a''b', "a" or a bare word.
+std::string unquote(std::string_view text) {
+    if (text.size() < 2 || (text.front() != '\'' && text.front() != '"') ||
+        text.back() != text.front()) {
+        return std::string(text);
+    }
+    char quote = text.front();
+    std::string out;
+    for (std::size_t i = 1; i + 1 < text.size(); ++i) {
+        out.push_back(text[i]);
+        if (text[i] == quote && text[i + 1] == quote) {
+            ++i;
+        }
+    }
+    return out;
+}
+
+bool parse_flag(std::string const &name, std::string const &value) {
+    for (char const *yes : {"yes", "true", "on", "1"}) {
+        if (sqlite3_stricmp(value.c_str(), yes) == 0) {
+            return true;
+        }
+    }
+    for (char const *no : {"no", "false", "off", "0"}) {
+        if (sqlite3_stricmp(value.c_str(), no) == 0) {
+            return false;
+        }
+    }
+    throw sqlite::database_exception(
+        std::format("csv: {} expects yes or no, got '{}'.", name, value));
+}
+
+bool blank(std::vector<csv_field> const &fields) {
+    return fields.size() == 1 && !fields[0].quoted && fields[0].text.empty();
+}
+
+struct csv_table : sqlite3_vtab {
+    std::unique_ptr<mapped_file> file;
+    std::string_view data;
+    std::size_t body  = 0; ///< Offset of the first data record
+    char delimiter    = ',';
+    int key           = -1;
+    bool indexed      = false;
+    bool keyed        = false;
+    std::vector<std::size_t> starts; ///< Record offsets, filled by the first scan
+    std::unordered_map<std::string_view, std::vector<std::size_t>> key_index;
+    std::deque<std::string> key_text; ///< Unescaped keys referenced by key_index
+
+    csv_reader reader() const {
+        return csv_reader(data, delimiter);
+    }
+
+    bool in_mapping(std::string_view text) const noexcept {
+        return text.data() >= data.data() && text.data() + text.size() <= data.data() + data.size();
+    }
+
+    void build_index() {
+        if (indexed) {
+            return;
+        }
+        auto csv = reader();
+        std::vector<csv_field> fields;
+        std::deque<std::string> scratch;
+        char const *pos = data.data() + body;
+        char const *end = data.data() + data.size();
+        while (pos < end) {
+            auto start = static_cast<std::size_t>(pos - data.data());
+            csv.read(pos, fields, scratch);
+            scratch.clear();
+            if (!blank(fields)) {
+                starts.push_back(start);
+            }
+        }
+        indexed = true;
+    }
+
+    void build_key_index() {
+        if (keyed) {
+            return;
+        }
+        build_index();
+        auto csv = reader();
+        std::vector<csv_field> fields;
+        std::deque<std::string> scratch;
+        auto column = static_cast<std::size_t>(key);
+        for (std::size_t record = 0; record < starts.size(); ++record) {
+            char const *pos = data.data() + starts[record];
+            csv.read(pos, fields, scratch);
+            if (column < fields.size() && (fields[column].quoted || !fields[column].text.empty())) {
+                auto text = fields[column].text;
+                if (!in_mapping(text)) {
+                    text = key_text.emplace_back(text);
+                }
+                key_index[text].push_back(record);
+            }
+            scratch.clear();
+        }
+        keyed = true;
+    }
+};
+
+struct csv_cursor : sqlite3_vtab_cursor {
+    std::vector<std::size_t> const *matches = nullptr; ///< Records of a key lookup
+    std::size_t pos    = 0;
+    std::size_t end    = 0;
+    std::size_t parsed = SIZE_MAX;
+    std::vector<csv_field> fields;
+    std::deque<std::string> owned;
+
+    csv_table &table() const {
+        return *static_cast<csv_table *>(pVtab);
+    }
+
+    std::size_t record() const {
+        return matches ? (*matches)[pos] : pos;
+    }
+
+    void parse() {
+        if (parsed == record()) {
+            return;
+        }
+        auto &t = table();
+        owned.clear();
+        char const *at = t.data.data() + t.starts[record()];
+        t.reader().read(at, fields, owned);
+        parsed = record();
+    }
+};
+
+constexpr int scan_all   = 0;
+constexpr int seek_rowid = 1;
+constexpr int seek_key   = 2;
+
+int csv_connect(sqlite3 *db, void *, int argc, char const *const *argv, sqlite3_vtab **out,
+                char **error) {
+    try {
+        auto table = std::make_unique<csv_table>();
+        std::string filename;
+        std::string key;
+        bool header = true;
+        for (int i = 3; i < argc; ++i) {
+            std::string_view arg(argv[i]);
+            auto eq = arg.find('=');
+            if (eq == std::string_view::npos) {
+                throw sqlite::database_exception(
+                    std::format("csv: expected name = value, got '{}'.", arg));
+            }
+            auto name  = std::string(trim(arg.substr(0, eq)));
+            auto value = unquote(trim(arg.substr(eq + 1)));
+            if (sqlite3_stricmp(name.c_str(), "filename") == 0) {
+                filename = value;
+            } else if (sqlite3_stricmp(name.c_str(), "header") == 0) {
+                header = parse_flag(name, value);
+            } else if (sqlite3_stricmp(name.c_str(), "delimiter") == 0) {
+                if (value.size() != 1) {
+                    throw sqlite::database_exception("csv: delimiter must be a single character.");
+                }
+                table->delimiter = value.front();
+            } else if (sqlite3_stricmp(name.c_str(), "key") == 0) {
+                key = value;
+            } else {
+                throw sqlite::database_exception(std::format("csv: unknown argument '{}'.", name));
+            }
+        }
+        if (filename.empty()) {
+            throw sqlite::database_exception("csv: the filename argument is required.");
+        }
+        table->file = std::make_unique<mapped_file>(filename, false);
+        table->data = table->file->view();
+
+        std::vector<csv_field> first;
+        std::deque<std::string> scratch;
+        char const *pos = table->data.data();
+        if (!table->data.empty()) {
+            table->reader().read(pos, first, scratch);
+        }
+        if (header) {
+            table->body = static_cast<std::size_t>(pos - table->data.data());
+        }
+        std::vector<std::string> names;
+        for (std::size_t i = 0; i < first.size(); ++i) {
+            bool named = header && !first[i].text.empty();
+            names.push_back(named ? std::string(first[i].text) : std::format("c{}", i + 1));
+        }
+        if (names.empty()) {
+            throw sqlite::database_exception(std::format("csv: no columns found in {}.", filename));
+        }
+        std::string schema = "CREATE TABLE x(";
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            schema += (i ? ", " : "") + quote_identifier(names[i]);
+            if (!key.empty() && sqlite3_stricmp(names[i].c_str(), key.c_str()) == 0) {
+                table->key = static_cast<int>(i);
+            }
+        }
+        schema += ");";
+        if (!key.empty() && table->key < 0) {
+            throw sqlite::database_exception(std::format("csv: key column '{}' not found.", key));
+        }
+        if (sqlite3_declare_vtab(db, schema.c_str()) != SQLITE_OK) {
+            throw sqlite::database_exception(sqlite3_errmsg(db));
+        }
+        *out = table.release();
+        return SQLITE_OK;
+    } catch (std::exception const &e) {
+        *error = sqlite3_mprintf("%s", e.what());
+        return SQLITE_ERROR;
+    }
+}
+
+int csv_disconnect(sqlite3_vtab *vtab) {
+    delete static_cast<csv_table *>(vtab);
+    return SQLITE_OK;
+}
+
+int csv_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+    auto &table = *static_cast<csv_table *>(vtab);
+    int rowid   = -1;
+    int key     = -1;
+    for (int i = 0; i < info->nConstraint; ++i) {
+        auto const &constraint = info->aConstraint[i];
+        if (!constraint.usable || constraint.op != SQLITE_INDEX_CONSTRAINT_EQ) {
+            continue;
+        }
+        if (constraint.iColumn == -1) {
+            rowid = i;
+        } else if (constraint.iColumn == table.key && table.key >= 0 &&
+                   sqlite3_stricmp(sqlite3_vtab_collation(info, i), "BINARY") == 0) {
+            key = i;
+        }
+    }
+    // Before the first scan, guess the row count from the file size.
+    double rows = table.indexed ? static_cast<double>(table.starts.size())
+                                : static_cast<double>(table.data.size()) / 64.0 + 1.0;
+    int chosen  = rowid >= 0 ? rowid : key;
+    if (chosen >= 0) {
+        // The key index matches the probe's text form, so `id = 42` also finds "42"; let SQLite
+        // re-check the comparison so the result does not depend on the plan.
+        info->aConstraintUsage[chosen].argvIndex = 1;
+        info->aConstraintUsage[chosen].omit      = chosen == rowid;
+    }
+    if (rowid >= 0) {
+        info->idxNum        = seek_rowid;
+        info->idxFlags      = SQLITE_INDEX_SCAN_UNIQUE;
+        info->estimatedCost = 1.0;
+        info->estimatedRows = 1;
+    } else if (key >= 0) {
+        info->idxNum        = seek_key;
+        info->estimatedCost = 10.0;
+        info->estimatedRows = 10;
+    } else {
+        info->idxNum        = scan_all;
+        info->estimatedCost = rows;
+        info->estimatedRows = static_cast<sqlite3_int64>(rows);
+    }
+    return SQLITE_OK;
+}
+
+int csv_open(sqlite3_vtab *, sqlite3_vtab_cursor **out) {
+    *out = new csv_cursor();
+    return SQLITE_OK;
+}
+
+int csv_close(sqlite3_vtab_cursor *cursor) {
+    delete static_cast<csv_cursor *>(cursor);
+    return SQLITE_OK;
+}
+
+int csv_filter(sqlite3_vtab_cursor *base, int idx_num, char const *, int argc,
+               sqlite3_value **argv) {
+    auto &cursor = *static_cast<csv_cursor *>(base);
+    auto &table  = cursor.table();
+    try {
+        table.build_index();
+        cursor.matches = nullptr;
+        cursor.parsed  = SIZE_MAX;
+        cursor.pos     = 0;
+        cursor.end     = 0;
+        if (idx_num == seek_rowid && argc == 1) {
+            auto rowid = sqlite3_value_int64(argv[0]);
+            if (rowid >= 1 && static_cast<std::uint64_t>(rowid) <= table.starts.size()) {
+                cursor.pos = static_cast<std::size_t>(rowid - 1);
+                cursor.end = cursor.pos + 1;
+            }
+        } else if (idx_num == seek_key && argc == 1) {
+            table.build_key_index();
+            auto text = reinterpret_cast<char const *>(sqlite3_value_text(argv[0]));
+            if (text != nullptr) {
+                auto it = table.key_index.find(
+                    std::string_view(text, static_cast<std::size_t>(sqlite3_value_bytes(argv[0]))));
+                if (it != table.key_index.end()) {
+                    cursor.matches = &it->second;
+                    cursor.end     = it->second.size();
+                }
+            }
+        } else {
+            cursor.end = table.starts.size();
+        }
+        return SQLITE_OK;
+    } catch (std::exception const &e) {
+        sqlite3_free(table.zErrMsg);
+        table.zErrMsg = sqlite3_mprintf("%s", e.what());
+        return SQLITE_ERROR;
+    }
+}
+
+int csv_next(sqlite3_vtab_cursor *base) {
+    ++static_cast<csv_cursor *>(base)->pos;
+    return SQLITE_OK;
+}
+
+int csv_eof(sqlite3_vtab_cursor *base) {
+    auto &cursor = *static_cast<csv_cursor *>(base);
+    return cursor.pos >= cursor.end;
+}
+
+int csv_column(sqlite3_vtab_cursor *base, sqlite3_context *ctx, int column) {
+    auto &cursor = *static_cast<csv_cursor *>(base);
+    try {
+        cursor.parse();
+    } catch (std::exception const &e) {
+        sqlite3_result_error(ctx, e.what(), -1);
+        return SQLITE_ERROR;
+    }
+    auto index = static_cast<std::size_t>(column);
+    if (index >= cursor.fields.size()) {
+        sqlite3_result_null(ctx);
+        return SQLITE_OK;
+    }
+    auto const &field = cursor.fields[index];
+    if (!field.quoted && field.text.empty()) {
+        sqlite3_result_null(ctx);
+        return SQLITE_OK;
+    }
+    if (field.text.size() > static_cast<std::size_t>(INT_MAX)) {
+        sqlite3_result_error_toobig(ctx);
+        return SQLITE_OK;
+    }
+    // The mapping lives as long as the table, which outlives every statement reading it.
+    sqlite3_result_text(ctx, field.text.data(), static_cast<int>(field.text.size()),
+                        cursor.table().in_mapping(field.text) ? SQLITE_STATIC : SQLITE_TRANSIENT);
+    return SQLITE_OK;
+}
+
+int csv_rowid(sqlite3_vtab_cursor *base, sqlite3_int64 *rowid) {
+    auto &cursor = *static_cast<csv_cursor *>(base);
+    *rowid       = static_cast<sqlite3_int64>(cursor.record()) + 1;
+    return SQLITE_OK;
+}
+
+sqlite3_module make_csv_module() {
+    sqlite3_module module{};
+    module.iVersion    = 1;
+    module.xCreate     = csv_connect;
+    module.xConnect    = csv_connect;
+    module.xBestIndex  = csv_best_index;
+    module.xDisconnect = csv_disconnect;
+    module.xDestroy    = csv_disconnect;
+    module.xOpen       = csv_open;
+    module.xClose      = csv_close;
+    module.xFilter     = csv_filter;
+    module.xNext       = csv_next;
+    module.xEof        = csv_eof;
+    module.xColumn     = csv_column;
+    module.xRowid      = csv_rowid;
+    return module;
+}
+
+sqlite3_module const csv_module = make_csv_module();
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    void register_csv_module(connection &con, std::string const &name) {
+        auto db = to_handle(con);
+        int rc  = sqlite3_create_module_v2(db, name.c_str(), &csv_module, nullptr, nullptr);
+        if (rc != SQLITE_OK) {
+            throw database_exception_code(sqlite3_errmsg(db), rc);
+        }
+    }
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,205 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <sqlite/database_exception.hpp>
+#include <sqlite/executor.hpp>
+
+namespace sqlite {
+inline namespace v2 {
+    materialized_rows materialize(query &q) {
+        materialized_rows out;
+        auto res    = q.get_result();
+        int columns = res->get_column_count();
+        out.columns.reserve(static_cast<std::size_t>(columns));
+        for (int i = 0; i < columns; ++i) {
+            out.columns.push_back(res->get_column_name(i));
+        }
+        while (res->next_row()) {
+            std::vector<variant_t> row;
+            row.reserve(static_cast<std::size_t>(columns));
+            for (int i = 0; i < columns; ++i) {
+                row.push_back(res->get_variant(i));
+            }
+            out.rows.push_back(std::move(row));
+        }
+        return out;
+    }
+
+    struct executor::worker {
+        std::shared_ptr<connection> con;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<job> jobs;
+        std::atomic<std::size_t> load{0}; ///< Queued plus running jobs; drives placement.
+        bool stop = false;
+        std::thread thread;
+    };
+
+    executor::executor(std::size_t workers, connection_pool::connection_factory factory) {
+        if (workers == 0) {
+            throw database_exception("executor requires at least one worker");
+        }
+        if (!factory) {
+            throw database_exception("executor requires a valid factory");
+        }
+        workers_.reserve(workers);
+        for (std::size_t i = 0; i < workers; ++i) {
+            auto w = std::make_unique<worker>();
+            w->con = factory();
+            if (!w->con) {
+                throw database_exception("executor factory returned no connection");
+            }
+            workers_.push_back(std::move(w));
+        }
+        std::size_t started = 0;
+        try {
+            for (; started < workers_.size(); ++started) {
+                workers_[started]->thread = std::thread([this, started] { run(started); });
+            }
+        } catch (...) {
+            for (std::size_t i = 0; i < started; ++i) {
+                {
+                    std::lock_guard<std::mutex> lock(workers_[i]->mutex);
+                    workers_[i]->stop = true;
+                }
+                workers_[i]->wake.notify_one();
+                workers_[i]->thread.join();
+            }
+            throw;
+        }
+    }
+
+    executor::~executor() {
+        for (auto &w : workers_) {
+            {
+                std::lock_guard<std::mutex> lock(w->mutex);
+                w->stop = true;
+            }
+            w->wake.notify_one();
+        }
+        for (auto &w : workers_) {
+            if (w->thread.joinable()) {
+                w->thread.join();
+            }
+        }
+    }
+
+    void executor::enqueue(job fn) {
+        worker *target = workers_.front().get();
+        auto least     = target->load.load(std::memory_order_relaxed);
+        for (auto &w : workers_) {
+            auto load = w->load.load(std::memory_order_relaxed);
+            if (load < least) {
+                least  = load;
+                target = w.get();
+            }
+        }
+        target->load.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(target->mutex);
+            target->jobs.push_back(std::move(fn));
+        }
+        target->wake.notify_one();
+    }
+
+    bool executor::try_steal(std::size_t thief, job &out) {
+        auto count = workers_.size();
+        for (std::size_t offset = 1; offset < count; ++offset) {
+            auto &victim = *workers_[(thief + offset) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.jobs.empty()) {
+                continue;
+            }
+            // Take the newest job so the victim keeps the ones it is most likely to run next.
+            out = std::move(victim.jobs.back());
+            victim.jobs.pop_back();
+            victim.load.fetch_sub(1, std::memory_order_relaxed);
+            workers_[thief]->load.fetch_add(1, std::memory_order_relaxed);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void executor::run(std::size_t index) {
+        auto &self = *workers_[index];
+        while (true) {
+            job next;
+            {
+                std::unique_lock<std::mutex> lock(self.mutex);
+                if (self.jobs.empty()) {
+                    lock.unlock();
+                    bool stolen = try_steal(index, next);
+                    lock.lock();
+                    if (!stolen) {
+                        self.wake.wait(lock, [&self] { return self.stop || !self.jobs.empty(); });
+                        if (self.jobs.empty()) {
+                            return;
+                        }
+                    }
+                }
+                if (!next) {
+                    next = std::move(self.jobs.front());
+                    self.jobs.pop_front();
+                }
+            }
+            try {
+                next(*self.con);
+            } catch (...) {
+                // post()/submit() route failures through their futures or callbacks.
+            }
+            self.load.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t executor::worker_count() const noexcept {
+        return workers_.size();
+    }
+
+    std::size_t executor::pending() const noexcept {
+        std::size_t total = 0;
+        for (auto const &w : workers_) {
+            total += w->load.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::size_t executor::steal_count() const noexcept {
+        return steals_.load(std::memory_order_relaxed);
+    }
+} // namespace v2
+} // namespace sqlite
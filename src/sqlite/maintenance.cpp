@@ -0,0 +1,309 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <algorithm>
+#include <optional>
+#include <string>
+
+#include <sqlite/connection.hpp>
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/maintenance.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+
+#include <sqlite3.h>
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+int read_pragma_int(sqlite::connection &con, std::string const &pragma) {
+    sqlite::query q(con, "PRAGMA " + pragma + ";");
+    auto res = q.get_result();
+    if (!res->next_row()) {
+        throw sqlite::database_exception("Failed to read PRAGMA " + pragma + ".");
+    }
+    return res->get<int>(0);
+}
+
+void run_to_completion(sqlite::connection &con, std::string const &sql) {
+    sqlite::execute cmd(con, sql);
+    while (cmd.step_once()) {
+    }
+}
+
+/// Applies the per-task budget for its lifetime: no busy waiting, progress-based interruption.
+class budget_guard {
+public:
+    budget_guard(sqlite::connection &con, std::chrono::milliseconds budget) :
+        db_(to_handle(con)), deadline_(clock_type::now() + budget),
+        previous_busy_timeout_(read_pragma_int(con, "busy_timeout")) {
+        sqlite3_busy_timeout(db_, 0);
+        sqlite3_progress_handler(db_, 1000, &budget_guard::on_progress, this);
+    }
+
+    ~budget_guard() {
+        // SQLite has no getter for the previous progress handler, so it cannot be put back.
+        sqlite3_progress_handler(db_, 0, nullptr, nullptr);
+        sqlite3_busy_timeout(db_, previous_busy_timeout_);
+    }
+
+    budget_guard(budget_guard const &)            = delete;
+    budget_guard &operator=(budget_guard const &) = delete;
+
+    bool expired() const {
+        return clock_type::now() >= deadline_;
+    }
+
+    sqlite3 *handle() const {
+        return db_;
+    }
+
+private:
+    static int on_progress(void *self) {
+        return static_cast<budget_guard *>(self)->expired() ? 1 : 0;
+    }
+
+    sqlite3 *db_;
+    clock_type::time_point deadline_;
+    int previous_busy_timeout_;
+};
+
+enum class outcome { completed, busy, interrupted, failed };
+
+void run_optimize(sqlite::connection &con, int analysis_limit) {
+    int previous = read_pragma_int(con, "analysis_limit");
+    run_to_completion(con, "PRAGMA analysis_limit=" + std::to_string(analysis_limit) + ";");
+    try {
+        run_to_completion(con, "PRAGMA optimize;");
+    } catch (...) {
+        run_to_completion(con, "PRAGMA analysis_limit=" + std::to_string(previous) + ";");
+        throw;
+    }
+    run_to_completion(con, "PRAGMA analysis_limit=" + std::to_string(previous) + ";");
+}
+
+/// Frees pages in small autocommit chunks so the write lock is only held briefly each time.
+outcome run_vacuum(sqlite::connection &con, budget_guard const &guard, int pages_per_step,
+                   std::uint64_t &freed) {
+    // auto_vacuum=2 is INCREMENTAL; other modes have nothing for incremental_vacuum to do.
+    if (read_pragma_int(con, "auto_vacuum") != 2) {
+        return outcome::completed;
+    }
+    auto step_sql = "PRAGMA incremental_vacuum(" + std::to_string(pages_per_step) + ");";
+    int before    = read_pragma_int(con, "freelist_count");
+    while (before > 0) {
+        if (guard.expired()) {
+            return outcome::interrupted;
+        }
+        run_to_completion(con, step_sql);
+        int after = read_pragma_int(con, "freelist_count");
+        if (after >= before) {
+            break;
+        }
+        freed += static_cast<std::uint64_t>(before - after);
+        before = after;
+    }
+    return outcome::completed;
+}
+
+outcome run_checkpoint(sqlite3 *db) {
+    int rc = sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
+    if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        return outcome::busy;
+    }
+    if (rc != SQLITE_OK) {
+        throw sqlite::database_exception_code(sqlite3_errmsg(db), rc);
+    }
+    return outcome::completed;
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    maintenance_scheduler::maintenance_scheduler(connection_pool &pool,
+                                                 maintenance_options options) :
+        pool_(pool), options_(std::move(options)) {
+        worker_ = std::thread([this] { run(); });
+    }
+
+    maintenance_scheduler::~maintenance_scheduler() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    bool maintenance_scheduler::pool_is_idle() const {
+        auto capacity = static_cast<double>(pool_.capacity());
+        auto leased   = static_cast<double>(pool_.leased_count());
+        return leased / capacity <= options_.idle_utilization;
+    }
+
+    void maintenance_scheduler::run() {
+        std::optional<clock::time_point> idle_since;
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (!stop_) {
+            wake_.wait_for(lock, options_.poll_interval, [this] { return stop_; });
+            if (stop_) {
+                break;
+            }
+            lock.unlock();
+
+            auto now = clock::now();
+            if (!pool_is_idle()) {
+                idle_since.reset();
+            } else if (!idle_since) {
+                idle_since = now;
+            }
+
+            if (idle_since && now - *idle_since >= options_.idle_window) {
+                // At most one task per poll; each task is rate limited by its own interval.
+                std::optional<maintenance_task> due;
+                if (options_.checkpoint && now - last_checkpoint_ >= options_.checkpoint_every) {
+                    due              = maintenance_task::checkpoint;
+                    last_checkpoint_ = now;
+                } else if (options_.vacuum_pages_per_step > 0 &&
+                           now - last_vacuum_ >= options_.vacuum_every) {
+                    due          = maintenance_task::incremental_vacuum;
+                    last_vacuum_ = now;
+                } else if (options_.optimize && now - last_optimize_ >= options_.optimize_every) {
+                    due            = maintenance_task::optimize;
+                    last_optimize_ = now;
+                }
+                if (due) {
+                    try {
+                        execute_task(*due);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+                        ++stats_.failures;
+                    }
+                }
+            }
+            lock.lock();
+        }
+    }
+
+    bool maintenance_scheduler::run_now(maintenance_task task) {
+        return execute_task(task);
+    }
+
+    bool maintenance_scheduler::execute_task(maintenance_task task) {
+        auto lease = pool_.try_acquire();
+        if (!lease) {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            ++stats_.skipped_busy;
+            return false;
+        }
+
+        auto start          = clock::now();
+        auto result         = outcome::completed;
+        std::uint64_t freed = 0;
+        try {
+            budget_guard guard(*lease, options_.task_budget);
+            switch (task) {
+            case maintenance_task::optimize:
+                run_optimize(*lease, options_.analysis_limit);
+                break;
+            case maintenance_task::incremental_vacuum:
+                result = run_vacuum(*lease, guard, std::max(options_.vacuum_pages_per_step, 1),
+                                    freed);
+                break;
+            case maintenance_task::checkpoint:
+                result = run_checkpoint(guard.handle());
+                break;
+            }
+        } catch (database_exception_code const &ex) {
+            switch (ex.error_code() & 0xff) {
+            case SQLITE_BUSY:
+            case SQLITE_LOCKED:
+                result = outcome::busy;
+                break;
+            case SQLITE_INTERRUPT:
+                result = outcome::interrupted;
+                break;
+            default:
+                result = outcome::failed;
+                break;
+            }
+        } catch (...) {
+            result = outcome::failed;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        switch (task) {
+        case maintenance_task::optimize:
+            ++stats_.optimize_runs;
+            break;
+        case maintenance_task::incremental_vacuum:
+            ++stats_.vacuum_runs;
+            break;
+        case maintenance_task::checkpoint:
+            ++stats_.checkpoint_runs;
+            break;
+        }
+        stats_.pages_vacuumed += freed;
+        switch (result) {
+        case outcome::busy:
+            ++stats_.skipped_busy;
+            break;
+        case outcome::interrupted:
+            ++stats_.interrupted;
+            break;
+        case outcome::failed:
+            ++stats_.failures;
+            break;
+        case outcome::completed:
+            break;
+        }
+        stats_.last_duration = elapsed;
+        stats_.max_duration  = std::max(stats_.max_duration, elapsed);
+        return result == outcome::completed;
+    }
+
+    maintenance_stats maintenance_scheduler::stats() const {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return stats_;
+    }
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,126 @@
+#pragma once
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include <sqlite/database_exception.hpp>
+
+namespace sqlite {
+inline namespace v2 {
+    namespace detail {
+
+        /// Read-only mapping of a whole file. Empty files yield an empty view.
+        class mapped_file {
+        public:
+            explicit mapped_file(std::filesystem::path const &path, bool sequential = true) {
+#if defined(_WIN32)
+                file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                    nullptr, OPEN_EXISTING,
+                                    sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL,
+                                    nullptr);
+                if (file_ == INVALID_HANDLE_VALUE) {
+                    fail("open", path);
+                }
+                LARGE_INTEGER size{};
+                if (!GetFileSizeEx(file_, &size)) {
+                    fail("stat", path);
+                }
+                size_ = static_cast<std::size_t>(size.QuadPart);
+                if (size_ != 0) {
+                    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                    if (mapping_ == nullptr) {
+                        fail("map", path);
+                    }
+                    data_ = static_cast<char const *>(
+                        MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+                    if (data_ == nullptr) {
+                        fail("map", path);
+                    }
+                }
+#else
+                fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd_ < 0) {
+                    fail("open", path);
+                }
+                struct stat st {};
+                if (::fstat(fd_, &st) != 0) {
+                    fail("stat", path);
+                }
+                size_ = static_cast<std::size_t>(st.st_size);
+                if (size_ != 0) {
+                    void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+                    if (addr == MAP_FAILED) {
+                        fail("map", path);
+                    }
+                    data_ = static_cast<char const *>(addr);
+                    ::madvise(addr, size_, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+                }
+#endif
+            }
+
+            ~mapped_file() {
+                close();
+            }
+
+            mapped_file(mapped_file const &)            = delete;
+            mapped_file &operator=(mapped_file const &) = delete;
+
+            std::string_view view() const noexcept {
+                return {data_ ? data_ : "", size_};
+            }
+
+        private:
+            [[noreturn]] void fail(char const *what, std::filesystem::path const &path) {
+                close();
+                throw database_exception("Failed to " + std::string(what) + " " + path.string());
+            }
+
+            void close() noexcept {
+#if defined(_WIN32)
+                if (data_ != nullptr) {
+                    UnmapViewOfFile(data_);
+                }
+                if (mapping_ != nullptr) {
+                    CloseHandle(mapping_);
+                }
+                if (file_ != INVALID_HANDLE_VALUE) {
+                    CloseHandle(file_);
+                }
+                mapping_ = nullptr;
+                file_    = INVALID_HANDLE_VALUE;
+#else
+                if (data_ != nullptr) {
+                    ::munmap(const_cast<char *>(data_), size_);
+                }
+                if (fd_ >= 0) {
+                    ::close(fd_);
+                }
+                fd_ = -1;
+#endif
+                data_ = nullptr;
+            }
+
+#if defined(_WIN32)
+            HANDLE file_    = INVALID_HANDLE_VALUE;
+            HANDLE mapping_ = nullptr;
+#else
+            int fd_ = -1;
+#endif
+            char const *data_ = nullptr;
+            std::size_t size_ = 0;
+        };
+
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,460 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/materialized_view.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/savepoint.hpp>
+
+#include <sqlite3.h>
+
+#include "statement_tables.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <functional>
+#include <optional>
+
+namespace {
+constexpr char const *registry_table = "vsqlite_materialized_views";
+
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+std::string quote_identifier(std::string_view identifier) {
+    std::string quoted;
+    quoted.reserve(identifier.size() + 2);
+    quoted.push_back('"');
+    for (char c : identifier) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+std::string quote_literal(std::string_view text) {
+    std::string quoted;
+    quoted.reserve(text.size() + 2);
+    quoted.push_back('\'');
+    for (char c : text) {
+        if (c == '\'') {
+            quoted.push_back('\'');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('\'');
+    return quoted;
+}
+
+// Savepoint destructors release, so roll back explicitly when the body throws.
+void in_savepoint(sqlite::connection &con, std::function<void()> const &body) {
+    sqlite::savepoint sp(con, "vsqlite_materialized_view");
+    try {
+        body();
+    } catch (...) {
+        try {
+            sp.rollback();
+        } catch (...) {
+        }
+        throw;
+    }
+    sp.release();
+}
+
+void ensure_registry(sqlite::connection &con) {
+    sqlite::execute(con,
+                    std::format("CREATE TABLE IF NOT EXISTS {}(name TEXT PRIMARY KEY, "
+                                "definition TEXT NOT NULL, incremental INTEGER NOT NULL, "
+                                "triggers TEXT NOT NULL, pending INTEGER NOT NULL DEFAULT 0, "
+                                "refreshed_at INTEGER NOT NULL);",
+                                registry_table),
+                    true);
+}
+
+std::string join(std::vector<std::string> const &parts, std::string_view separator) {
+    std::string out;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        if (i > 0) {
+            out += separator;
+        }
+        out += parts[i];
+    }
+    return out;
+}
+
+std::vector<std::string> split_lines(std::string const &text) {
+    std::vector<std::string> out;
+    std::size_t start = 0;
+    while (start < text.size()) {
+        auto end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        out.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+void register_view(sqlite::connection &con, std::string const &name, std::string const &definition,
+                   bool incremental, std::vector<std::string> const &triggers) {
+    sqlite::execute insert(
+        con, std::format("INSERT INTO {}(name, definition, incremental, triggers, refreshed_at) "
+                         "VALUES(?, ?, ?, ?, CAST(strftime('%s', 'now') AS INTEGER));",
+                         registry_table));
+    insert % name % definition % (incremental ? 1 : 0) % join(triggers, "\n");
+    insert();
+}
+
+// Reads one registry column of view @p name, resetting the statement before it goes back to
+// the statement cache.
+template <typename T>
+std::optional<T> registry_value(sqlite::connection &con, std::string const &name,
+                                std::string_view column) {
+    sqlite::query q(con, std::format("SELECT {} FROM {} WHERE name = ?;", column, registry_table));
+    q % name;
+    auto res = q.get_result();
+    std::optional<T> value;
+    if (res->next_row()) {
+        value = res->template get<T>(0);
+    }
+    q.clear();
+    return value;
+}
+
+std::string missing_view(std::string const &name) {
+    return "No materialized view named '" + name + "' is registered.";
+}
+
+struct aggregate_sql {
+    std::string columns;  // table column list
+    std::string populate; // SELECT producing the table rows
+    std::vector<std::pair<std::string, std::string>> triggers; // name, CREATE TRIGGER statement
+};
+
+// `P.col` for every group key, compared with IS so NULL groups match.
+std::string group_match(std::vector<std::string> const &group_by, std::string_view row) {
+    std::vector<std::string> terms;
+    for (auto const &g : group_by) {
+        auto column = quote_identifier(g);
+        terms.push_back(std::format("{} IS {}.{}", column, row, column));
+    }
+    return join(terms, " AND ");
+}
+
+// SET list applying one source row (`row` is NEW or OLD) with sign @p op.
+std::string apply_row(std::vector<sqlite::view_aggregate> const &aggregates, std::string_view row,
+                      char op) {
+    std::vector<std::string> sets;
+    for (auto const &a : aggregates) {
+        auto target = quote_identifier(a.alias);
+        std::string delta;
+        if (a.kind == sqlite::aggregate_kind::sum) {
+            delta = std::format("COALESCE({}.{}, 0)", row, quote_identifier(a.column));
+        } else if (a.column.empty()) {
+            delta = "1";
+        } else {
+            delta = std::format("({}.{} IS NOT NULL)", row, quote_identifier(a.column));
+        }
+        sets.push_back(std::format("{} = {} {} {}", target, target, op, delta));
+    }
+    sets.push_back(std::format("\"__rows\" = \"__rows\" {} 1", op));
+    return join(sets, ", ");
+}
+
+aggregate_sql build_aggregate(std::string const &name,
+                              sqlite::aggregate_view_definition const &def) {
+    if (def.source.empty() || def.aggregates.empty()) {
+        throw sqlite::database_exception(
+            "Aggregate views need a source table and at least one aggregate.");
+    }
+    auto table  = quote_identifier(name);
+    auto source = quote_identifier(def.source);
+
+    std::vector<std::string> columns;
+    std::vector<std::string> selected;
+    std::vector<std::string> groups;
+    std::vector<std::string> watched;
+    for (auto const &g : def.group_by) {
+        columns.push_back(quote_identifier(g));
+        groups.push_back(quote_identifier(g));
+        watched.push_back(quote_identifier(g));
+    }
+    selected = groups;
+    for (auto const &a : def.aggregates) {
+        if (a.alias.empty() || (a.kind == sqlite::aggregate_kind::sum && a.column.empty())) {
+            throw sqlite::database_exception(
+                "Aggregates need an alias, and SUM needs a source column.");
+        }
+        columns.push_back(quote_identifier(a.alias));
+        if (a.kind == sqlite::aggregate_kind::sum) {
+            selected.push_back(std::format("COALESCE(SUM({}), 0)", quote_identifier(a.column)));
+        } else {
+            selected.push_back(a.column.empty()
+                                   ? std::string("COUNT(*)")
+                                   : std::format("COUNT({})", quote_identifier(a.column)));
+        }
+        auto column = quote_identifier(a.column);
+        if (!a.column.empty() &&
+            std::find(watched.begin(), watched.end(), column) == watched.end()) {
+            watched.push_back(column);
+        }
+    }
+    columns.push_back("\"__rows\"");
+    selected.push_back("COUNT(*)");
+
+    aggregate_sql out;
+    out.columns  = join(columns, ", ");
+    out.populate = std::format("SELECT {} FROM {}", join(selected, ", "), source);
+    if (!groups.empty()) {
+        out.populate += " GROUP BY " + join(groups, ", ");
+    }
+
+    auto where = [&](std::string_view row) {
+        return groups.empty() ? std::string() : " WHERE " + group_match(def.group_by, row);
+    };
+    auto add = [&](std::string_view row) {
+        std::vector<std::string> seed;
+        for (auto const &g : def.group_by) {
+            seed.push_back(std::format("{}.{}", row, quote_identifier(g)));
+        }
+        for (std::size_t i = 0; i < def.aggregates.size(); ++i) {
+            seed.push_back("0");
+        }
+        seed.push_back("0");
+        auto match = where(row);
+        return std::format("INSERT INTO {}({}) SELECT {} WHERE NOT EXISTS (SELECT 1 FROM {}{}); "
+                           "UPDATE {} SET {}{};",
+                           table, out.columns, join(seed, ", "), table, match, table,
+                           apply_row(def.aggregates, row, '+'), match);
+    };
+    auto remove = [&](std::string_view row) {
+        auto sql = std::format("UPDATE {} SET {}{};", table, apply_row(def.aggregates, row, '-'),
+                               where(row));
+        if (!groups.empty()) {
+            sql += std::format(" DELETE FROM {} WHERE \"__rows\" = 0 AND {};", table,
+                               group_match(def.group_by, row));
+        }
+        return sql;
+    };
+
+    auto trigger = [&](std::string_view event, std::string body) {
+        auto trigger_name = std::format("{}__mv_{}", name, event);
+        auto sql = std::format("CREATE TRIGGER {} AFTER {} ON {} BEGIN {} END;",
+                               quote_identifier(trigger_name), event, source, body);
+        out.triggers.emplace_back(std::move(trigger_name), std::move(sql));
+    };
+    trigger("INSERT", add("NEW"));
+    trigger("DELETE", remove("OLD"));
+    if (!watched.empty()) {
+        // Only updates of grouped or aggregated columns can move a row between results.
+        out.triggers.emplace_back(
+            std::format("{}__mv_UPDATE", name),
+            std::format("CREATE TRIGGER {} AFTER UPDATE OF {} ON {} BEGIN {} {} END;",
+                        quote_identifier(std::format("{}__mv_UPDATE", name)), join(watched, ", "),
+                        source, remove("OLD"), add("NEW")));
+    }
+    return out;
+}
+
+// Tables read by @p sql, taken from its EXPLAIN listing so the application's authorizer stays.
+std::vector<std::string> source_tables(sqlite::connection &con, std::string const &sql) {
+    auto *db = to_handle(con);
+    {
+        sqlite::detail::raw_statement stmt(db, sql);
+        if (!stmt.get() || !sqlite3_stmt_readonly(stmt.get())) {
+            throw sqlite::database_exception(
+                "Materialized views need a read-only SELECT statement.");
+        }
+    }
+    bool opens_virtual = false;
+    auto reads         = sqlite::detail::statement_tables(db, sql, &opens_virtual);
+    if (opens_virtual) {
+        throw sqlite::database_exception("Materialized view sources cannot be virtual tables.");
+    }
+    std::vector<std::string> tables;
+    for (auto const &[schema, table] : reads) {
+        if (sqlite3_stricmp(schema.c_str(), "main") != 0) {
+            throw sqlite::database_exception(
+                "Materialized view sources must live in the main schema.");
+        }
+        if (table.rfind("sqlite_", 0) != 0 && table != registry_table) {
+            tables.push_back(table);
+        }
+    }
+    return tables;
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    materialized_view::materialized_view(connection &con, std::string name, bool incremental) :
+        con_(&con), name_(std::move(name)), incremental_(incremental) {}
+
+    materialized_view::materialized_view(connection &con, std::string_view name) :
+        con_(&con), name_(name) {
+        ensure_registry(con);
+        auto incremental = registry_value<int>(con, name_, "incremental");
+        if (!incremental) {
+            throw database_exception(missing_view(name_));
+        }
+        incremental_ = *incremental != 0;
+    }
+
+    materialized_view materialized_view::create(connection &con, std::string_view name,
+                                                aggregate_view_definition const &definition) {
+        std::string view_name(name);
+        if (view_name.empty()) {
+            throw database_exception("Materialized view name must not be empty.");
+        }
+        auto sql = build_aggregate(view_name, definition);
+        in_savepoint(con, [&] {
+            ensure_registry(con);
+            auto table = quote_identifier(view_name);
+            execute(con, std::format("CREATE TABLE {}({});", table, sql.columns), true);
+            if (!definition.group_by.empty()) {
+                std::vector<std::string> groups;
+                for (auto const &g : definition.group_by) {
+                    groups.push_back(quote_identifier(g));
+                }
+                execute(con,
+                        std::format("CREATE INDEX {} ON {}({});",
+                                    quote_identifier(view_name + "__mv_groups"),
+                                    table, join(groups, ", ")),
+                        true);
+            }
+            execute(con, std::format("INSERT INTO {} {};", table, sql.populate), true);
+            std::vector<std::string> triggers;
+            for (auto const &[trigger, statement] : sql.triggers) {
+                execute(con, statement, true);
+                triggers.push_back(trigger);
+            }
+            register_view(con, view_name, sql.populate, true, triggers);
+        });
+        return materialized_view(con, std::move(view_name), true);
+    }
+
+    materialized_view materialized_view::create(connection &con, std::string_view name,
+                                                std::string_view select_sql) {
+        std::string view_name(name);
+        if (view_name.empty()) {
+            throw database_exception("Materialized view name must not be empty.");
+        }
+        std::string select(select_sql);
+        while (!select.empty() &&
+               (select.back() == ';' || std::isspace(static_cast<unsigned char>(select.back())))) {
+            select.pop_back();
+        }
+        in_savepoint(con, [&] {
+            ensure_registry(con);
+            auto sources = source_tables(con, select);
+            execute(con, std::format("CREATE TABLE {} AS {};", quote_identifier(view_name), select),
+                    true);
+            std::vector<std::string> triggers;
+            auto bump = std::format("UPDATE {} SET pending = pending + 1 WHERE name = {};",
+                                    registry_table, quote_literal(view_name));
+            for (std::size_t i = 0; i < sources.size(); ++i) {
+                for (auto event : {"INSERT", "UPDATE", "DELETE"}) {
+                    auto trigger = std::format("{}__mv_{}_{}", view_name, i, event);
+                    execute(con,
+                            std::format("CREATE TRIGGER {} AFTER {} ON {} BEGIN {} END;",
+                                        quote_identifier(trigger), event,
+                                        quote_identifier(sources[i]), bump),
+                            true);
+                    triggers.push_back(std::move(trigger));
+                }
+            }
+            register_view(con, view_name, select, false, triggers);
+        });
+        return materialized_view(con, std::move(view_name), false);
+    }
+
+    void materialized_view::refresh() {
+        in_savepoint(*con_, [&] {
+            auto definition = registry_value<std::string>(*con_, name_, "definition");
+            if (!definition) {
+                throw database_exception(missing_view(name_));
+            }
+            auto table = quote_identifier(name_);
+            execute(*con_, std::format("DELETE FROM {};", table), true);
+            execute(*con_, std::format("INSERT INTO {} {};", table, *definition), true);
+            execute reset(*con_,
+                          std::format("UPDATE {} SET pending = 0, refreshed_at = CAST(strftime("
+                                      "'%s', 'now') AS INTEGER) WHERE name = ?;",
+                                      registry_table));
+            reset % name_;
+            reset();
+        });
+    }
+
+    view_staleness materialized_view::staleness() {
+        query q(*con_, std::format("SELECT pending, CAST(strftime('%s', 'now') AS INTEGER) - "
+                                   "refreshed_at FROM {} WHERE name = ?;",
+                                   registry_table));
+        q % name_;
+        auto res = q.get_result();
+        if (!res->next_row()) {
+            q.clear();
+            throw database_exception(missing_view(name_));
+        }
+        view_staleness out;
+        out.pending_changes = res->get<std::int64_t>(0);
+        out.since_refresh   = std::chrono::seconds(res->get<std::int64_t>(1));
+        out.stale           = out.pending_changes > 0;
+        q.clear();
+        return out;
+    }
+
+    void materialized_view::drop() {
+        in_savepoint(*con_, [&] {
+            auto triggers = registry_value<std::string>(*con_, name_, "triggers");
+            for (auto const &trigger : split_lines(triggers.value_or(std::string()))) {
+                execute(*con_, std::format("DROP TRIGGER IF EXISTS {};", quote_identifier(trigger)),
+                        true);
+            }
+            execute(*con_, std::format("DROP TABLE IF EXISTS {};", quote_identifier(name_)), true);
+            execute del(*con_, std::format("DELETE FROM {} WHERE name = ?;", registry_table));
+            del % name_;
+            del();
+        });
+    }
+} // namespace v2
+} // namespace sqlite
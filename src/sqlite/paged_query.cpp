@@ -0,0 +1,352 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/paged_query.hpp>
+#include <sqlite/private/private_accessor.hpp>
+
+#include <sqlite3.h>
+
+#include <cctype>
+#include <cstring>
+#include <format>
+
+namespace {
+std::string quote_identifier(std::string_view identifier) {
+    std::string quoted;
+    quoted.reserve(identifier.size() + 2);
+    quoted.push_back('"');
+    for (char c : identifier) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+std::string key_parameter(std::size_t index) {
+    return std::format(":vsqlite_key{}", index);
+}
+
+constexpr char const *token_version = "k1";
+constexpr char const *hex_digits    = "0123456789abcdef";
+
+void append_raw(std::string &out, void const *data, std::size_t size) {
+    out.append(static_cast<char const *>(data), size);
+}
+
+std::string to_hex(std::string const &bytes) {
+    std::string out;
+    out.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes) {
+        out.push_back(hex_digits[c >> 4]);
+        out.push_back(hex_digits[c & 0x0f]);
+    }
+    return out;
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+[[noreturn]] void throw_bad_token() {
+    throw sqlite::database_exception("Invalid or foreign paged_query continuation token.");
+}
+
+std::string from_hex(std::string_view text) {
+    if (text.size() % 2 != 0) {
+        throw_bad_token();
+    }
+    std::string out;
+    out.reserve(text.size() / 2);
+    for (std::size_t i = 0; i < text.size(); i += 2) {
+        int hi = hex_value(text[i]);
+        int lo = hex_value(text[i + 1]);
+        if (hi < 0 || lo < 0) {
+            throw_bad_token();
+        }
+        out.push_back(static_cast<char>((hi << 4) | lo));
+    }
+    return out;
+}
+
+// Sequential reader over a decoded token; any overrun means the token is malformed.
+struct token_reader {
+    std::string_view data;
+
+    void read(void *out, std::size_t size) {
+        if (data.size() < size) {
+            throw_bad_token();
+        }
+        std::memcpy(out, data.data(), size);
+        data.remove_prefix(size);
+    }
+};
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    paged_query::paged_query(connection &con, std::string_view base_sql,
+                             std::vector<std::string> keys, paged_query_options options) :
+        con_(con), keys_(std::move(keys)), options_(options) {
+        if (keys_.empty()) {
+            throw database_exception("paged_query needs at least one key column.");
+        }
+        if (options_.page_size == 0) {
+            throw database_exception("paged_query page size must be positive.");
+        }
+        std::string base(base_sql);
+        while (!base.empty() && (base.back() == ';' || std::isspace(static_cast<unsigned char>(
+                                                           base.back())))) {
+            base.pop_back();
+        }
+
+        std::string columns;
+        std::string order;
+        std::string params;
+        char const *direction = options_.descending ? " DESC" : "";
+        for (std::size_t i = 0; i < keys_.size(); ++i) {
+            auto key = quote_identifier(keys_[i]);
+            columns += (i ? ", " : "") + key;
+            order += (i ? ", " : "") + key + direction;
+            params += (i ? ", " : "") + key_parameter(i);
+        }
+        auto select = std::format("SELECT *, {} FROM ({})", columns, base);
+        auto tail   = std::format(" ORDER BY {} LIMIT :vsqlite_limit", order);
+        first_sql_  = select + tail;
+        // A single key compares directly; several use a row value so the seek stays one range.
+        auto lhs  = keys_.size() == 1 ? columns : "(" + columns + ")";
+        auto rhs  = keys_.size() == 1 ? params : "(" + params + ")";
+        seek_sql_ = std::format("{} WHERE {} {} {}{}", select, lhs, options_.descending ? "<" : ">",
+                                rhs, tail);
+        first_ = std::make_unique<query>(con_, first_sql_);
+        seek_  = std::make_unique<query>(con_, seek_sql_);
+    }
+
+    paged_query::~paged_query() {
+        finish_page();
+    }
+
+    paged_query::page paged_query::next() {
+        finish_page();
+        query &q = last_key_.empty() ? *first_ : *seek_;
+        q.clear();
+        if (binder_) {
+            binder_(q);
+        }
+        if (!last_key_.empty()) {
+            bind_key(q);
+        }
+        q.bind(":vsqlite_limit", static_cast<std::int64_t>(options_.page_size));
+        current_      = &q;
+        stmt_         = private_accessor::get_statement(q);
+        data_columns_ = sqlite3_column_count(stmt_) - static_cast<int>(keys_.size());
+        rows_         = 0;
+        return page(this);
+    }
+
+    bool paged_query::advance() {
+        if (!current_) {
+            return false;
+        }
+        if (!detail::stmt_step(stmt_)) {
+            if (rows_ < options_.page_size) {
+                exhausted_ = true;
+            }
+            finish_page();
+            return false;
+        }
+        ++rows_;
+        last_key_.resize(keys_.size());
+        for (std::size_t i = 0; i < keys_.size(); ++i) {
+            int column = data_columns_ + static_cast<int>(i);
+            auto &key  = last_key_[i];
+            key.type   = sqlite3_column_type(stmt_, column);
+            switch (key.type) {
+            case SQLITE_INTEGER:
+                key.integer = sqlite3_column_int64(stmt_, column);
+                break;
+            case SQLITE_FLOAT:
+                key.real = sqlite3_column_double(stmt_, column);
+                break;
+            case SQLITE_TEXT:
+            case SQLITE_BLOB: {
+                auto const *data = sqlite3_column_blob(stmt_, column);
+                int size         = sqlite3_column_bytes(stmt_, column);
+                key.bytes.assign(static_cast<char const *>(data), static_cast<std::size_t>(size));
+                break;
+            }
+            default:
+                throw database_exception("paged_query key column '" + keys_[i] + "' is NULL.");
+            }
+        }
+        return true;
+    }
+
+    paged_query::row paged_query::current_row() const {
+        return row(stmt_, data_columns_);
+    }
+
+    void paged_query::finish_page() {
+        if (current_) {
+            // Cached statements are not reset when returned, so never leave one mid-step.
+            current_->clear();
+            current_ = nullptr;
+            stmt_    = nullptr;
+        }
+    }
+
+    void paged_query::bind_key(query &q) {
+        for (std::size_t i = 0; i < last_key_.size(); ++i) {
+            auto const &key = last_key_[i];
+            int index       = q.parameter_index(key_parameter(i));
+            switch (key.type) {
+            case SQLITE_INTEGER:
+                q.bind(index, key.integer);
+                break;
+            case SQLITE_FLOAT:
+                q.bind(index, key.real);
+                break;
+            case SQLITE_TEXT:
+                q.bind(index, std::string_view(key.bytes));
+                break;
+            default:
+                q.bind(index, std::span<const unsigned char>(
+                                  reinterpret_cast<unsigned char const *>(key.bytes.data()),
+                                  key.bytes.size()));
+                break;
+            }
+        }
+    }
+
+    std::uint64_t paged_query::fingerprint() const {
+        // FNV-1a over the generated SQL, which captures the base query, keys and direction.
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : seek_sql_) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string paged_query::token() const {
+        if (last_key_.empty()) {
+            return std::string();
+        }
+        std::string raw;
+        auto hash = fingerprint();
+        append_raw(raw, &hash, sizeof(hash));
+        for (auto const &key : last_key_) {
+            raw.push_back(static_cast<char>(key.type));
+            switch (key.type) {
+            case SQLITE_INTEGER:
+                append_raw(raw, &key.integer, sizeof(key.integer));
+                break;
+            case SQLITE_FLOAT:
+                append_raw(raw, &key.real, sizeof(key.real));
+                break;
+            default: {
+                auto size = static_cast<std::uint64_t>(key.bytes.size());
+                append_raw(raw, &size, sizeof(size));
+                raw += key.bytes;
+                break;
+            }
+            }
+        }
+        return token_version + to_hex(raw);
+    }
+
+    void paged_query::resume(std::string_view token) {
+        finish_page();
+        if (token.empty()) {
+            rewind();
+            return;
+        }
+        if (token.substr(0, 2) != token_version) {
+            throw_bad_token();
+        }
+        auto raw = from_hex(token.substr(2));
+        token_reader reader{raw};
+        std::uint64_t hash = 0;
+        reader.read(&hash, sizeof(hash));
+        if (hash != fingerprint()) {
+            throw_bad_token();
+        }
+        std::vector<key_value> keys(keys_.size());
+        for (auto &key : keys) {
+            char type = 0;
+            reader.read(&type, 1);
+            key.type = type;
+            switch (key.type) {
+            case SQLITE_INTEGER:
+                reader.read(&key.integer, sizeof(key.integer));
+                break;
+            case SQLITE_FLOAT:
+                reader.read(&key.real, sizeof(key.real));
+                break;
+            case SQLITE_TEXT:
+            case SQLITE_BLOB: {
+                std::uint64_t size = 0;
+                reader.read(&size, sizeof(size));
+                if (size > reader.data.size()) {
+                    throw_bad_token();
+                }
+                key.bytes.assign(reader.data.data(), static_cast<std::size_t>(size));
+                reader.data.remove_prefix(static_cast<std::size_t>(size));
+                break;
+            }
+            default:
+                throw_bad_token();
+            }
+        }
+        if (!reader.data.empty()) {
+            throw_bad_token();
+        }
+        last_key_  = std::move(keys);
+        exhausted_ = false;
+    }
+
+    void paged_query::rewind() {
+        finish_page();
+        last_key_.clear();
+        exhausted_ = false;
+    }
+} // namespace v2
+} // namespace sqlite
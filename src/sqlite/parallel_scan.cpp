@@ -0,0 +1,195 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/parallel_scan.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/snapshot.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <string>
+
+namespace {
+std::string quote_identifier(std::string_view identifier) {
+    std::string quoted;
+    quoted.reserve(identifier.size() + 2);
+    quoted.push_back('"');
+    for (char c : identifier) {
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    return quoted;
+}
+
+// Reads the first column of the first row and resets the statement so no read stays active.
+template <typename... Args>
+std::optional<std::int64_t> first_int(sqlite::query &q, Args &&...args) {
+    std::optional<std::int64_t> out;
+    for (auto value : q.rows<std::optional<std::int64_t>>(std::forward<Args>(args)...)) {
+        out = value;
+        break;
+    }
+    q.clear();
+    return out;
+}
+
+std::int64_t estimate_rows(sqlite::connection &con, std::string_view table,
+                           std::string const &quoted_table) {
+    sqlite::query has_stat(
+        con, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'sqlite_stat1';");
+    if (first_int(has_stat)) {
+        // The first field of sqlite_stat1.stat is the approximate row count of the table.
+        sqlite::query stat(
+            con, "SELECT CAST(stat AS INTEGER) FROM sqlite_stat1 WHERE tbl = ? LIMIT 1;");
+        if (auto rows = first_int(stat, std::string(table)); rows && *rows > 0) {
+            return *rows;
+        }
+    }
+    sqlite::query count(con, "SELECT COUNT(*) FROM " + quoted_table + ";");
+    return first_int(count).value_or(0);
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    std::vector<scan_partition> plan_partitions(connection &con, std::string_view table,
+                                                std::string_view key_column,
+                                                std::size_t partitions,
+                                                partition_strategy strategy) {
+        auto quoted_table = quote_identifier(table);
+        auto quoted_key   = quote_identifier(key_column);
+        partitions        = std::max<std::size_t>(partitions, 1);
+
+        query bounds(con, "SELECT MIN(" + quoted_key + "), MAX(" + quoted_key + ") FROM " +
+                              quoted_table + ";");
+        std::optional<std::int64_t> low;
+        std::optional<std::int64_t> high;
+        for (auto [lo, hi] :
+             bounds.rows<std::optional<std::int64_t>, std::optional<std::int64_t>>()) {
+            low  = lo;
+            high = hi;
+        }
+        if (!low || !high) {
+            return {};
+        }
+
+        std::vector<std::int64_t> starts{*low};
+        if (strategy == partition_strategy::quantiles) {
+            std::int64_t rows = estimate_rows(con, table, quoted_table);
+            query probe(con, "SELECT " + quoted_key + " FROM " + quoted_table + " ORDER BY " +
+                                 quoted_key + " LIMIT 1 OFFSET ?;");
+            for (std::size_t i = 1; i < partitions && rows > 0; ++i) {
+                auto offset = static_cast<std::int64_t>(static_cast<long double>(rows) *
+                                                        static_cast<long double>(i) /
+                                                        static_cast<long double>(partitions));
+                auto boundary = first_int(probe, offset);
+                if (!boundary) {
+                    break; // stale sqlite_stat1 overestimated the row count
+                }
+                if (*boundary > starts.back()) {
+                    starts.push_back(*boundary);
+                }
+            }
+        } else {
+            // Unsigned arithmetic keeps the width well-defined for the full int64 range.
+            auto width = static_cast<std::uint64_t>(*high) - static_cast<std::uint64_t>(*low);
+            auto count = static_cast<std::uint64_t>(partitions);
+            if (width < count) {
+                count = width + 1;
+            }
+            // Start i at low + (width + 1) * i / count, split so nothing overflows: with
+            // width = q * count + r that is q * i + (r + 1) * i / count. The starts are strictly
+            // increasing and never pass high, since count <= width + 1.
+            auto q = width / count;
+            auto r = width % count;
+            for (std::uint64_t i = 1; i < count; ++i) {
+                auto offset = q * i + (r + 1) * i / count;
+                starts.push_back(
+                    static_cast<std::int64_t>(static_cast<std::uint64_t>(*low) + offset));
+            }
+        }
+
+        std::vector<scan_partition> out;
+        out.reserve(starts.size());
+        for (std::size_t i = 0; i < starts.size(); ++i) {
+            std::int64_t upper = i + 1 < starts.size() ? starts[i + 1] - 1 : *high;
+            out.push_back({i, starts[i], upper});
+        }
+        return out;
+    }
+
+    namespace detail {
+        std::string partition_sql(std::string_view table, std::string_view key_column,
+                                  scan_options const &options) {
+            std::string sql = "SELECT " + (options.columns.empty() ? std::string("*")
+                                                                   : options.columns) +
+                              " FROM " + quote_identifier(table) + " WHERE " +
+                              quote_identifier(key_column) + " BETWEEN ?1 AND ?2";
+            if (!options.where.empty()) {
+                sql += " AND (" + options.where + ")";
+            }
+            return sql + ";";
+        }
+
+        snapshot try_pin_snapshot(connection &con, bool required) {
+            if (!snapshots_supported()) {
+                if (required) {
+                    throw database_exception(
+                        "parallel_scan: snapshots are not supported by this SQLite build");
+                }
+                return {};
+            }
+            auto mode = get_wal_mode(con);
+            if (mode != wal_mode::wal && mode != wal_mode::wal2) {
+                if (required) {
+                    throw database_exception(
+                        "parallel_scan: a common snapshot requires WAL journal mode");
+                }
+                return {};
+            }
+            try {
+                return snapshot::take(con);
+            } catch (database_exception const &) {
+                if (required) {
+                    throw;
+                }
+                return {};
+            }
+        }
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
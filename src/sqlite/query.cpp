@@ -32,6 +32,7 @@
 #include <memory>
 #include <utility>
 #include <stdexcept>
+#include <sqlite/private/private_accessor.hpp>
 #include <sqlite/private/result_construct_params_private.hpp>
 #include <sqlite/query.hpp>
 #include <sqlite3.h>
@@ -40,6 +41,11 @@ namespace sqlite {
 inline namespace v2 {
     query::query(connection &con, std::string const &sql) : command(con, sql) {}
 
+    sqlite3_stmt *private_accessor::get_statement(query &q) {
+        q.access_check();
+        return q.stmt;
+    }
+
     query::~query() {}
 
     std::shared_ptr<result> query::emit_result() {
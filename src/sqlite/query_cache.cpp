@@ -0,0 +1,289 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query_cache.hpp>
+
+#include <sqlite3.h>
+
+#include "change_hooks.hpp"
+#include "statement_tables.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+namespace {
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+// Tables are tracked as lower-case "schema.table", matching SQLite's case-insensitive names.
+std::string table_key(std::string_view schema, std::string_view table) {
+    std::string key;
+    key.reserve(schema.size() + table.size() + 1);
+    for (char c : schema) {
+        key.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+    key.push_back('.');
+    for (char c : table) {
+        key.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+    return key;
+}
+
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    query_cache::query_cache(connection &con, query_cache_options options) :
+        con_(con), options_(options), db_(to_handle(con)) {
+        int rc = sqlite3_prepare_v2(db_, "PRAGMA data_version;", -1, &data_version_, nullptr);
+        if (rc != SQLITE_OK) {
+            throw database_exception_code(sqlite3_errmsg(db_), rc);
+        }
+        data_version_changed();
+        try {
+            detail::hooks_of(con).add({this, &query_cache::on_update, &query_cache::on_commit,
+                                       &query_cache::on_rollback, &query_cache::on_missed});
+        } catch (...) {
+            sqlite3_finalize(data_version_);
+            throw;
+        }
+    }
+
+    query_cache::~query_cache() {
+        detail::hooks_of(con_).remove(this);
+        sqlite3_finalize(data_version_);
+    }
+
+    void query_cache::on_update(void *self, int, char const *schema, char const *table,
+                                long long) {
+        auto *cache = static_cast<query_cache *>(self);
+        std::lock_guard<std::mutex> lock(cache->mutex_);
+        cache->pending_.insert(table_key(schema, table));
+    }
+
+    int query_cache::on_commit(void *self) {
+        auto *cache = static_cast<query_cache *>(self);
+        std::lock_guard<std::mutex> lock(cache->mutex_);
+        for (auto const &table : cache->pending_) {
+            cache->invalidate_locked(table);
+        }
+        cache->pending_.clear();
+        return 0;
+    }
+
+    void query_cache::on_rollback(void *self) {
+        auto *cache = static_cast<query_cache *>(self);
+        std::lock_guard<std::mutex> lock(cache->mutex_);
+        cache->pending_.clear();
+    }
+
+    void query_cache::on_missed(void *self) {
+        // The update hook misses truncations and WITHOUT ROWID tables, so drop everything.
+        auto *cache = static_cast<query_cache *>(self);
+        std::lock_guard<std::mutex> lock(cache->mutex_);
+        cache->stats_.invalidations += cache->lru_.size();
+        cache->clear_locked();
+    }
+
+    std::shared_ptr<std::vector<std::string> const>
+    query_cache::dependencies(std::string_view sql) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = dependencies_.find(std::string(sql));
+            if (it != dependencies_.end()) {
+                return it->second;
+            }
+        }
+        {
+            detail::raw_statement stmt(db_, sql);
+            if (!stmt.get() || !sqlite3_stmt_readonly(stmt.get())) {
+                throw database_exception("query_cache only caches read-only statements.");
+            }
+        }
+        bool opens_virtual = false;
+        auto found         = detail::statement_tables(db_, sql, &opens_virtual);
+        // Writes to virtual tables never reach the update hook; such reads are not cached.
+        std::shared_ptr<std::vector<std::string>> tables;
+        if (!opens_virtual) {
+            tables = std::make_shared<std::vector<std::string>>();
+            for (auto const &[schema, table] : found) {
+                tables->push_back(table_key(schema, table));
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [it, inserted] = dependencies_.emplace(std::string(sql), std::move(tables));
+        return it->second;
+    }
+
+    bool query_cache::data_version_changed() {
+        std::int64_t version = last_data_version_;
+        if (sqlite3_step(data_version_) == SQLITE_ROW) {
+            version = sqlite3_column_int64(data_version_, 0);
+        }
+        sqlite3_reset(data_version_);
+        bool changed       = version != last_data_version_;
+        last_data_version_ = version;
+        return changed;
+    }
+
+    std::shared_ptr<rowset const>
+    query_cache::fetch_impl(std::string_view sql, std::string key,
+                            std::function<void(query &)> const &bind) {
+        detail::hooks_of(con_).settle();
+        auto tables              = dependencies(sql);
+        bool in_txn              = sqlite3_get_autocommit(db_) == 0;
+        bool foreign             = options_.check_data_version && data_version_changed();
+        bool bypass              = false;
+        std::uint64_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!in_txn) {
+                pending_.clear();
+            }
+            if (foreign) {
+                stats_.invalidations += lru_.size();
+                clear_locked();
+            }
+            generation = generation_;
+            bypass     = !tables || std::any_of(tables->begin(), tables->end(), [this](auto &t) {
+                         return pending_.count(t) != 0;
+                     });
+            if (bypass) {
+                ++stats_.bypassed;
+            } else if (auto it = entries_.find(key); it != entries_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                ++stats_.hits;
+                return it->second->rows;
+            } else {
+                ++stats_.misses;
+            }
+        }
+
+        query q(con_, std::string(sql));
+        bind(q);
+        auto rows = std::make_shared<rowset const>(q);
+        if (bypass) {
+            return rows;
+        }
+
+        std::size_t bytes = rows->memory_usage() + key.size();
+        if (bytes > options_.memory_budget || options_.max_entries == 0) {
+            return rows;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation != generation_) {
+            return rows; // a commit or invalidation ran meanwhile; the rows may predate it
+        }
+        if (auto it = entries_.find(key); it != entries_.end()) {
+            erase_locked(it->second);
+        }
+        lru_.push_front(entry{key, rows, tables, bytes});
+        entries_.emplace(key, lru_.begin());
+        for (auto const &table : *tables) {
+            readers_by_table_[table].insert(key);
+        }
+        memory_usage_ += bytes;
+        while (memory_usage_ > options_.memory_budget || lru_.size() > options_.max_entries) {
+            erase_locked(std::prev(lru_.end()));
+            ++stats_.evictions;
+        }
+        return rows;
+    }
+
+    void query_cache::erase_locked(iterator it) {
+        for (auto const &table : *it->tables) {
+            auto readers = readers_by_table_.find(table);
+            if (readers != readers_by_table_.end()) {
+                readers->second.erase(it->key);
+                if (readers->second.empty()) {
+                    readers_by_table_.erase(readers);
+                }
+            }
+        }
+        memory_usage_ -= it->bytes;
+        entries_.erase(it->key);
+        lru_.erase(it);
+    }
+
+    void query_cache::invalidate_locked(std::string const &table) {
+        ++generation_;
+        auto readers = readers_by_table_.find(table);
+        if (readers == readers_by_table_.end()) {
+            return;
+        }
+        // erase_locked() edits the set being walked, so work from a copy.
+        auto keys = std::move(readers->second);
+        readers_by_table_.erase(readers);
+        for (auto const &key : keys) {
+            if (auto it = entries_.find(key); it != entries_.end()) {
+                erase_locked(it->second);
+                ++stats_.invalidations;
+            }
+        }
+    }
+
+    void query_cache::clear_locked() {
+        ++generation_;
+        lru_.clear();
+        entries_.clear();
+        readers_by_table_.clear();
+        memory_usage_ = 0;
+    }
+
+    void query_cache::invalidate(std::string_view table) {
+        auto dot = table.find('.');
+        auto key = dot == std::string_view::npos
+                       ? table_key("main", table)
+                       : table_key(table.substr(0, dot), table.substr(dot + 1));
+        std::lock_guard<std::mutex> lock(mutex_);
+        invalidate_locked(key);
+    }
+
+    void query_cache::clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clear_locked();
+    }
+
+    query_cache_stats query_cache::stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto out         = stats_;
+        out.entries      = lru_.size();
+        out.memory_usage = memory_usage_;
+        return out;
+    }
+} // namespace v2
+} // namespace sqlite
@@ -67,6 +67,19 @@ inline namespace v2 {
         return false;
     }
 
+    sqlite3_stmt *result::checked_statement() {
+        m_params->access_check();
+        return m_params->statement;
+    }
+
+    bool result::step_unchecked() {
+        if (m_params->ended) {
+            return false;
+        }
+        m_params->ended = !detail::stmt_step(m_params->statement);
+        return !m_params->ended;
+    }
+
     std::string result::get_column_decltype(int idx) {
         access_check(idx);
         return sqlite3_column_decltype(m_params->statement, idx);
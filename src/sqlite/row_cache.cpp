@@ -0,0 +1,140 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/row_cache.hpp>
+
+#include <sqlite3.h>
+
+#include "change_hooks.hpp"
+
+namespace {
+bool same_table(std::string_view a, std::string_view b) {
+    return sqlite3_strnicmp(a.data(), b.data(), static_cast<int>(a.size())) == 0 &&
+           a.size() == b.size();
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    namespace detail {
+        row_cache_base::row_cache_base(connection &con, std::string_view table,
+                                       std::string const &fill_sql) :
+            table_(table), fill_(con, fill_sql) {
+            query unique(con, "SELECT COUNT(*) FROM pragma_index_list(?1) WHERE \"unique\";");
+            unique % table_;
+            auto res = unique.get_result();
+            inserts_may_replace_ = res->next_row() && res->get<int>(0) > 0;
+            unique.clear();
+        }
+
+        void row_cache_base::attach(connection &con) {
+            auto &hooks = hooks_of(con);
+            hooks.add({this, &row_cache_base::on_update, &row_cache_base::on_commit,
+                       &row_cache_base::on_rollback, &row_cache_base::on_missed});
+            hooks_ = &hooks;
+        }
+
+        row_cache_base::~row_cache_base() {
+            detach();
+        }
+
+        void row_cache_base::detach() noexcept {
+            if (hooks_) {
+                hooks_->remove(this);
+                hooks_ = nullptr;
+            }
+        }
+
+        void row_cache_base::settle() noexcept {
+            hooks_->settle();
+        }
+
+        query &row_cache_base::fill_query() {
+            fill_.clear();
+            return fill_;
+        }
+
+        sqlite3_stmt *row_cache_base::fill_statement() {
+            return private_accessor::get_statement(fill_);
+        }
+
+        bool row_cache_base::storable(std::int64_t rowid, std::uint64_t epoch) const {
+            if (epoch_.load() != epoch) {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            return pending_.count(rowid) == 0;
+        }
+
+        void row_cache_base::on_update(void *self, int op, char const *, char const *table,
+                                       long long rowid) {
+            auto *cache = static_cast<row_cache_base *>(self);
+            if (!table || !same_table(table, cache->table_)) {
+                return;
+            }
+            // Bump the epoch before erasing so a fill that read the old row cannot store it.
+            ++cache->epoch_;
+            if (op == SQLITE_INSERT && cache->inserts_may_replace_) {
+                // REPLACE deletes conflicting rows without telling the update hook.
+                cache->erase_all();
+            }
+            {
+                std::lock_guard<std::mutex> lock(cache->pending_mutex_);
+                cache->pending_.insert(rowid);
+            }
+            cache->erase_rowid(rowid);
+        }
+
+        int row_cache_base::on_commit(void *self) {
+            auto *cache = static_cast<row_cache_base *>(self);
+            std::lock_guard<std::mutex> lock(cache->pending_mutex_);
+            cache->pending_.clear();
+            return 0;
+        }
+
+        void row_cache_base::on_rollback(void *self) {
+            auto *cache = static_cast<row_cache_base *>(self);
+            std::lock_guard<std::mutex> lock(cache->pending_mutex_);
+            cache->pending_.clear();
+        }
+
+        void row_cache_base::on_missed(void *self) {
+            // DELETE without WHERE skips the update hook, so any cached row may be gone.
+            auto *cache = static_cast<row_cache_base *>(self);
+            ++cache->epoch_;
+            cache->erase_all();
+        }
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,119 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/rowset.hpp>
+
+#include <sqlite3.h>
+
+#include <limits>
+#include <memory>
+
+namespace sqlite {
+inline namespace v2 {
+    variant_t value_view::to_variant() const {
+        switch (kind()) {
+        case integer: {
+            std::int64_t i = cell_->integer;
+            if (i > std::numeric_limits<int>::max() || i < std::numeric_limits<int>::min()) {
+                return i;
+            }
+            return int(i);
+        }
+        case real:
+            return static_cast<long double>(cell_->real);
+        case text:
+            return std::string(as_text());
+        case blob: {
+            auto bytes = as_blob();
+            return std::make_shared<blob_t>(bytes.begin(), bytes.end());
+        }
+        default:
+            return null_t();
+        }
+    }
+
+    rowset::rowset(query &q) {
+        sqlite3_stmt *stmt = private_accessor::get_statement(q);
+        int columns        = sqlite3_column_count(stmt);
+        columns_.reserve(static_cast<std::size_t>(columns));
+        for (int i = 0; i < columns; ++i) {
+            char const *name = sqlite3_column_name(stmt, i);
+            columns_.emplace_back(name ? name : "");
+        }
+        while (detail::stmt_step(stmt)) {
+            for (int i = 0; i < columns; ++i) {
+                detail::packed_value cell{};
+                switch (sqlite3_column_type(stmt, i)) {
+                case SQLITE_INTEGER:
+                    cell.kind    = integer;
+                    cell.integer = sqlite3_column_int64(stmt, i);
+                    break;
+                case SQLITE_FLOAT:
+                    cell.kind = real;
+                    cell.real = sqlite3_column_double(stmt, i);
+                    break;
+                case SQLITE_TEXT:
+                case SQLITE_BLOB: {
+                    bool is_text = sqlite3_column_type(stmt, i) == SQLITE_TEXT;
+                    auto data    = is_text ? static_cast<void const *>(sqlite3_column_text(stmt, i))
+                                           : sqlite3_column_blob(stmt, i);
+                    auto length  = static_cast<std::size_t>(sqlite3_column_bytes(stmt, i));
+                    cell.kind    = is_text ? text : blob;
+                    cell.offset  = arena_.size();
+                    cell.length  = static_cast<std::uint32_t>(length);
+                    auto bytes   = static_cast<char const *>(data);
+                    arena_.insert(arena_.end(), bytes, bytes + length);
+                    break;
+                }
+                default:
+                    break;
+                }
+                cells_.push_back(cell);
+            }
+        }
+        // Rowsets are typically cached; drop the growth slack once the size is final.
+        cells_.shrink_to_fit();
+        arena_.shrink_to_fit();
+    }
+
+    std::optional<std::size_t> rowset::column_index(std::string_view name) const noexcept {
+        for (std::size_t i = 0; i < columns_.size(); ++i) {
+            if (columns_[i] == name) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+} // namespace v2
+} // namespace sqlite
@@ -114,10 +114,12 @@ struct snapshot_api {
     using get_fn  = int (*)(sqlite3 *, const char *, sqlite3_snapshot **);
     using open_fn = int (*)(sqlite3 *, const char *, sqlite3_snapshot *);
     using free_fn = void (*)(sqlite3_snapshot *);
+    using cmp_fn  = int (*)(sqlite3_snapshot *, sqlite3_snapshot *);
 
     get_fn get   = nullptr;
     open_fn open = nullptr;
     free_fn free = nullptr;
+    cmp_fn cmp   = nullptr;
 };
 
 snapshot_api const &snapshot_symbols() {
@@ -129,6 +131,8 @@ snapshot_api const &snapshot_symbols() {
             sqlite::detail::load_sqlite_symbol<snapshot_api::open_fn>("sqlite3_snapshot_open");
         loaded.free =
             sqlite::detail::load_sqlite_symbol<snapshot_api::free_fn>("sqlite3_snapshot_free");
+        loaded.cmp =
+            sqlite::detail::load_sqlite_symbol<snapshot_api::cmp_fn>("sqlite3_snapshot_cmp");
         return loaded;
     }();
     return api;
@@ -201,6 +205,18 @@ inline namespace v2 {
         }
     }
 
+    int snapshot::compare(snapshot const &other) const {
+        ensure_snapshot_available();
+        if (!handle_ || !other.handle_) {
+            throw database_exception("Cannot compare an empty snapshot.");
+        }
+        auto cmp_fn = snapshot_symbols().cmp;
+        if (!cmp_fn) {
+            throw database_exception("sqlite3_snapshot_cmp is not available in this build.");
+        }
+        return cmp_fn(handle_, other.handle_);
+    }
+
     std::string_view to_string(wal_mode mode) {
         switch (mode) {
         case wal_mode::rollback:
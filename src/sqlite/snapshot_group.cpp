@@ -0,0 +1,125 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/connection.hpp>
+#include <sqlite/database_exception.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/snapshot_group.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <sqlite3.h>
+
+#include <stdexcept>
+
+namespace {
+sqlite3 *to_handle(sqlite::connection &con) {
+    sqlite::private_accessor::acccess_check(con);
+    return sqlite::private_accessor::get_handle(con);
+}
+
+// Any read of page 1 starts the read transaction that a snapshot is taken from.
+void start_read(sqlite::connection &con) {
+    sqlite::execute(con, "SELECT COUNT(*) FROM sqlite_master;", true);
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    snapshot_group::snapshot_group(connection_pool &pool, std::size_t readers,
+                                   std::string_view schema) :
+        schema_(schema.empty() ? std::string_view("main") : schema) {
+        if (readers == 0) {
+            throw database_exception("snapshot_group requires at least one reader");
+        }
+        if (readers > pool.capacity()) {
+            throw database_exception("snapshot_group cannot lease more readers than the pool holds");
+        }
+        leases_.reserve(readers);
+        transactions_.reserve(readers);
+        for (std::size_t i = 0; i < readers; ++i) {
+            leases_.push_back(pool.acquire());
+        }
+
+        connection &first = *leases_.front();
+        transactions_.push_back(std::make_unique<transaction>(first, transaction_type::deferred));
+        start_read(first);
+        snapshot_ = snapshot::take(first, schema_);
+        taken_    = std::chrono::steady_clock::now();
+
+        for (std::size_t i = 1; i < readers; ++i) {
+            connection &con = *leases_[i];
+            transactions_.push_back(std::make_unique<transaction>(con, transaction_type::deferred));
+            snapshot_.open(con, schema_);
+        }
+    }
+
+    snapshot_group::~snapshot_group() {
+        for (auto &tx : transactions_) {
+            try {
+                tx->commit();
+            } catch (...) {
+                // The transaction destructor rolls back instead.
+            }
+        }
+        transactions_.clear();
+    }
+
+    connection &snapshot_group::reader(std::size_t index) const {
+        if (index >= leases_.size()) {
+            throw std::out_of_range("snapshot_group reader index out of range");
+        }
+        return *leases_[index];
+    }
+
+    snapshot_lag snapshot_group::lag() {
+        snapshot_lag out;
+        out.age = std::chrono::steady_clock::now() - taken_;
+        if (!observer_) {
+            char const *file = sqlite3_db_filename(to_handle(*leases_.front()), schema_.c_str());
+            if (!file || !*file) {
+                throw database_exception("snapshot_group::lag requires a file-backed database");
+            }
+            observer_ = std::make_unique<connection>(file, open_mode::open_readonly);
+        }
+        snapshot head;
+        {
+            transaction tx(*observer_, transaction_type::deferred);
+            start_read(*observer_);
+            head = snapshot::take(*observer_, schema_);
+            tx.commit();
+        }
+        out.behind = snapshot_.compare(head) < 0;
+        return out;
+    }
+} // namespace v2
+} // namespace sqlite
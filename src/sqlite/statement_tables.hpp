@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sqlite/database_exception.hpp>
+
+#include <sqlite3.h>
+
+namespace sqlite {
+inline namespace v2 {
+    namespace detail {
+        /// Owns a statement prepared on the raw handle, outside the connection's statement cache.
+        class raw_statement {
+        public:
+            raw_statement(sqlite3 *db, std::string_view sql) {
+                int rc = sqlite3_prepare_v2(db, sql.data(), static_cast<int>(sql.size()), &stmt_,
+                                            nullptr);
+                if (rc != SQLITE_OK) {
+                    sqlite3_finalize(stmt_);
+                    throw database_exception_code(sqlite3_errmsg(db), rc, std::string(sql));
+                }
+            }
+            ~raw_statement() {
+                sqlite3_finalize(stmt_);
+            }
+            raw_statement(raw_statement const &)            = delete;
+            raw_statement &operator=(raw_statement const &) = delete;
+
+            sqlite3_stmt *get() const noexcept {
+                return stmt_;
+            }
+
+        private:
+            sqlite3_stmt *stmt_ = nullptr;
+        };
+
+        /**
+         * Tables, as (schema, name) pairs, whose b-trees the statement @p sql opens. They are read
+         * from its EXPLAIN listing rather than through an authorizer callback, so whatever
+         * authorizer the application installed stays in place and still vets the statement.
+         * Index cursors are reported under their table. Virtual tables cannot be named this way;
+         * @p opens_virtual, when given, is set if the statement opens one.
+         */
+        inline std::vector<std::pair<std::string, std::string>>
+        statement_tables(sqlite3 *db, std::string_view sql, bool *opens_virtual = nullptr) {
+            constexpr int p2_is_register = 0x02; // OPFLAG_P2ISREG: P2 names a register, not a page
+            std::vector<std::pair<int, std::int64_t>> roots; // (database index, root page)
+            {
+                raw_statement explain(db, "EXPLAIN " + std::string(sql));
+                while (sqlite3_step(explain.get()) == SQLITE_ROW) {
+                    auto opcode = sqlite3_column_text(explain.get(), 1);
+                    std::string_view op(opcode ? reinterpret_cast<char const *>(opcode) : "");
+                    if (op == "VOpen" && opens_virtual) {
+                        *opens_virtual = true;
+                    }
+                    if (op != "OpenRead" && op != "OpenWrite" && op != "ReopenIdx") {
+                        continue;
+                    }
+                    if (sqlite3_column_int(explain.get(), 6) & p2_is_register) {
+                        continue;
+                    }
+                    std::pair<int, std::int64_t> root(sqlite3_column_int(explain.get(), 4),
+                                                      sqlite3_column_int64(explain.get(), 3));
+                    if (std::find(roots.begin(), roots.end(), root) == roots.end()) {
+                        roots.push_back(root);
+                    }
+                }
+            }
+
+            std::vector<std::pair<int, std::string>> schemas;
+            {
+                raw_statement list(db, "PRAGMA database_list;");
+                while (sqlite3_step(list.get()) == SQLITE_ROW) {
+                    auto name = reinterpret_cast<char const *>(sqlite3_column_text(list.get(), 1));
+                    schemas.emplace_back(sqlite3_column_int(list.get(), 0), name ? name : "");
+                }
+            }
+
+            std::vector<std::pair<std::string, std::string>> tables;
+            for (auto const &[index, page] : roots) {
+                auto schema =
+                    std::find_if(schemas.begin(), schemas.end(),
+                                 [index](auto const &entry) { return entry.first == index; });
+                if (schema == schemas.end()) {
+                    continue;
+                }
+                std::string name = "sqlite_master";
+                if (page != 1) {
+                    std::string quoted = "\"";
+                    for (char c : schema->second) {
+                        quoted += c == '"' ? std::string("\"\"") : std::string(1, c);
+                    }
+                    raw_statement lookup(db, "SELECT tbl_name FROM " + quoted +
+                                                 "\".sqlite_master WHERE rootpage = ?1;");
+                    sqlite3_bind_int64(lookup.get(), 1, page);
+                    if (sqlite3_step(lookup.get()) != SQLITE_ROW) {
+                        continue;
+                    }
+                    name = reinterpret_cast<char const *>(sqlite3_column_text(lookup.get(), 0));
+                }
+                std::pair<std::string, std::string> entry(schema->second, std::move(name));
+                if (std::find(tables.begin(), tables.end(), entry) == tables.end()) {
+                    tables.push_back(std::move(entry));
+                }
+            }
+            return tables;
+        }
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
@@ -0,0 +1,62 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/stats.hpp>
+
+#include <sqlite3.h>
+
+namespace {
+sqlite::status_counter read_status(int op, bool reset) {
+    sqlite3_int64 current   = 0;
+    sqlite3_int64 highwater = 0;
+    if (sqlite3_status64(op, &current, &highwater, reset ? 1 : 0) != SQLITE_OK) {
+        return {};
+    }
+    return {static_cast<std::int64_t>(current), static_cast<std::int64_t>(highwater)};
+}
+} // namespace
+
+namespace sqlite {
+inline namespace v2 {
+    process_stats global_stats(bool reset_highwater) {
+        process_stats stats;
+        stats.memory_used        = read_status(SQLITE_STATUS_MEMORY_USED, reset_highwater);
+        stats.malloc_count       = read_status(SQLITE_STATUS_MALLOC_COUNT, reset_highwater);
+        stats.malloc_size        = read_status(SQLITE_STATUS_MALLOC_SIZE, reset_highwater);
+        stats.pagecache_used     = read_status(SQLITE_STATUS_PAGECACHE_USED, reset_highwater);
+        stats.pagecache_overflow = read_status(SQLITE_STATUS_PAGECACHE_OVERFLOW, reset_highwater);
+        stats.pagecache_size     = read_status(SQLITE_STATUS_PAGECACHE_SIZE, reset_highwater);
+        stats.parser_stack       = read_status(SQLITE_STATUS_PARSER_STACK, reset_highwater);
+        return stats;
+    }
+} // namespace v2
+} // namespace sqlite
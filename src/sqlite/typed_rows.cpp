@@ -0,0 +1,95 @@
+/*##############################################################################
+ VSQLite++ - virtuosic bytes SQLite3 C++ wrapper
+
+ Copyright (c) 2006-2024 Vinzenz Feenstra
+                         and contributors
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without modification,
+ are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of virtuosic bytes nor the names of its contributors may
+   be used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ POSSIBILITY OF SUCH DAMAGE.
+
+##############################################################################*/
+#include <sqlite/database_exception.hpp>
+#include <sqlite/typed_rows.hpp>
+
+#include <sqlite3.h>
+
+namespace sqlite {
+inline namespace v2 {
+    namespace detail {
+        bool stmt_step(sqlite3_stmt *stmt) {
+            int err = sqlite3_step(stmt);
+            switch (err) {
+            case SQLITE_ROW:
+                return true;
+            case SQLITE_DONE:
+                return false;
+            case SQLITE_MISUSE:
+                throw database_misuse_exception_code(sqlite3_errmsg(sqlite3_db_handle(stmt)), err,
+                                                     sqlite3_sql(stmt));
+            default:
+                throw database_exception_code(sqlite3_errmsg(sqlite3_db_handle(stmt)), err,
+                                              sqlite3_sql(stmt));
+            }
+        }
+
+        int stmt_column_count(sqlite3_stmt *stmt) {
+            return sqlite3_column_count(stmt);
+        }
+
+        bool stmt_column_is_null(sqlite3_stmt *stmt, int idx) {
+            return sqlite3_column_type(stmt, idx) == SQLITE_NULL;
+        }
+
+        std::int64_t stmt_column_int64(sqlite3_stmt *stmt, int idx) {
+            return sqlite3_column_int64(stmt, idx);
+        }
+
+        double stmt_column_double(sqlite3_stmt *stmt, int idx) {
+            return sqlite3_column_double(stmt, idx);
+        }
+
+        std::string_view stmt_column_text(sqlite3_stmt *stmt, int idx) {
+            auto text = reinterpret_cast<char const *>(sqlite3_column_text(stmt, idx));
+            if (!text) {
+                // Matches result::get_string_view for NULL columns.
+                return std::string_view("NULL", 4);
+            }
+            return std::string_view(text, static_cast<std::size_t>(sqlite3_column_bytes(stmt, idx)));
+        }
+
+        std::span<const unsigned char> stmt_column_blob(sqlite3_stmt *stmt, int idx) {
+            auto ptr = static_cast<unsigned char const *>(sqlite3_column_blob(stmt, idx));
+            if (!ptr) {
+                return {};
+            }
+            return {ptr, static_cast<std::size_t>(sqlite3_column_bytes(stmt, idx))};
+        }
+
+        void throw_column_count_mismatch() {
+            throw database_exception("Tuple columns exceed result column count.");
+        }
+    } // namespace detail
+} // namespace v2
+} // namespace sqlite
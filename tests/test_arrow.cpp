@@ -0,0 +1,105 @@
+#include "test_common.hpp"
+
+#include <sqlite/arrow.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+bool arrow_valid(ArrowArray const *array, std::int64_t row) {
+    auto bits = static_cast<std::uint8_t const *>(array->buffers[0]);
+    return bits == nullptr || ((bits[row / 8] >> (row % 8)) & 1) != 0;
+}
+
+std::string_view arrow_string(ArrowArray const *array, std::int64_t row) {
+    auto offsets = static_cast<std::int64_t const *>(array->buffers[1]);
+    auto data    = static_cast<char const *>(array->buffers[2]);
+    return {data + offsets[row], static_cast<std::size_t>(offsets[row + 1] - offsets[row])};
+}
+} // namespace
+
+TEST(ArrowExportTest, ExportsSchemaFromDeclaredTypes) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE t(id INTEGER, name VARCHAR(20), score DOUBLE, raw BLOB);",
+                    true);
+    sqlite::query q(conn, "SELECT id, name, score, raw FROM t;");
+    sqlite::arrow_exporter exporter(q);
+
+    ArrowSchema schema;
+    exporter.export_schema(&schema);
+    EXPECT_STREQ(schema.format, "+s");
+    ASSERT_EQ(schema.n_children, 4);
+    EXPECT_STREQ(schema.children[0]->format, "l");
+    EXPECT_STREQ(schema.children[0]->name, "id");
+    EXPECT_STREQ(schema.children[1]->format, "U");
+    EXPECT_STREQ(schema.children[2]->format, "g");
+    EXPECT_STREQ(schema.children[3]->format, "Z");
+    EXPECT_EQ(schema.children[1]->flags, ARROW_FLAG_NULLABLE);
+    schema.release(&schema);
+    EXPECT_EQ(schema.release, nullptr);
+
+    ArrowArray array;
+    EXPECT_FALSE(exporter.export_next(&array));
+}
+
+TEST(ArrowExportTest, ExportsBatchesWithValidity) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE t(id INTEGER, name TEXT);", true);
+    sqlite::execute(conn,
+                    "INSERT INTO t VALUES(1, 'one'), (2, NULL), (3, 'three'), (NULL, 'four'), "
+                    "(5, 'five');",
+                    true);
+    sqlite::query q(conn, "SELECT id, name FROM t ORDER BY rowid;");
+    sqlite::arrow_exporter exporter(q, {.batch_size = 2});
+
+    std::vector<std::int64_t> lengths;
+    std::vector<std::string> names;
+    std::int64_t null_ids = 0;
+    ArrowArray batch;
+    while (exporter.export_next(&batch)) {
+        lengths.push_back(batch.length);
+        ASSERT_EQ(batch.n_children, 2);
+        ArrowArray *ids   = batch.children[0];
+        ArrowArray *texts = batch.children[1];
+        EXPECT_EQ(ids->length, batch.length);
+        null_ids += ids->null_count;
+        for (std::int64_t row = 0; row < texts->length; ++row) {
+            names.emplace_back(arrow_valid(texts, row) ? arrow_string(texts, row) : "<null>");
+        }
+        batch.release(&batch);
+    }
+    EXPECT_EQ(lengths, (std::vector<std::int64_t>{2, 2, 1}));
+    EXPECT_EQ(null_ids, 1);
+    EXPECT_EQ(names, (std::vector<std::string>{"one", "<null>", "three", "four", "five"}));
+}
+
+TEST(ArrowExportTest, InfersExpressionTypesFromFirstBatch) {
+    sqlite::connection conn(":memory:");
+    sqlite::query q(conn, "SELECT NULL AS a, 1.5 AS b, NULL AS c UNION ALL SELECT 7, 2.5, NULL;");
+    sqlite::arrow_exporter exporter(q);
+
+    auto const &types = exporter.types();
+    ASSERT_EQ(types.size(), 3u);
+    EXPECT_EQ(types[0], sqlite::arrow_type::int64);
+    EXPECT_EQ(types[1], sqlite::arrow_type::float64);
+    EXPECT_EQ(types[2], sqlite::arrow_type::large_utf8);
+
+    ArrowArray batch;
+    ASSERT_TRUE(exporter.export_next(&batch));
+    ArrowArray *a = batch.children[0];
+    ASSERT_EQ(a->length, 2);
+    EXPECT_EQ(a->null_count, 1);
+    EXPECT_FALSE(arrow_valid(a, 0));
+    EXPECT_EQ(static_cast<std::int64_t const *>(a->buffers[1])[1], 7);
+    ArrowArray *c = batch.children[2];
+    EXPECT_EQ(c->null_count, 2);
+    batch.release(&batch);
+    EXPECT_FALSE(exporter.export_next(&batch));
+}
@@ -0,0 +1,116 @@
+#include "test_common.hpp"
+
+#include <sqlite/blob_stream.hpp>
+#include <sqlite/command.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+
+#include <array>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+void create_artifacts(sqlite::connection &conn) {
+    sqlite::execute(conn, "CREATE TABLE artifacts(id INTEGER PRIMARY KEY, data BLOB);", true);
+}
+} // namespace
+
+TEST(BlobStreamTest, WritesIntoZeroblobAndReadsInChunks) {
+    sqlite::connection conn(":memory:");
+    create_artifacts(conn);
+    sqlite::command insert(conn, "INSERT INTO artifacts(id, data) VALUES(?, ?);");
+    insert % 1 % sqlite::zeroblob{1000};
+    insert.step_once();
+
+    sqlite::blob_stream blob(conn, "artifacts", "data", 1, sqlite::blob_mode::read_write);
+    ASSERT_EQ(blob.size(), 1000u);
+    std::vector<unsigned char> chunk(100);
+    for (std::size_t offset = 0; offset < blob.size(); offset += chunk.size()) {
+        std::fill(chunk.begin(), chunk.end(), static_cast<unsigned char>(offset / 100));
+        blob.write(chunk, offset);
+    }
+    EXPECT_THROW(blob.write(chunk, 950), sqlite::database_exception);
+
+    std::array<unsigned char, 64> buffer{};
+    std::size_t total = 0;
+    std::size_t calls = 0;
+    blob.read_chunks(buffer, [&](std::span<const unsigned char> part) {
+        for (std::size_t i = 0; i < part.size(); ++i) {
+            EXPECT_EQ(part[i], static_cast<unsigned char>((total + i) / 100));
+        }
+        total += part.size();
+        ++calls;
+    });
+    EXPECT_EQ(total, 1000u);
+    EXPECT_EQ(calls, 16u);
+}
+
+TEST(BlobStreamTest, ReopenIteratesRows) {
+    sqlite::connection conn(":memory:");
+    create_artifacts(conn);
+    sqlite::execute(conn, "INSERT INTO artifacts VALUES(1, x'01'), (2, x'0202'), (3, x'030303');",
+                    true);
+
+    sqlite::blob_stream blob(conn, "artifacts", "data", 1);
+    EXPECT_FALSE(blob.writable());
+    std::vector<std::size_t> sizes;
+    for (std::int64_t row = 1; row <= 3; ++row) {
+        if (row > 1) {
+            blob.reopen(row);
+        }
+        sizes.push_back(blob.size());
+        std::array<unsigned char, 8> buffer{};
+        auto got = blob.read(buffer, 0);
+        EXPECT_EQ(got, blob.size());
+        EXPECT_EQ(buffer[0], static_cast<unsigned char>(row));
+    }
+    EXPECT_EQ(sizes, (std::vector<std::size_t>{1, 2, 3}));
+    EXPECT_THROW(blob.reopen(42), sqlite::database_exception);
+    EXPECT_THROW(sqlite::blob_stream(conn, "artifacts", "data", 99), sqlite::database_exception);
+}
+
+TEST(BlobStreamTest, StreambufAdapterRoundTrips) {
+    sqlite::connection conn(":memory:");
+    create_artifacts(conn);
+    std::string payload;
+    for (int i = 0; i < 500; ++i) {
+        payload += "line " + std::to_string(i) + "\n";
+    }
+    sqlite::command insert(conn, "INSERT INTO artifacts(id, data) VALUES(?, ?);");
+    insert % 7 % sqlite::zeroblob{payload.size()};
+    insert.step_once();
+
+    {
+        sqlite::blob_stream blob(conn, "artifacts", "data", 7, sqlite::blob_mode::read_write);
+        sqlite::blob_streambuf buf(blob, 128);
+        std::ostream out(&buf);
+        out << payload;
+        out.flush();
+        EXPECT_TRUE(out.good());
+        out << 'x';
+        out.flush();
+        EXPECT_FALSE(out.good());
+    }
+
+    sqlite::blob_stream blob(conn, "artifacts", "data", 7);
+    sqlite::blob_streambuf buf(blob, 128);
+    std::istream in(&buf);
+    std::string first;
+    std::getline(in, first);
+    EXPECT_EQ(first, "line 0");
+    in.seekg(0, std::ios_base::beg);
+    std::string all((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(all, payload);
+
+    in.clear();
+    in.seekg(-4, std::ios_base::end);
+    std::string tail(4, '\0');
+    in.read(tail.data(), 4);
+    EXPECT_EQ(tail, "499\n");
+}
@@ -0,0 +1,113 @@
+#include "test_common.hpp"
+
+#include <sqlite/bulk_export.hpp>
+#include <sqlite/bulk_import.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+using namespace testhelpers;
+
+namespace {
+void seed_mixed(sqlite::connection &conn) {
+    sqlite::execute(conn, "CREATE TABLE mixed(id INTEGER, score REAL, label TEXT, data BLOB);",
+                    true);
+    sqlite::execute(conn,
+                    "INSERT INTO mixed VALUES"
+                    "(1, 2.0, 'plain', NULL),"
+                    "(-7, 1.5, 'a,b \"q\"', x'00ff'),"
+                    "(3, NULL, '', NULL),"
+                    "(4, 1e300, 'line\nbreak' || char(9) || char(1), x'');",
+                    true);
+}
+
+std::string export_to_string(sqlite::query &q, sqlite::export_options options,
+                             sqlite::export_stats *stats = nullptr) {
+    std::string out;
+    sqlite::stream_exporter exporter(q, options);
+    auto result = exporter.write([&](std::string_view chunk) { out.append(chunk); });
+    if (stats) {
+        *stats = result;
+    }
+    return out;
+}
+} // namespace
+
+TEST(BulkExportTest, CsvQuotesOnlyWhereNeeded) {
+    sqlite::connection conn(":memory:");
+    seed_mixed(conn);
+    sqlite::query q(conn,
+                    "SELECT id, score, label, data AS \"raw,data\" FROM mixed ORDER BY rowid;");
+    sqlite::export_stats stats;
+    auto csv = export_to_string(q, {}, &stats);
+    EXPECT_EQ(csv, "id,score,label,\"raw,data\"\n"
+                   "1,2.0,plain,\n"
+                   "-7,1.5,\"a,b \"\"q\"\"\",00ff\n"
+                   "3,,\"\",\n"
+                   "4,1e+300,\"line\nbreak\t\x01\",\n");
+    EXPECT_EQ(stats.rows, 4u);
+    EXPECT_EQ(stats.bytes, csv.size());
+}
+
+TEST(BulkExportTest, NdjsonEscapesTextAndKeys) {
+    sqlite::connection conn(":memory:");
+    seed_mixed(conn);
+    sqlite::query q(conn,
+                    "SELECT id, score AS \"s\\\"\"\", label, data FROM mixed ORDER BY rowid;");
+    auto json = export_to_string(q, {.format = sqlite::export_format::ndjson, .crlf = true});
+    EXPECT_EQ(json, "{\"id\":1,\"s\\\\\\\"\":2.0,\"label\":\"plain\",\"data\":null}\r\n"
+                    "{\"id\":-7,\"s\\\\\\\"\":1.5,\"label\":\"a,b \\\"q\\\"\","
+                    "\"data\":\"00ff\"}\r\n"
+                    "{\"id\":3,\"s\\\\\\\"\":null,\"label\":\"\",\"data\":null}\r\n"
+                    "{\"id\":4,\"s\\\\\\\"\":1e+300,\"label\":\"line\\nbreak\\t\\u0001\","
+                    "\"data\":\"\"}\r\n");
+}
+
+TEST(BulkExportTest, SmallBufferToFileRoundTripsThroughImport) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE src(id INTEGER, name TEXT, note TEXT);", true);
+    sqlite::execute(conn,
+                    "WITH RECURSIVE n(i) AS "
+                    "(SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 5000) "
+                    "INSERT INTO src SELECT i, 'name \"' || i || '\"', "
+                    "CASE i % 3 WHEN 0 THEN NULL WHEN 1 THEN '' ELSE 'a,b' END FROM n;",
+                    true);
+
+    TempFile file("export_roundtrip");
+    sqlite::export_stats stats;
+    {
+        std::FILE *out = std::fopen(file.string().c_str(), "wb");
+        ASSERT_NE(out, nullptr);
+        sqlite::query q(conn, "SELECT id, name, note FROM src ORDER BY id;");
+        sqlite::stream_exporter exporter(q, {.buffer_size = 256});
+        stats = exporter.write(fileno(out));
+        std::fclose(out);
+    }
+    EXPECT_EQ(stats.rows, 5000u);
+    EXPECT_GT(stats.flushes, 100u);
+
+    sqlite::execute(conn, "CREATE TABLE dst(id INTEGER, name TEXT, note TEXT);", true);
+    sqlite::import_file(conn, "dst", file.string());
+    EXPECT_EQ(count_rows(conn, "src"), count_rows(conn, "dst"));
+    EXPECT_EQ(count_rows(conn, "(SELECT * FROM src EXCEPT SELECT * FROM dst)"), 0);
+    EXPECT_EQ(count_rows(conn, "dst WHERE note IS NULL"), 1666);
+}
+
+TEST(BulkExportTest, ThrowingSinkResetsTheQuery) {
+    sqlite::connection conn(":memory:");
+    seed_mixed(conn);
+    sqlite::query q(conn, "SELECT id FROM mixed WHERE id > ? ORDER BY rowid;");
+    q % 0;
+    sqlite::stream_exporter exporter(q, {.header = false, .buffer_size = 2});
+    EXPECT_THROW(exporter.write([](std::string_view) { throw std::runtime_error("disk full"); }),
+                 std::runtime_error);
+
+    // The next run starts from the first row again, with the bindings kept.
+    std::string out;
+    exporter.write([&](std::string_view chunk) { out.append(chunk); });
+    EXPECT_EQ(out, "1\n3\n4\n");
+}
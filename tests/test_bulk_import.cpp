@@ -0,0 +1,105 @@
+#include "test_common.hpp"
+
+#include <sqlite/bulk_import.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+
+#include <fstream>
+#include <string>
+
+using namespace testhelpers;
+
+namespace {
+void write_file(std::string const &path, std::string const &content) {
+    std::ofstream out(path, std::ios::binary);
+    out << content;
+}
+} // namespace
+
+TEST(BulkImportTest, CsvHeaderQuotesAndTypes) {
+    TempFile input("import_csv");
+    write_file(input.string(), "id,name,score,code\r\n"
+                               "1,plain,1.5,007\r\n"
+                               "2,\"with, comma\",,42\r\n"
+                               "\n"
+                               "3,\"say \"\"hi\"\"\",-2,\"\"\r\n"
+                               "4,\"two\nlines\",3e2,x");
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE t(id, name, score, code);", true);
+
+    auto stats = sqlite::import_file(conn, "t", input.string());
+    EXPECT_EQ(stats.rows, 4u);
+    EXPECT_EQ(stats.transactions, 1u);
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(name, '|') FROM t ORDER BY id;"),
+              "plain|with, comma|say \"hi\"|two\nlines");
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(typeof(score), ',') FROM t ORDER BY id;"),
+              "real,null,integer,real");
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(typeof(code) || ':' || code, ',') FROM t "
+                            "WHERE code IS NOT NULL ORDER BY id;"),
+              "text:007,integer:42,text:,text:x");
+}
+
+TEST(BulkImportTest, ParallelParsersWithBackpressureAndBulkMode) {
+    TempFile input("import_parallel");
+    std::string csv = "id,name,qty\n";
+    for (int i = 1; i <= 20000; ++i) {
+        auto id = std::to_string(i);
+        csv += id + ",name" + id + "," + std::to_string(i % 10) + "\n";
+    }
+    write_file(input.string(), csv);
+    TempFile db("import_parallel_db");
+    sqlite::connection conn(db.string());
+    sqlite::execute(conn, "CREATE TABLE items(id INTEGER PRIMARY KEY, name TEXT, qty INTEGER);",
+                    true);
+    sqlite::execute(conn, "CREATE INDEX items_qty ON items(qty);", true);
+
+    std::size_t reports = 0;
+    sqlite::bulk_load_options bulk;
+    bulk.rows_per_transaction = 5000;
+    auto stats = sqlite::import_file(conn, "items", input.string(),
+                                     {.parser_threads = 4,
+                                      .batch_rows     = 100,
+                                      .queue_depth    = 2,
+                                      .bulk           = bulk,
+                                      .progress       = [&](auto const &) { ++reports; }});
+    EXPECT_EQ(stats.rows, 20000u);
+    EXPECT_EQ(stats.batches, reports);
+    EXPECT_EQ(stats.bytes, csv.size() - 12);
+    EXPECT_GT(stats.rows_per_second(), 0.0);
+    EXPECT_EQ(count_rows(conn, "items"), 20000);
+    EXPECT_EQ(text_of(conn, "SELECT sum(id) FROM items;"), "200010000");
+    EXPECT_EQ(count_rows(conn, "items INDEXED BY items_qty WHERE qty = 3"), 2000);
+}
+
+TEST(BulkImportTest, NdjsonMapsKeysToColumns) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE events(id, kind, payload, ok);", true);
+    std::string input = "{\"id\": 1, \"kind\": \"caf\\u00e9\", \"payload\": {\"a\": [1, \"]\"]}, "
+                        "\"ok\": true}\n"
+                        "\n"
+                        "{\"kind\": \"tab\\there\", \"id\": 2, \"extra\": 5, \"ok\": null}\n"
+                        "{\"id\": 3.25}\n";
+    auto stats =
+        sqlite::import_data(conn, "events", input, {.format = sqlite::import_format::ndjson});
+    EXPECT_EQ(stats.rows, 3u);
+    EXPECT_EQ(text_of(conn, "SELECT kind FROM events WHERE id = 1;"), "caf\xC3\xA9");
+    EXPECT_EQ(text_of(conn, "SELECT payload FROM events WHERE id = 1;"), "{\"a\": [1, \"]\"]}");
+    EXPECT_EQ(text_of(conn, "SELECT kind FROM events WHERE id = 2;"), "tab\there");
+    EXPECT_EQ(text_of(conn, "SELECT typeof(ok) || typeof(payload) FROM events WHERE id = 2;"),
+              "nullnull");
+    EXPECT_EQ(text_of(conn, "SELECT typeof(id) FROM events WHERE kind IS NULL;"), "real");
+}
+
+TEST(BulkImportTest, ParseErrorRollsBack) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE t(a, b);", true);
+    std::string input = "a,b\n";
+    for (int i = 0; i < 1000; ++i) {
+        input += "1,2\n";
+    }
+    input += "1,2,3\n";
+    EXPECT_THROW(sqlite::import_data(conn, "t", input, {.batch_rows = 10}),
+                 sqlite::database_exception);
+    EXPECT_EQ(count_rows(conn, "t"), 0);
+}
@@ -0,0 +1,131 @@
+#include "test_common.hpp"
+
+#include <sqlite/bulk_load.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <cstdint>
+#include <string>
+
+using namespace testhelpers;
+
+namespace {
+struct item {
+    std::int64_t id;
+    std::string name;
+    int qty;
+};
+VSQLITE_FIELDS(item, "items", id, name, qty)
+
+std::string pragma_text(sqlite::connection &con, std::string const &pragma) {
+    sqlite::query q(con, "PRAGMA " + pragma + ";");
+    auto res = q.get_result();
+    EXPECT_TRUE(res->next_row());
+    auto value = res->get<std::string>(0);
+    q.clear();
+    return value;
+}
+
+void create_items(sqlite::connection &conn) {
+    sqlite::execute(conn,
+                    "CREATE TABLE items(id INTEGER PRIMARY KEY, name TEXT UNIQUE, qty INTEGER);",
+                    true);
+    sqlite::execute(conn, "CREATE INDEX items_qty ON items(qty);", true);
+    sqlite::execute(conn, "CREATE INDEX items_name_qty ON items(name, qty);", true);
+}
+} // namespace
+
+TEST(BulkLoadTest, LoaderSortsByKeyAndRebuildsIndexes) {
+    TempFile file("bulk_load");
+    sqlite::connection conn(file.string());
+    create_items(conn);
+    auto synchronous = pragma_text(conn, "synchronous");
+    auto cache_size  = pragma_text(conn, "cache_size");
+    auto journal     = pragma_text(conn, "journal_mode");
+
+    {
+        sqlite::bulk_loader<item> loader(conn, {.cache_kib = 8192,
+                                                .sort_buffer = 100,
+                                                .rows_per_transaction = 250});
+        EXPECT_EQ(loader.session().dropped_indexes(),
+                  (std::vector<std::string>{"items_qty", "items_name_qty"}));
+        EXPECT_EQ(count_rows(conn, "sqlite_master WHERE type = 'index' AND sql IS NOT NULL"), 0);
+        EXPECT_EQ(pragma_text(conn, "synchronous"), "0");
+        EXPECT_EQ(pragma_text(conn, "cache_size"), "-8192");
+        EXPECT_EQ(pragma_text(conn, "journal_mode"), "memory");
+
+        for (int i = 1000; i > 0; --i) {
+            loader.insert({i, "item" + std::to_string(i), i % 7});
+        }
+        loader.finish();
+    }
+
+    EXPECT_EQ(count_rows(conn, "items"), 1000);
+    EXPECT_EQ(count_rows(conn, "sqlite_master WHERE type = 'index' AND sql IS NOT NULL"), 2);
+    EXPECT_EQ(count_rows(conn, "items INDEXED BY items_qty WHERE qty = 3"), 143);
+    EXPECT_EQ(pragma_text(conn, "synchronous"), synchronous);
+    EXPECT_EQ(pragma_text(conn, "cache_size"), cache_size);
+    EXPECT_EQ(pragma_text(conn, "journal_mode"), journal);
+    EXPECT_EQ(pragma_text(conn, "integrity_check"), "ok");
+}
+
+TEST(BulkLoadTest, RestoresStateWhenLoadThrows) {
+    TempFile file("bulk_load_throw");
+    sqlite::connection conn(file.string());
+    create_items(conn);
+    auto synchronous = pragma_text(conn, "synchronous");
+    auto journal     = pragma_text(conn, "journal_mode");
+
+    EXPECT_THROW(
+        {
+            sqlite::bulk_loader<item> loader(conn, {.sort_buffer = 10});
+            for (int i = 0; i < 20; ++i) {
+                // The UNIQUE constraint on name is kept during the load and rejects this batch.
+                loader.insert({i, i == 15 ? "item3" : "item" + std::to_string(i), i});
+            }
+            loader.finish();
+        },
+        sqlite::database_exception);
+
+    EXPECT_EQ(count_rows(conn, "items"), 0);
+    EXPECT_EQ(count_rows(conn, "sqlite_master WHERE type = 'index' AND sql IS NOT NULL"), 2);
+    EXPECT_EQ(pragma_text(conn, "synchronous"), synchronous);
+    EXPECT_EQ(pragma_text(conn, "journal_mode"), journal);
+}
+
+TEST(BulkLoadTest, KeepsUniqueIndexesAndRetriesFailedRebuilds) {
+    sqlite::connection conn(":memory:");
+    create_items(conn);
+    sqlite::execute(conn, "CREATE UNIQUE INDEX items_qty_unique ON items(qty, id);", true);
+    {
+        sqlite::bulk_load_session session(conn, "items");
+        EXPECT_EQ(session.dropped_indexes(),
+                  (std::vector<std::string>{"items_qty", "items_name_qty"}));
+        session.finish();
+        EXPECT_TRUE(session.dropped_indexes().empty());
+    }
+
+    sqlite::execute(conn, "CREATE UNIQUE INDEX items_qty_only ON items(qty);", true);
+    sqlite::bulk_load_session session(conn, "items", {.drop_unique_indexes = true});
+    EXPECT_EQ(session.dropped_indexes().size(), 4u);
+    sqlite::execute(conn, "INSERT INTO items(name, qty) VALUES('a', 1), ('b', 1);", true);
+    EXPECT_THROW(session.finish(), sqlite::database_exception);
+    EXPECT_FALSE(session.finished());
+    EXPECT_EQ(session.dropped_indexes(), (std::vector<std::string>{"items_qty_only"}));
+    EXPECT_EQ(count_rows(conn, "items"), 2);
+
+    sqlite::execute(conn, "UPDATE items SET qty = 2 WHERE name = 'b';", true);
+    session.finish();
+    EXPECT_TRUE(session.finished());
+    EXPECT_TRUE(session.dropped_indexes().empty());
+    EXPECT_EQ(count_rows(conn, "sqlite_master WHERE type = 'index' AND sql IS NOT NULL"), 4);
+}
+
+TEST(BulkLoadTest, RejectsOpenTransaction) {
+    sqlite::connection conn(":memory:");
+    create_items(conn);
+    sqlite::transaction tx(conn);
+    EXPECT_THROW(sqlite::bulk_load_session(conn, "items"), sqlite::database_exception);
+}
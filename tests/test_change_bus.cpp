@@ -0,0 +1,198 @@
+#include "test_common.hpp"
+
+#include <sqlite/change_bus.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query_cache.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+void create_tables(sqlite::connection &conn) {
+    sqlite::execute(conn, "CREATE TABLE orders(id INTEGER PRIMARY KEY, total INTEGER);", true);
+    sqlite::execute(conn, "CREATE TABLE audit(id INTEGER PRIMARY KEY);", true);
+}
+} // namespace
+
+TEST(ChangeBusTest, DeliversOneBatchPerCommit) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::change_bus bus(conn);
+
+    std::mutex mutex;
+    std::vector<std::vector<sqlite::table_change>> batches;
+    auto sub = bus.subscribe("Orders", [&](std::span<sqlite::table_change const> changes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.emplace_back(changes.begin(), changes.end());
+    });
+
+    {
+        sqlite::transaction tx(conn);
+        sqlite::execute(conn, "INSERT INTO orders(id, total) VALUES(1, 10), (2, 20);", true);
+        sqlite::execute(conn, "INSERT INTO audit DEFAULT VALUES;", true);
+        sqlite::execute(conn, "UPDATE orders SET total = 11 WHERE id = 1;", true);
+        tx.commit();
+    }
+    sqlite::execute(conn, "DELETE FROM orders WHERE id = 2;", true);
+    bus.flush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(batches.size(), 2u);
+    ASSERT_EQ(batches[0].size(), 3u);
+    EXPECT_EQ(batches[0][0].kind, sqlite::change_kind::insert);
+    EXPECT_EQ(batches[0][0].table, "orders");
+    EXPECT_EQ(batches[0][2].kind, sqlite::change_kind::update);
+    EXPECT_EQ(batches[0][2].rowid, 1);
+    ASSERT_EQ(batches[1].size(), 1u);
+    EXPECT_EQ(batches[1][0].kind, sqlite::change_kind::remove);
+    EXPECT_EQ(batches[1][0].schema, "main");
+
+    auto stats = bus.stats();
+    EXPECT_EQ(stats.committed_batches, 2u);
+    EXPECT_EQ(stats.changes, 5u);
+    EXPECT_EQ(stats.callbacks, 2u);
+}
+
+TEST(ChangeBusTest, SharesHooksWithQueryCache) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::query_cache cache(conn);
+    cache.fetch("SELECT COUNT(*) FROM orders;");
+
+    std::atomic<int> delivered{0};
+    {
+        sqlite::change_bus bus(conn);
+        auto sub = bus.subscribe("orders", [&](std::span<sqlite::table_change const> changes) {
+            delivered += static_cast<int>(changes.size());
+        });
+        sqlite::execute(conn, "INSERT INTO orders(id, total) VALUES(1, 10);", true);
+        bus.flush();
+        EXPECT_EQ(delivered.load(), 1);
+        EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM orders;")->at(0, 0).as_int64(), 1);
+    }
+
+    // The cache keeps its invalidation after the bus is gone.
+    sqlite::execute(conn, "INSERT INTO orders(id, total) VALUES(2, 20);", true);
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM orders;")->at(0, 0).as_int64(), 2);
+    EXPECT_EQ(cache.stats().invalidations, 2u);
+}
+
+TEST(ChangeBusTest, DiscardsRollbacksAndFiltersRowids) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::change_bus bus(conn);
+
+    std::atomic<int> seen{0};
+    auto sub = bus.subscribe(
+        "main.orders",
+        [&](std::span<sqlite::table_change const> changes) {
+            for (auto const &change : changes) {
+                EXPECT_GE(change.rowid, 10);
+                ++seen;
+            }
+        },
+        {.first = 10, .last = 20});
+
+    {
+        sqlite::transaction tx(conn);
+        sqlite::execute(conn, "INSERT INTO orders(id) VALUES(15);", true);
+        tx.rollback();
+    }
+    sqlite::execute(conn, "INSERT INTO orders(id) VALUES(5), (12), (30);", true);
+    bus.flush();
+    EXPECT_EQ(seen.load(), 1);
+    EXPECT_EQ(bus.stats().discarded_batches, 1u);
+}
+
+TEST(ChangeBusTest, MarksDeletesTheUpdateHookMisses) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::execute(conn, "INSERT INTO orders(id) VALUES(1), (12);", true);
+    sqlite::change_bus bus(conn);
+
+    std::mutex mutex;
+    std::vector<sqlite::table_change> seen;
+    auto sub = bus.subscribe(
+        "audit",
+        [&](std::span<sqlite::table_change const> changes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            seen.insert(seen.end(), changes.begin(), changes.end());
+        },
+        {.first = 10, .last = 20});
+
+    // A DELETE without WHERE truncates the table and skips the update hook.
+    sqlite::execute(conn, "DELETE FROM orders;", true);
+    bus.flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_EQ(seen.size(), 1u);
+        EXPECT_EQ(seen[0].kind, sqlite::change_kind::unknown);
+        EXPECT_TRUE(seen[0].table.empty());
+    }
+
+    // Rows the hook reported in the same window do not hide the truncation.
+    {
+        sqlite::transaction tx(conn);
+        sqlite::execute(conn, "INSERT INTO orders(id) VALUES(1), (2);", true);
+        sqlite::execute(conn, "DELETE FROM orders;", true);
+        sqlite::execute(conn, "INSERT INTO audit(id) VALUES(11);", true);
+        tx.commit();
+    }
+    sqlite::execute(conn, "INSERT INTO audit(id) VALUES(12);", true);
+    bus.flush();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(seen.size(), 4u);
+    EXPECT_EQ(seen[1].kind, sqlite::change_kind::unknown);
+    EXPECT_EQ(seen[2].rowid, 11);
+    EXPECT_EQ(seen[3].rowid, 12);
+    auto stats = bus.stats();
+    EXPECT_EQ(stats.unknown_changes, 2u);
+    EXPECT_EQ(stats.changes, 4u);
+}
+
+TEST(ChangeBusTest, SlowSubscribersDoNotBlockWriterAndCanUnsubscribe) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::change_bus bus(conn);
+
+    std::atomic<int> slow_calls{0};
+    std::atomic<int> all_calls{0};
+    auto slow = bus.subscribe("orders", [&](std::span<sqlite::table_change const>) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ++slow_calls;
+    });
+    auto all = bus.subscribe("", [&](std::span<sqlite::table_change const>) { ++all_calls; });
+
+    for (int i = 0; i < 5; ++i) {
+        sqlite::execute(conn, "INSERT INTO orders DEFAULT VALUES;", true);
+    }
+    slow.reset();
+    int after_reset = slow_calls.load();
+    sqlite::execute(conn, "INSERT INTO audit DEFAULT VALUES;", true);
+    bus.flush();
+
+    EXPECT_EQ(slow_calls.load(), after_reset);
+    EXPECT_LE(after_reset, 5);
+    EXPECT_EQ(bus.stats().committed_batches, 6u);
+    EXPECT_GE(all_calls.load(), 1);
+}
+
+TEST(ChangeBusTest, CountsThrowingCallbacks) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::change_bus bus(conn);
+    auto sub = bus.subscribe("orders", [](std::span<sqlite::table_change const>) {
+        throw std::runtime_error("subscriber failure");
+    });
+    sqlite::execute(conn, "INSERT INTO orders DEFAULT VALUES;", true);
+    bus.flush();
+    EXPECT_EQ(bus.stats().callback_errors, 1u);
+}
@@ -0,0 +1,94 @@
+#include "test_common.hpp"
+
+#include <sqlite/checkpoint.hpp>
+#include <sqlite/command.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/snapshot.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <thread>
+
+using namespace testhelpers;
+
+namespace {
+void insert_rows(sqlite::connection &con, int count) {
+    sqlite::transaction txn(con, sqlite::transaction_type::immediate);
+    sqlite::command insert(con, "INSERT INTO log(body) VALUES (?);");
+    for (int i = 0; i < count; ++i) {
+        insert % std::string(512, 'x');
+        insert.step_once();
+        insert.clear();
+    }
+    txn.commit();
+}
+} // namespace
+
+TEST(CheckpointTest, RequiresWalMode) {
+    TempFile db("checkpoint_rollback");
+    sqlite::connection writer(db.string());
+    sqlite::execute(writer, "CREATE TABLE log(id INTEGER PRIMARY KEY, body TEXT);", true);
+    EXPECT_THROW(sqlite::checkpoint_manager manager(writer), sqlite::database_exception);
+}
+
+TEST(CheckpointTest, BackgroundThreadCheckpointsAfterThreshold) {
+    TempFile db("checkpoint_background");
+    sqlite::connection writer(db.string());
+    sqlite::enable_wal(writer);
+    sqlite::execute(writer, "CREATE TABLE log(id INTEGER PRIMARY KEY, body TEXT);", true);
+
+    sqlite::checkpoint_manager manager(writer, {.passive_frames = 4,
+                                                .interval       = std::chrono::milliseconds(20)});
+    insert_rows(writer, 100);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (manager.stats().checkpointed_frames == 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto stats = manager.stats();
+    EXPECT_GT(stats.passive_runs, 0u);
+    EXPECT_GT(stats.checkpointed_frames, 0u);
+    EXPECT_GT(stats.wal_bytes, 0);
+}
+
+TEST(CheckpointTest, TruncateResetsWal) {
+    TempFile db("checkpoint_truncate");
+    sqlite::connection writer(db.string());
+    sqlite::enable_wal(writer);
+    sqlite::execute(writer, "CREATE TABLE log(id INTEGER PRIMARY KEY, body TEXT);", true);
+
+    sqlite::checkpoint_manager manager(writer, {.passive_frames = 1000000,
+                                                .interval       = std::chrono::hours(1)});
+    insert_rows(writer, 20);
+    EXPECT_GT(manager.stats().wal_frames, 0);
+
+    auto result = manager.checkpoint_now(sqlite::checkpoint_mode::truncate);
+    EXPECT_FALSE(result.busy);
+    EXPECT_EQ(result.wal_frames, 0);
+    EXPECT_EQ(manager.stats().truncate_runs, 1u);
+    EXPECT_EQ(count_rows(writer, "log"), 20);
+}
+
+TEST(CheckpointTest, RepeatedCheckpointsCountEachFrameOnce) {
+    TempFile db("checkpoint_count");
+    sqlite::connection writer(db.string());
+    sqlite::enable_wal(writer);
+    sqlite::execute(writer, "CREATE TABLE log(id INTEGER PRIMARY KEY, body TEXT);", true);
+
+    sqlite::checkpoint_manager manager(writer, {.passive_frames = 1000000,
+                                                .interval       = std::chrono::hours(1)});
+    insert_rows(writer, 20);
+    auto first = manager.checkpoint_now(sqlite::checkpoint_mode::passive);
+    ASSERT_GT(first.checkpointed_frames, 0);
+    auto again = manager.checkpoint_now(sqlite::checkpoint_mode::passive);
+    EXPECT_EQ(again.checkpointed_frames, first.checkpointed_frames);
+    EXPECT_EQ(manager.stats().checkpointed_frames,
+              static_cast<std::uint64_t>(first.checkpointed_frames));
+
+    manager.checkpoint_now(sqlite::checkpoint_mode::truncate);
+    insert_rows(writer, 20);
+    auto fresh = manager.checkpoint_now(sqlite::checkpoint_mode::passive);
+    EXPECT_EQ(manager.stats().checkpointed_frames,
+              static_cast<std::uint64_t>(first.checkpointed_frames + fresh.checkpointed_frames));
+}
@@ -0,0 +1,105 @@
+#include "test_common.hpp"
+
+#include <sqlite/chunked_mutation.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/snapshot.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+void seed_events(sqlite::connection &conn, int count) {
+    sqlite::execute(conn, "CREATE TABLE events(id INTEGER PRIMARY KEY, ts INTEGER, state TEXT);",
+                    true);
+    sqlite::transaction tx(conn);
+    sqlite::execute insert(conn, "INSERT INTO events(ts, state) VALUES(?, 'new');");
+    for (int i = 0; i < count; ++i) {
+        insert % (i % 100);
+        insert();
+        insert.clear();
+    }
+    tx.commit();
+}
+} // namespace
+
+TEST(ChunkedMutationTest, DeletesInChunksAndReportsProgress) {
+    sqlite::connection conn(":memory:");
+    seed_events(conn, 1000);
+
+    std::vector<sqlite::chunked_mutation_progress> reports;
+    auto result = sqlite::chunked_mutation::remove(conn, "events", "ts < ?")
+                      .bind(30)
+                      .run({.chunk_size = 50,
+                            .min_chunk  = 50,
+                            .max_chunk  = 50,
+                            .progress   = [&](auto const &p) {
+                                reports.push_back(p);
+                                return true;
+                            }});
+    EXPECT_TRUE(result.finished);
+    EXPECT_EQ(result.rows, 300u);
+    EXPECT_EQ(result.chunks, 6u);
+    ASSERT_EQ(reports.size(), 7u);
+    EXPECT_EQ(reports.front().rows, 50u);
+    EXPECT_TRUE(reports.back().finished);
+    EXPECT_EQ(count_rows(conn, "events WHERE ts < 30"), 0);
+    EXPECT_EQ(count_rows(conn, "events"), 700);
+}
+
+TEST(ChunkedMutationTest, UpdatesOnceAndStopsOnRequest) {
+    sqlite::connection conn(":memory:");
+    seed_events(conn, 500);
+
+    auto stopped = sqlite::chunked_mutation::update(conn, "events", "ts = ts + 1000", "1")
+                       .run({.chunk_size = 100,
+                             .progress   = [](auto const &p) { return p.chunks < 2; }});
+    EXPECT_FALSE(stopped.finished);
+    EXPECT_EQ(stopped.chunks, 2u);
+    EXPECT_GE(stopped.rows, 100u);
+    auto updated = count_rows(conn, "events WHERE ts >= 1000");
+    EXPECT_EQ(static_cast<std::uint64_t>(updated), stopped.rows);
+
+    auto rest = sqlite::chunked_mutation::update(conn, "events", "state = 'done'", "state = ?")
+                    .bind("new")
+                    .run({.key = "id", .time_budget = std::chrono::milliseconds(1000)});
+    EXPECT_TRUE(rest.finished);
+    EXPECT_EQ(rest.rows, 500u);
+    EXPECT_GT(rest.chunk_size, 1000u);
+    EXPECT_EQ(count_rows(conn, "events WHERE state = 'done'"), 500);
+}
+
+TEST(ChunkedMutationTest, CoversTheWholeKeyRange) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE edges(id INTEGER PRIMARY KEY, tag TEXT);", true);
+    sqlite::execute(conn,
+                    "INSERT INTO edges VALUES(-9223372036854775807 - 1, 'x'), (0, 'x'), "
+                    "(9223372036854775807, 'x');",
+                    true);
+
+    auto result = sqlite::chunked_mutation::update(conn, "edges", "tag = 'y'", "1")
+                      .run({.chunk_size = 1, .min_chunk = 1, .max_chunk = 1});
+    EXPECT_TRUE(result.finished);
+    EXPECT_EQ(result.rows, 3u);
+    EXPECT_EQ(result.last_key, INT64_MAX);
+    EXPECT_EQ(count_rows(conn, "edges WHERE tag = 'y'"), 3);
+}
+
+TEST(ChunkedMutationTest, CheckpointsWalBetweenChunks) {
+    TempFile db("chunked_mutation");
+    sqlite::connection conn(db.string());
+    sqlite::enable_wal(conn);
+    seed_events(conn, 300);
+
+    auto result = sqlite::chunked_mutation::remove(conn, "events", "")
+                      .run({.chunk_size = 100, .checkpoint_every = 1,
+                            .checkpoint = sqlite::checkpoint_mode::truncate});
+    EXPECT_TRUE(result.finished);
+    EXPECT_EQ(result.rows, 300u);
+    EXPECT_EQ(count_rows(conn, "events"), 0);
+    EXPECT_THROW(sqlite::chunked_mutation::remove(conn, "missing", "1").run(),
+                 sqlite::database_exception);
+}
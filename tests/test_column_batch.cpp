@@ -0,0 +1,92 @@
+#include "test_common.hpp"
+
+#include <sqlite/column_batch.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+void seed_metrics(sqlite::connection &conn, int rows) {
+    sqlite::execute(conn, "CREATE TABLE metrics(id INTEGER, label TEXT, value REAL, payload BLOB);",
+                    true);
+    sqlite::execute insert(conn, "INSERT INTO metrics VALUES(?, ?, ?, ?);");
+    for (int i = 0; i < rows; ++i) {
+        insert % i;
+        if (i % 3 == 0) {
+            insert % sqlite::nil;
+        } else {
+            insert % ("label" + std::to_string(i));
+        }
+        insert % (i * 0.5);
+        insert % std::vector<unsigned char>(static_cast<std::size_t>(i % 4), 0xAB);
+        insert();
+        insert.clear();
+    }
+}
+} // namespace
+
+TEST(ColumnBatchTest, FetchesColumnsInBatches) {
+    sqlite::connection conn(":memory:");
+    seed_metrics(conn, 10);
+
+    sqlite::query q(conn, "SELECT id, label, value, payload FROM metrics ORDER BY id;");
+    auto res = q.get_result();
+    sqlite::column_batch<std::int64_t, std::optional<std::string>, double,
+                         std::vector<unsigned char>>
+        batch;
+
+    std::vector<std::int64_t> ids;
+    std::vector<std::size_t> sizes;
+    while (res->fetch_columns(batch, 4) > 0) {
+        sizes.push_back(batch.size());
+        auto const &id_col    = batch.column<0>();
+        auto const &label_col = batch.column<1>();
+        auto const &value_col = batch.column<2>();
+        auto const &blob_col  = batch.column<3>();
+        ASSERT_EQ(label_col.offsets.size(), batch.size() + 1);
+        for (std::size_t row = 0; row < batch.size(); ++row) {
+            auto id = id_col[row];
+            ids.push_back(id);
+            EXPECT_DOUBLE_EQ(value_col[row], static_cast<double>(id) * 0.5);
+            EXPECT_EQ(label_col.is_null(row), id % 3 == 0);
+            if (!label_col.is_null(row)) {
+                EXPECT_EQ(label_col[row], "label" + std::to_string(id));
+            } else {
+                EXPECT_TRUE(label_col[row].empty());
+            }
+            EXPECT_EQ(blob_col[row].size(), static_cast<std::size_t>(id % 4));
+        }
+    }
+    EXPECT_EQ(sizes, (std::vector<std::size_t>{4, 4, 2}));
+    ASSERT_EQ(ids.size(), 10u);
+    EXPECT_EQ(ids.front(), 0);
+    EXPECT_EQ(ids.back(), 9);
+    EXPECT_TRUE(res->end());
+}
+
+TEST(ColumnBatchTest, TracksNullsInFixedColumns) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE t(v INTEGER);", true);
+    sqlite::execute(conn, "INSERT INTO t VALUES(1), (NULL), (3), (NULL);", true);
+
+    sqlite::query q(conn, "SELECT v FROM t ORDER BY rowid;");
+    auto batch = q.get_result()->fetch_columns<int>(100);
+    auto const &col = batch.column<0>();
+    ASSERT_EQ(batch.size(), 4u);
+    EXPECT_EQ(col.validity.null_count(), 2u);
+    EXPECT_EQ(col.validity.data()[0], 0b0101u);
+    EXPECT_EQ(col[1], 0);
+}
+
+TEST(ColumnBatchTest, RejectsTooManyColumns) {
+    sqlite::connection conn(":memory:");
+    sqlite::query q(conn, "SELECT 1;");
+    auto res = q.get_result();
+    EXPECT_THROW((res->fetch_columns<int, int>(1)), sqlite::database_exception);
+}
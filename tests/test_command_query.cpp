@@ -246,3 +246,59 @@ TEST(CommandQueryTest, QueryEachSupportsMixedBinding) {
     ASSERT_EQ(messages.size(), 1u);
     EXPECT_EQ(messages[0], "slow");
 }
+
+TEST(CommandQueryTest, TypedRowsStreamTuples) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE people(id INTEGER PRIMARY KEY, name TEXT, score REAL);",
+                    true);
+    sqlite::execute(conn,
+                    "INSERT INTO people(name, score) VALUES('ada', 1.5), ('bob', NULL), "
+                    "('cyd', 3.0);",
+                    true);
+
+    sqlite::query q(conn, "SELECT id, name, score FROM people ORDER BY id;");
+    std::vector<std::string> names;
+    std::vector<std::optional<double>> scores;
+    std::int64_t id_sum = 0;
+    for (auto [id, name, score] : q.rows<std::int64_t, std::string_view, std::optional<double>>()) {
+        id_sum += id;
+        names.emplace_back(name);
+        scores.push_back(score);
+    }
+    EXPECT_EQ(id_sum, 6);
+    EXPECT_EQ(names, (std::vector<std::string>{"ada", "bob", "cyd"}));
+    ASSERT_EQ(scores.size(), 3u);
+    EXPECT_EQ(scores[0], 1.5);
+    EXPECT_FALSE(scores[1].has_value());
+    EXPECT_EQ(scores[2], 3.0);
+}
+
+TEST(CommandQueryTest, TypedRowsSingleColumnAndBinding) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE nums(v INTEGER);", true);
+    sqlite::execute(conn, "INSERT INTO nums(v) VALUES(1), (2), (3), (4);", true);
+
+    sqlite::query q(conn, "SELECT v FROM nums WHERE v > ? ORDER BY v;");
+    std::vector<int> values;
+    for (int v : q.rows<int>(2)) {
+        values.push_back(v);
+    }
+    EXPECT_EQ(values, (std::vector<int>{3, 4}));
+
+    sqlite::query empty(conn, "SELECT v FROM nums WHERE v > 10;");
+    auto range = empty.rows<int>();
+    EXPECT_TRUE(range.begin() == range.end());
+}
+
+TEST(CommandQueryTest, TypedRowsRejectTooManyColumns) {
+    sqlite::connection conn(":memory:");
+    sqlite::query q(conn, "SELECT 1;");
+    EXPECT_THROW((q.rows<int, int>()), sqlite::database_exception);
+}
+
+TEST(CommandQueryTest, TypedRowsSurfaceStepErrors) {
+    sqlite::connection conn(":memory:");
+    sqlite::query q(conn, "SELECT abs(-9223372036854775807 - 1);");
+    auto range = q.rows<std::int64_t>();
+    EXPECT_THROW(range.begin(), sqlite::database_exception);
+}
@@ -60,6 +60,16 @@ inline int count_rows(sqlite::connection &con, std::string const &table_expressi
     return res->get<int>(0);
 }
 
+// First column of the first row of @p sql as text; the statement is reset for reuse.
+inline std::string text_of(sqlite::connection &con, std::string const &sql) {
+    sqlite::query q(con, sql);
+    auto res = q.get_result();
+    EXPECT_TRUE(res->next_row());
+    auto value = res->get<std::string>(0);
+    q.clear();
+    return value;
+}
+
 inline std::vector<unsigned char> load_blob(sqlite::result &res, int idx) {
     std::vector<unsigned char> data;
     res.get_binary(idx, data);
@@ -3,6 +3,7 @@
 #include <sqlite/connection_pool.hpp>
 #include <sqlite/execute.hpp>
 
+#include <algorithm>
 #include <future>
 #include <thread>
 
@@ -38,3 +39,67 @@ TEST(ConnectionPoolTest, ReturnsConnectionAfterSharedAlias) {
     shared.reset();
     EXPECT_EQ(pool.idle_count(), 1u);
 }
+
+TEST(ConnectionPoolTest, AggregatesConnectionStats) {
+    auto factory = sqlite::connection_pool::make_factory(":memory:");
+    sqlite::connection_pool pool(2, factory);
+
+    {
+        auto first  = pool.acquire();
+        auto second = pool.acquire();
+        sqlite::execute(*first, "CREATE TABLE t(x);", true);
+        sqlite::execute(*second, "CREATE TABLE u(y);", true);
+    }
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.capacity, 2u);
+    EXPECT_EQ(stats.created, 2u);
+    EXPECT_EQ(stats.idle, 2u);
+    EXPECT_GT(stats.totals.schema_used, 0);
+
+    auto lease = pool.acquire();
+    auto again = pool.stats();
+    EXPECT_EQ(again.idle, 1u);
+    // The leased connection still contributes the counters captured on its last return.
+    EXPECT_EQ(again.totals.schema_used, stats.totals.schema_used);
+}
+
+TEST(ConnectionPoolTest, StatsCoverConnectionsLeasedBeforeTheFirstPoll) {
+    auto factory = sqlite::connection_pool::make_factory(":memory:");
+    sqlite::connection_pool pool(2, factory);
+
+    sqlite::connection_stats first;
+    sqlite::connection_stats second;
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        sqlite::execute(*a, "CREATE TABLE t(x);", true);
+        sqlite::execute(*b, "CREATE TABLE u(y);", true);
+        first  = a->stats();
+        second = b->stats();
+    }
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.idle, 0u);
+    EXPECT_EQ(stats.totals.schema_used, first.schema_used + second.schema_used);
+    EXPECT_EQ(stats.totals.lookaside_used_highwater,
+              std::max(first.lookaside_used_highwater, second.lookaside_used_highwater));
+}
+
+TEST(ConnectionPoolTest, TryAcquireDoesNotBlock) {
+    auto factory = sqlite::connection_pool::make_factory(":memory:");
+    sqlite::connection_pool pool(1, factory);
+
+    auto first = pool.try_acquire();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(pool.leased_count(), 1u);
+
+    auto second = pool.try_acquire();
+    EXPECT_FALSE(second);
+
+    first  = {};
+    second = pool.try_acquire();
+    EXPECT_TRUE(second);
+}
@@ -0,0 +1,146 @@
+#include "test_common.hpp"
+
+#include <sqlite/command.hpp>
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/coroutine.hpp>
+#include <sqlite/execute.hpp>
+
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+/// Minimal eager coroutine type whose result is observed through a std::future.
+template <typename T> struct future_task {
+    struct promise_type {
+        std::promise<T> result;
+
+        future_task get_return_object() {
+            return {result.get_future()};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_value(T value) {
+            result.set_value(std::move(value));
+        }
+        void unhandled_exception() {
+            result.set_exception(std::current_exception());
+        }
+    };
+
+    std::future<T> future;
+};
+
+future_task<std::int64_t> sum_ids(sqlite::async_context &ctx, sqlite::connection_pool &pool) {
+    auto lease = co_await sqlite::async_acquire(ctx, pool);
+    sqlite::query q(*lease, "SELECT id FROM items ORDER BY id;");
+    sqlite::async_cursor rows(ctx, q);
+    std::int64_t total = 0;
+    while (co_await rows.next_row()) {
+        total += rows->get<std::int64_t>(0);
+    }
+    co_return total;
+}
+
+future_task<std::thread::id> step_and_report_thread(sqlite::async_context &ctx,
+                                                    sqlite::connection &con) {
+    sqlite::command insert(con, "INSERT INTO items(id) VALUES (100);");
+    co_await sqlite::async_step(ctx, insert);
+    co_return std::this_thread::get_id();
+}
+
+future_task<bool> insert_duplicate(sqlite::async_context &ctx, sqlite::connection &con) {
+    sqlite::command insert(con, "INSERT INTO items(id) VALUES (1);");
+    co_return co_await sqlite::async_step(ctx, insert);
+}
+} // namespace
+
+TEST(CoroutineTest, AwaitsLeaseAndIteratesRows) {
+    TempFile db("coroutine_rows");
+    {
+        sqlite::connection con(db.string());
+        sqlite::execute(con, "CREATE TABLE items(id INTEGER PRIMARY KEY);", true);
+        sqlite::execute(con, "INSERT INTO items(id) VALUES (1), (2), (3), (4);", true);
+    }
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    sqlite::async_context ctx(2);
+
+    auto first  = sum_ids(ctx, pool);
+    auto second = sum_ids(ctx, pool);
+    EXPECT_EQ(first.future.get(), 10);
+    EXPECT_EQ(second.future.get(), 10);
+}
+
+TEST(CoroutineTest, LeaseWaitersDoNotStarveLeaseHolders) {
+    TempFile db("coroutine_waiters");
+    {
+        sqlite::connection con(db.string());
+        sqlite::execute(con, "CREATE TABLE items(id INTEGER PRIMARY KEY);", true);
+        sqlite::execute(con, "INSERT INTO items(id) VALUES (1), (2), (3), (4);", true);
+    }
+    // Twelve coroutines contend for two connections on a single database thread; a lease wait
+    // that parked that thread would keep the holders from ever reaching their next row.
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    {
+        sqlite::async_context ctx(1);
+        std::vector<future_task<std::int64_t>> tasks;
+        for (int i = 0; i < 12; ++i) {
+            tasks.push_back(sum_ids(ctx, pool));
+        }
+        for (auto &task : tasks) {
+            ASSERT_EQ(task.future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+            EXPECT_EQ(task.future.get(), 10);
+        }
+    }
+    // Leases are returned when the coroutine frames unwind, just after their results are set.
+    EXPECT_EQ(pool.leased_count(), 0u);
+}
+
+TEST(CoroutineTest, ResumesThroughCallerSuppliedExecutor) {
+    sqlite::connection con(":memory:");
+    sqlite::execute(con, "CREATE TABLE items(id INTEGER PRIMARY KEY);", true);
+
+    std::mutex mutex;
+    std::deque<std::coroutine_handle<>> ready;
+    sqlite::async_context ctx(1, [&](std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.push_back(handle);
+    });
+
+    auto task = step_and_report_thread(ctx, con);
+    while (task.future.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready) {
+        std::coroutine_handle<> next;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ready.empty()) {
+                next = ready.front();
+                ready.pop_front();
+            }
+        }
+        if (next) {
+            next.resume();
+        }
+    }
+    EXPECT_EQ(task.future.get(), std::this_thread::get_id());
+    EXPECT_EQ(count_rows(con, "items"), 1);
+}
+
+TEST(CoroutineTest, RethrowsDatabaseErrors) {
+    sqlite::connection con(":memory:");
+    sqlite::execute(con, "CREATE TABLE items(id INTEGER PRIMARY KEY);", true);
+    sqlite::execute(con, "INSERT INTO items(id) VALUES (1);", true);
+
+    sqlite::async_context ctx(1);
+    auto task = insert_duplicate(ctx, con);
+    EXPECT_THROW(task.future.get(), sqlite::database_exception);
+}
@@ -0,0 +1,98 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/csv_table.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+
+#include <fstream>
+#include <string>
+
+using namespace testhelpers;
+
+namespace {
+void write_file(std::string const &path, std::string const &content) {
+    std::ofstream out(path, std::ios::binary);
+    out << content;
+}
+} // namespace
+
+TEST(CsvTableTest, ScansJoinsAndSeeksByRowidAndKey) {
+    TempFile file("csv_table");
+    write_file(file.string(), "id,customer,note\r\n"
+                              "o1,1,plain\r\n"
+                              "o2,2,\"say \"\"hi\"\"\"\r\n"
+                              "\r\n"
+                              "o3,1,\"multi\nline\"\r\n"
+                              "o4,3,\r\n");
+    sqlite::connection conn(":memory:");
+    sqlite::register_csv_module(conn);
+    sqlite::execute(conn,
+                    "CREATE VIRTUAL TABLE temp.orders USING csv(filename = '" + file.string() +
+                        "', key = 'id');",
+                    true);
+    sqlite::execute(conn, "CREATE TABLE customers(id INTEGER PRIMARY KEY, name TEXT);", true);
+    sqlite::execute(conn, "INSERT INTO customers VALUES(1, 'ada'), (2, 'bob');", true);
+
+    EXPECT_EQ(count_rows(conn, "orders"), 4);
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(o.id || ':' || c.name, ',') FROM orders o "
+                            "JOIN customers c ON c.id = o.customer ORDER BY o.rowid;"),
+              "o1:ada,o2:bob,o3:ada");
+    EXPECT_EQ(text_of(conn, "SELECT note FROM orders WHERE rowid = 2;"), "say \"hi\"");
+    EXPECT_EQ(text_of(conn, "SELECT note FROM orders WHERE id = 'o3';"), "multi\nline");
+    EXPECT_EQ(count_rows(conn, "orders WHERE id = 'missing'"), 0);
+    EXPECT_EQ(count_rows(conn, "orders WHERE note IS NULL"), 1);
+    EXPECT_EQ(text_of(conn, "SELECT rowid FROM orders WHERE id = 'o4';"), "4");
+
+    sqlite::query plan(conn, "EXPLAIN QUERY PLAN SELECT * FROM orders WHERE id = ?;");
+    plan % std::string("o1");
+    auto res = plan.get_result();
+    ASSERT_TRUE(res->next_row());
+    EXPECT_NE(res->get<std::string>(3).find("VIRTUAL TABLE INDEX 2"), std::string::npos);
+}
+
+TEST(CsvTableTest, KeyLookupsAgreeWithFullScans) {
+    TempFile file("csv_table_key");
+    write_file(file.string(), "id,name\n42,answer\nAbc,letters\n");
+    sqlite::connection conn(":memory:");
+    sqlite::register_csv_module(conn);
+    sqlite::execute(conn,
+                    "CREATE VIRTUAL TABLE temp.items USING csv(filename = '" + file.string() +
+                        "', key = 'id');",
+                    true);
+
+    // Columns have no affinity, so the text "42" never equals the integer 42.
+    EXPECT_EQ(count_rows(conn, "items WHERE id = 42"), count_rows(conn, "items WHERE +id = 42"));
+    EXPECT_EQ(count_rows(conn, "items WHERE id = 42"), 0);
+    EXPECT_EQ(count_rows(conn, "items WHERE id = '42'"), 1);
+    EXPECT_EQ(count_rows(conn, "items WHERE id = 'abc' COLLATE NOCASE"), 1);
+}
+
+TEST(CsvTableTest, HeaderlessWithCustomDelimiter) {
+    TempFile file("csv_table_plain");
+    write_file(file.string(), "1;x;10\n2;y\n3;z;30");
+    sqlite::connection conn(":memory:");
+    sqlite::register_csv_module(conn);
+    sqlite::execute(conn,
+                    "CREATE VIRTUAL TABLE temp.t USING csv(filename = '" + file.string() +
+                        "', header = no, delimiter = ';');",
+                    true);
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(c1 || c2, ',') FROM t;"), "1x,2y,3z");
+    EXPECT_EQ(text_of(conn, "SELECT sum(c3) FROM t;"), "40");
+    EXPECT_EQ(count_rows(conn, "t WHERE c3 IS NULL"), 1);
+}
+
+TEST(CsvTableTest, RejectsBadArguments) {
+    TempFile file("csv_table_args");
+    write_file(file.string(), "a,b\n1,2\n");
+    sqlite::connection conn(":memory:");
+    sqlite::register_csv_module(conn);
+    EXPECT_THROW(
+        sqlite::execute(conn, "CREATE VIRTUAL TABLE temp.t USING csv(header = yes);", true),
+        sqlite::database_exception);
+    EXPECT_THROW(sqlite::execute(conn,
+                                 "CREATE VIRTUAL TABLE temp.t USING csv(filename = '" +
+                                     file.string() + "', key = 'missing');",
+                                 true),
+                 sqlite::database_exception);
+}
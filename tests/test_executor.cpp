@@ -0,0 +1,90 @@
+#include "test_common.hpp"
+
+#include <sqlite/command.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/executor.hpp>
+
+#include <future>
+
+using namespace testhelpers;
+
+namespace {
+void seed(std::string const &path) {
+    sqlite::connection con(path);
+    sqlite::execute(con, "CREATE TABLE items(id INTEGER PRIMARY KEY, name TEXT);", true);
+    sqlite::command insert(con, "INSERT INTO items(name) VALUES (?);");
+    for (auto name : {"alpha", "beta", "gamma"}) {
+        insert % std::string(name);
+        insert.step_once();
+        insert.clear();
+    }
+}
+} // namespace
+
+TEST(ExecutorTest, SubmitMaterializesRows) {
+    TempFile db("executor_submit");
+    seed(db.string());
+    sqlite::executor exec(2, sqlite::connection_pool::make_factory(db.string()));
+
+    std::string prefix = "%a";
+    auto rows = exec.submit("SELECT id, name FROM items WHERE name LIKE ? AND id > ? ORDER BY id;",
+                            prefix.c_str(), 1)
+                    .get();
+    ASSERT_EQ(rows.columns.size(), 2u);
+    EXPECT_EQ(rows.columns[1], "name");
+    ASSERT_EQ(rows.rows.size(), 2u);
+    EXPECT_EQ(std::get<int>(rows.rows[0][0]), 2);
+    EXPECT_EQ(std::get<std::string>(rows.rows[1][1]), "gamma");
+}
+
+TEST(ExecutorTest, PostAndCallbackReportResultsAndErrors) {
+    TempFile db("executor_post");
+    seed(db.string());
+    sqlite::executor exec(1, sqlite::connection_pool::make_factory(db.string()));
+
+    auto count = exec.post([](sqlite::connection &con) { return count_rows(con, "items"); });
+    EXPECT_EQ(count.get(), 3);
+
+    auto failing = exec.submit("SELECT * FROM missing_table;");
+    EXPECT_THROW(failing.get(), sqlite::database_exception);
+
+    std::promise<std::size_t> delivered;
+    exec.submit_callback(
+        [&delivered](sqlite::materialized_rows rows, std::exception_ptr error) {
+            delivered.set_value(error ? 0 : rows.rows.size());
+        },
+        "SELECT name FROM items;");
+    EXPECT_EQ(delivered.get_future().get(), 3u);
+}
+
+TEST(ExecutorTest, IdleWorkerStealsQueuedJobs) {
+    TempFile db("executor_steal");
+    seed(db.string());
+    sqlite::executor exec(2, sqlite::connection_pool::make_factory(db.string()));
+
+    std::promise<void> release_first;
+    std::promise<void> release_second;
+    auto first_gate  = release_first.get_future().share();
+    auto second_gate = release_second.get_future().share();
+    auto first  = exec.post([first_gate](sqlite::connection &) { first_gate.wait(); });
+    auto second = exec.post([second_gate](sqlite::connection &) { second_gate.wait(); });
+
+    std::vector<std::future<int>> quick;
+    for (int i = 0; i < 4; ++i) {
+        quick.push_back(
+            exec.post([](sqlite::connection &con) { return count_rows(con, "items"); }));
+    }
+    EXPECT_EQ(exec.pending(), 6u);
+
+    // Only one blocker is released; its worker has to steal the jobs queued behind the other.
+    release_first.set_value();
+    for (auto &f : quick) {
+        EXPECT_EQ(f.get(), 3);
+    }
+    EXPECT_GT(exec.steal_count(), 0u);
+
+    release_second.set_value();
+    first.get();
+    second.get();
+}
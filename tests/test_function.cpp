@@ -4,9 +4,27 @@
 #include <sqlite/connection.hpp>
 #include <sqlite/execute.hpp>
 #include <sqlite/function.hpp>
+#include <sqlite/query.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 using namespace testhelpers;
 
+namespace {
+struct mean_state {
+    static inline int live = 0;
+    double sum        = 0.0;
+    std::int64_t rows = 0;
+
+    mean_state() { ++live; }
+    mean_state(mean_state const &) = delete;
+    ~mean_state() { --live; }
+};
+} // namespace
+
 TEST(FunctionTest, RegistersScalarFunction) {
     sqlite::connection conn(":memory:");
     sqlite::create_function(conn, "double_int", [](int value) { return value * 2; },
@@ -29,3 +47,63 @@ TEST(FunctionTest, OptionalAndBlobArguments) {
     insert % data;
     EXPECT_TRUE(insert.step_once());
 }
+
+TEST(FunctionTest, AggregateKeepsStateInAggregateContext) {
+    sqlite::connection conn(":memory:");
+    sqlite::create_aggregate<mean_state>(
+        conn, "mean",
+        [](mean_state &state, std::optional<double> value) {
+            if (!value) {
+                return;
+            }
+            if (*value < 0) {
+                throw std::runtime_error("negative input");
+            }
+            state.sum += *value;
+            ++state.rows;
+        },
+        [](mean_state &state) -> std::optional<double> {
+            if (state.rows == 0) {
+                return std::nullopt;
+            }
+            return state.sum / static_cast<double>(state.rows);
+        });
+    sqlite::execute(conn, "CREATE TABLE samples(grp TEXT, value REAL);", true);
+    sqlite::execute(conn,
+                    "INSERT INTO samples VALUES('a', 1), ('a', 2), ('a', NULL), ('b', 10), "
+                    "('b', 20), ('b', 30);",
+                    true);
+
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(grp || '=' || m, ',') FROM (SELECT grp, "
+                            "mean(value) AS m FROM samples GROUP BY grp ORDER BY grp);"),
+              "a=1.5,b=20.0");
+    EXPECT_EQ(text_of(conn, "SELECT coalesce(mean(value), 'none') FROM samples WHERE 0;"), "none");
+    EXPECT_EQ(mean_state::live, 0);
+
+    sqlite::execute(conn, "INSERT INTO samples VALUES('c', -1);", true);
+    EXPECT_THROW(text_of(conn, "SELECT mean(value) FROM samples;"), sqlite::database_exception);
+    EXPECT_EQ(mean_state::live, 0);
+}
+
+TEST(FunctionTest, WindowFunctionUsesValueAndInverse) {
+    struct window_sum {
+        std::int64_t total = 0;
+    };
+    sqlite::connection conn(":memory:");
+    sqlite::create_window_function<window_sum>(
+        conn, "wsum", [](window_sum &state, std::int64_t value) { state.total += value; },
+        [](window_sum &state) { return state.total; },
+        [](window_sum &state) { return state.total; },
+        [](window_sum &state, std::int64_t value) { state.total -= value; });
+    sqlite::execute(conn, "CREATE TABLE t(x INTEGER);", true);
+    sqlite::execute(conn, "INSERT INTO t VALUES(1), (2), (3), (4);", true);
+
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(s, ',') FROM (SELECT wsum(x) OVER (ORDER BY x "
+                            "ROWS BETWEEN 1 PRECEDING AND CURRENT ROW) AS s FROM t);"),
+              "1,3,5,7");
+    EXPECT_EQ(text_of(conn, "SELECT wsum(x) FROM t;"), "10");
+    EXPECT_THROW(sqlite::create_aggregate<window_sum>(
+                     conn, "bad", [](window_sum &, std::int64_t) {},
+                     [](window_sum &state) { return state.total; }, {.arity = 2}),
+                 sqlite::database_exception);
+}
@@ -0,0 +1,114 @@
+#include "test_common.hpp"
+
+#include <sqlite/command.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/maintenance.hpp>
+#include <sqlite/snapshot.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <thread>
+
+using namespace testhelpers;
+
+namespace {
+int pragma_int(sqlite::connection &con, std::string const &pragma) {
+    sqlite::query q(con, "PRAGMA " + pragma + ";");
+    auto res = q.get_result();
+    EXPECT_TRUE(res->next_row());
+    return res->get<int>(0);
+}
+
+void create_fragmented_table(sqlite::connection &con) {
+    sqlite::execute(con, "PRAGMA auto_vacuum = INCREMENTAL;", true);
+    sqlite::execute(con, "CREATE TABLE blobs(id INTEGER PRIMARY KEY, body BLOB);", true);
+    sqlite::transaction txn(con, sqlite::transaction_type::immediate);
+    sqlite::command insert(con, "INSERT INTO blobs(body) VALUES (zeroblob(8192));");
+    for (int i = 0; i < 64; ++i) {
+        insert.step_once();
+        insert.reset_statement();
+    }
+    txn.commit();
+    sqlite::execute(con, "DELETE FROM blobs;", true);
+}
+
+sqlite::maintenance_options manual_only() {
+    return {.poll_interval = std::chrono::hours(1), .task_budget = std::chrono::seconds(5)};
+}
+} // namespace
+
+TEST(MaintenanceTest, IncrementalVacuumReleasesFreePages) {
+    TempFile db("maintenance_vacuum");
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    {
+        auto lease = pool.acquire();
+        create_fragmented_table(*lease);
+        ASSERT_GT(pragma_int(*lease, "freelist_count"), 0);
+    }
+
+    sqlite::maintenance_scheduler scheduler(pool, manual_only());
+    EXPECT_TRUE(scheduler.run_now(sqlite::maintenance_task::incremental_vacuum));
+
+    auto lease = pool.acquire();
+    EXPECT_EQ(pragma_int(*lease, "freelist_count"), 0);
+    auto stats = scheduler.stats();
+    EXPECT_EQ(stats.vacuum_runs, 1u);
+    EXPECT_GT(stats.pages_vacuumed, 0u);
+}
+
+TEST(MaintenanceTest, SkipsWhenWriterHoldsLock) {
+    TempFile db("maintenance_busy");
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    {
+        auto lease = pool.acquire();
+        create_fragmented_table(*lease);
+    }
+
+    sqlite::connection writer(db.string());
+    sqlite::transaction hold(writer, sqlite::transaction_type::immediate);
+
+    sqlite::maintenance_scheduler scheduler(pool, manual_only());
+    EXPECT_FALSE(scheduler.run_now(sqlite::maintenance_task::incremental_vacuum));
+    EXPECT_EQ(scheduler.stats().skipped_busy, 1u);
+    hold.rollback();
+}
+
+TEST(MaintenanceTest, OptimizeRestoresConnectionSettings) {
+    TempFile db("maintenance_optimize");
+    sqlite::connection_pool pool(1, sqlite::connection_pool::make_factory(db.string()));
+    {
+        auto lease = pool.acquire();
+        sqlite::execute(*lease, "CREATE TABLE t(a INTEGER, b TEXT);", true);
+        sqlite::execute(*lease, "CREATE INDEX t_a ON t(a);", true);
+        sqlite::execute(*lease, "PRAGMA busy_timeout = 250;", true);
+    }
+
+    sqlite::maintenance_scheduler scheduler(pool, manual_only());
+    EXPECT_TRUE(scheduler.run_now(sqlite::maintenance_task::optimize));
+
+    auto lease = pool.acquire();
+    EXPECT_EQ(pragma_int(*lease, "busy_timeout"), 250);
+    EXPECT_EQ(pragma_int(*lease, "analysis_limit"), 0);
+}
+
+TEST(MaintenanceTest, RunsCheckpointDuringIdleWindow) {
+    TempFile db("maintenance_idle");
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    {
+        auto lease = pool.acquire();
+        sqlite::enable_wal(*lease);
+        sqlite::execute(*lease, "CREATE TABLE t(a INTEGER);", true);
+    }
+
+    sqlite::maintenance_scheduler scheduler(
+        pool, {.poll_interval = std::chrono::milliseconds(5),
+               .idle_window   = std::chrono::milliseconds(20),
+               .optimize      = false});
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (scheduler.stats().checkpoint_runs == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_GT(scheduler.stats().checkpoint_runs, 0u);
+    EXPECT_EQ(scheduler.stats().failures, 0u);
+}
@@ -0,0 +1,140 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/materialized_view.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query.hpp>
+
+#include <sqlite3.h>
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+
+using namespace testhelpers;
+
+namespace {
+using totals_map = std::map<std::string, std::tuple<std::int64_t, std::int64_t, std::int64_t>>;
+
+totals_map read_totals(sqlite::connection &conn, std::string const &sql) {
+    totals_map out;
+    sqlite::query q(conn, sql);
+    for (auto [region, orders, amount, rows] :
+         q.rows<std::string, std::int64_t, std::int64_t, std::int64_t>()) {
+        out[region] = {orders, amount, rows};
+    }
+    return out;
+}
+
+void create_sales(sqlite::connection &conn) {
+    sqlite::execute(conn, "CREATE TABLE sales(id INTEGER PRIMARY KEY, region TEXT, amount INTEGER);",
+                    true);
+    sqlite::execute(conn,
+                    "INSERT INTO sales(region, amount) VALUES('east', 10), ('east', 5), "
+                    "('west', 7), ('west', NULL);",
+                    true);
+}
+
+constexpr char const *expected_sql =
+    "SELECT region, COUNT(amount), COALESCE(SUM(amount), 0), COUNT(*) FROM sales GROUP BY region;";
+constexpr char const *view_sql =
+    "SELECT region, orders, amount, __rows FROM sales_by_region ORDER BY region;";
+} // namespace
+
+TEST(MaterializedViewTest, TriggersMaintainAggregates) {
+    sqlite::connection conn(":memory:");
+    create_sales(conn);
+    auto view = sqlite::materialized_view::create(
+        conn, "sales_by_region",
+        sqlite::aggregate_view_definition{
+            .source     = "sales",
+            .group_by   = {"region"},
+            .aggregates = {{sqlite::aggregate_kind::count, "amount", "orders"},
+                           {sqlite::aggregate_kind::sum, "amount", "amount"}}});
+    EXPECT_TRUE(view.incremental());
+    EXPECT_EQ(read_totals(conn, view_sql), read_totals(conn, expected_sql));
+
+    sqlite::execute(conn, "INSERT INTO sales(region, amount) VALUES('north', 3), ('east', 1);", true);
+    sqlite::execute(conn, "UPDATE sales SET region = 'north' WHERE region = 'west';", true);
+    sqlite::execute(conn, "UPDATE sales SET amount = amount * 2 WHERE region = 'east';", true);
+    sqlite::execute(conn, "DELETE FROM sales WHERE id = 1;", true);
+    auto totals = read_totals(conn, view_sql);
+    EXPECT_EQ(totals, read_totals(conn, expected_sql));
+    EXPECT_EQ(totals.count("west"), 0u);
+    EXPECT_FALSE(view.staleness().stale);
+
+    sqlite::execute(conn, "INSERT INTO sales(region, amount) VALUES(NULL, 4), (NULL, 6);", true);
+    sqlite::query nulls(conn, "SELECT amount FROM sales_by_region WHERE region IS NULL;");
+    for (auto amount : nulls.rows<std::int64_t>()) {
+        EXPECT_EQ(amount, 10);
+    }
+}
+
+TEST(MaterializedViewTest, QueryViewsTrackStalenessUntilRefresh) {
+    TempFile db("materialized_view");
+    {
+        sqlite::connection conn(db.string());
+        create_sales(conn);
+        auto view = sqlite::materialized_view::create(
+            conn, "big_sales", "SELECT id, amount FROM sales WHERE amount > 6;");
+        EXPECT_FALSE(view.incremental());
+        EXPECT_FALSE(view.staleness().stale);
+        EXPECT_EQ(count_rows(conn, "big_sales"), 2);
+    }
+
+    sqlite::connection other(db.string());
+    sqlite::execute(other, "INSERT INTO sales(region, amount) VALUES('south', 9), ('south', 1);",
+                    true);
+
+    sqlite::connection conn(db.string());
+    sqlite::materialized_view view(conn, "big_sales");
+    auto stale = view.staleness();
+    EXPECT_TRUE(stale.stale);
+    EXPECT_EQ(stale.pending_changes, 2);
+    EXPECT_EQ(count_rows(conn, "big_sales"), 2);
+
+    view.refresh();
+    EXPECT_FALSE(view.staleness().stale);
+    EXPECT_EQ(count_rows(conn, "big_sales"), 3);
+
+    view.drop();
+    EXPECT_THROW(sqlite::materialized_view(conn, "big_sales"), sqlite::database_exception);
+    sqlite::execute(conn, "INSERT INTO sales(region, amount) VALUES('south', 9);", true);
+}
+
+TEST(MaterializedViewTest, FindsSourcesWithoutReplacingTheAuthorizer) {
+    sqlite::connection conn(":memory:");
+    create_sales(conn);
+    sqlite::execute(conn, "CREATE TABLE regions(name TEXT PRIMARY KEY, manager TEXT);", true);
+    sqlite::execute(conn, "CREATE TABLE secret(value TEXT);", true);
+    sqlite::execute(conn, "INSERT INTO regions VALUES('east', 'ann'), ('west', 'bo');", true);
+    auto deny_secret = [](void *, int action, char const *table, char const *, char const *,
+                          char const *) {
+        bool secret = action == SQLITE_READ && table && std::strcmp(table, "secret") == 0;
+        return secret ? SQLITE_DENY : SQLITE_OK;
+    };
+    sqlite3_set_authorizer(sqlite::private_accessor::get_handle(conn), deny_secret, nullptr);
+
+    // regions is only reached through its primary key index.
+    auto view = sqlite::materialized_view::create(
+        conn, "managed_sales",
+        "SELECT s.id FROM sales s WHERE s.region IN (SELECT name FROM regions);");
+    EXPECT_EQ(count_rows(conn, "managed_sales"), 4);
+    sqlite::execute(conn, "DELETE FROM regions WHERE name = 'west';", true);
+    EXPECT_EQ(view.staleness().pending_changes, 1);
+
+    EXPECT_THROW(count_rows(conn, "secret"), sqlite::database_exception);
+}
+
+TEST(MaterializedViewTest, RejectsInvalidDefinitions) {
+    sqlite::connection conn(":memory:");
+    create_sales(conn);
+    EXPECT_THROW(sqlite::materialized_view::create(conn, "bad", sqlite::aggregate_view_definition{
+                                                                    .source = "sales"}),
+                 sqlite::database_exception);
+    EXPECT_THROW(sqlite::materialized_view::create(conn, "bad", "DELETE FROM sales"),
+                 sqlite::database_exception);
+    EXPECT_EQ(count_rows(conn, "sales"), 4);
+}
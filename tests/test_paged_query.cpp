@@ -0,0 +1,106 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/paged_query.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+void seed_events(sqlite::connection &conn) {
+    sqlite::execute(conn,
+                    "CREATE TABLE events(id INTEGER PRIMARY KEY, day TEXT NOT NULL, seq INTEGER "
+                    "NOT NULL, tenant INTEGER, UNIQUE(day, seq));",
+                    true);
+    sqlite::transaction tx(conn);
+    sqlite::execute insert(conn, "INSERT INTO events(day, seq, tenant) VALUES(?, ?, ?);");
+    for (int i = 0; i < 25; ++i) {
+        insert % (i % 2 ? std::string("2024-01-02") : std::string("2024-01-01")) % i % (i % 3);
+        insert();
+        insert.clear();
+    }
+    tx.commit();
+}
+
+std::vector<std::int64_t> read_page(sqlite::paged_query &pages) {
+    std::vector<std::int64_t> ids;
+    for (auto row : pages.next()) {
+        ids.push_back(row.get<std::int64_t>(0));
+    }
+    return ids;
+}
+} // namespace
+
+TEST(PagedQueryTest, WalksSingleKeyInFixedPages) {
+    sqlite::connection conn(":memory:");
+    seed_events(conn);
+    sqlite::paged_query pages(conn, "SELECT id, day FROM events;", {"id"}, {.page_size = 10});
+
+    std::vector<std::int64_t> all;
+    std::size_t page_count = 0;
+    while (!pages.done()) {
+        auto ids = read_page(pages);
+        all.insert(all.end(), ids.begin(), ids.end());
+        ++page_count;
+    }
+    EXPECT_EQ(page_count, 3u);
+    ASSERT_EQ(all.size(), 25u);
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        EXPECT_EQ(all[i], static_cast<std::int64_t>(i + 1));
+    }
+}
+
+TEST(PagedQueryTest, CompositeKeysBaseParametersAndDescendingOrder) {
+    sqlite::connection conn(":memory:");
+    seed_events(conn);
+    sqlite::paged_query pages(conn, "SELECT seq, day FROM events WHERE tenant <> ?",
+                              {"day", "seq"}, {.page_size = 4, .descending = true});
+    pages.bind(0);
+
+    std::vector<std::int64_t> seqs;
+    while (!pages.done()) {
+        for (auto row : pages.next()) {
+            auto [seq, day] = row.as<std::int64_t, std::string>();
+            EXPECT_FALSE(day.empty());
+            seqs.push_back(seq);
+        }
+    }
+    std::vector<std::int64_t> expected;
+    for (int seq : {23, 19, 17, 13, 11, 7, 5, 1, 22, 20, 16, 14, 10, 8, 4, 2}) {
+        expected.push_back(seq);
+    }
+    EXPECT_EQ(seqs, expected);
+}
+
+TEST(PagedQueryTest, TokensResumeAfterLastRowRead) {
+    sqlite::connection conn(":memory:");
+    seed_events(conn);
+    sqlite::paged_query pages(conn, "SELECT id FROM events", {"id"}, {.page_size = 10});
+    EXPECT_TRUE(pages.token().empty());
+
+    auto page = pages.next();
+    auto it   = page.begin();
+    ++it;
+    ++it;
+    EXPECT_EQ((*it).get<std::int64_t>(0), 3);
+    auto token = pages.token();
+    EXPECT_FALSE(token.empty());
+
+    sqlite::paged_query resumed(conn, "SELECT id FROM events", {"id"}, {.page_size = 10});
+    resumed.resume(token);
+    auto ids = read_page(resumed);
+    ASSERT_FALSE(ids.empty());
+    EXPECT_EQ(ids.front(), 4);
+
+    sqlite::paged_query other(conn, "SELECT id FROM events", {"id"}, {.page_size = 5,
+                                                                      .descending = true});
+    EXPECT_THROW(other.resume(token), sqlite::database_exception);
+    EXPECT_THROW(resumed.resume("k1zz"), sqlite::database_exception);
+
+    resumed.rewind();
+    EXPECT_EQ(read_page(resumed).front(), 1);
+}
@@ -0,0 +1,150 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/parallel_scan.hpp>
+#include <sqlite/snapshot.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <cstdint>
+#include <set>
+#include <thread>
+
+using namespace testhelpers;
+
+namespace {
+void seed_numbers(sqlite::connection &conn, std::int64_t first, std::int64_t last) {
+    sqlite::transaction tx(conn);
+    sqlite::execute insert(conn, "INSERT INTO numbers(id, value) VALUES(?, ?);");
+    for (std::int64_t i = first; i <= last; ++i) {
+        insert % i % (i * 2);
+        insert();
+        insert.clear();
+    }
+    tx.commit();
+}
+
+std::int64_t sum_values(sqlite::query &q, sqlite::scan_partition const &) {
+    std::int64_t sum = 0;
+    for (auto value : q.rows<std::int64_t>()) {
+        sum += value;
+    }
+    return sum;
+}
+} // namespace
+
+TEST(ParallelScanTest, PlansUniformRanges) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE numbers(id INTEGER PRIMARY KEY, value INTEGER);", true);
+    EXPECT_TRUE(sqlite::plan_partitions(conn, "numbers", "id", 4).empty());
+
+    seed_numbers(conn, 1, 100);
+    auto parts = sqlite::plan_partitions(conn, "numbers", "id", 4);
+    ASSERT_EQ(parts.size(), 4u);
+    EXPECT_EQ(parts.front().lower, 1);
+    EXPECT_EQ(parts.back().upper, 100);
+    for (std::size_t i = 1; i < parts.size(); ++i) {
+        EXPECT_EQ(parts[i].lower, parts[i - 1].upper + 1);
+        EXPECT_EQ(parts[i].index, i);
+    }
+
+    auto few = sqlite::plan_partitions(conn, "numbers", "id", 500);
+    EXPECT_EQ(few.size(), 100u);
+}
+
+TEST(ParallelScanTest, UniformRangesStayInsideTheKeyRange) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE numbers(id INTEGER PRIMARY KEY, value INTEGER);", true);
+    auto check = [&](std::size_t wanted, std::size_t expected, std::int64_t low,
+                     std::int64_t high) {
+        auto parts = sqlite::plan_partitions(conn, "numbers", "id", wanted);
+        ASSERT_EQ(parts.size(), expected);
+        EXPECT_EQ(parts.front().lower, low);
+        EXPECT_EQ(parts.back().upper, high);
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            EXPECT_LE(parts[i].lower, parts[i].upper);
+            if (i > 0) {
+                EXPECT_EQ(parts[i].lower, parts[i - 1].upper + 1);
+            }
+        }
+    };
+
+    seed_numbers(conn, 1, 8);
+    check(6, 6, 1, 8);
+
+    sqlite::execute(conn, "DELETE FROM numbers;", true);
+    sqlite::execute(conn,
+                    "INSERT INTO numbers(id) VALUES(-9223372036854775807 - 1), "
+                    "(9223372036854775807);",
+                    true);
+    check(7, 7, INT64_MIN, INT64_MAX);
+}
+
+TEST(ParallelScanTest, QuantilesFollowSkewedKeys) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE numbers(id INTEGER PRIMARY KEY, value INTEGER);", true);
+    seed_numbers(conn, 1, 90);
+    seed_numbers(conn, 1000000, 1000009);
+
+    auto parts = sqlite::plan_partitions(conn, "numbers", "id", 4,
+                                         sqlite::partition_strategy::quantiles);
+    ASSERT_EQ(parts.size(), 4u);
+    // Uniform ranges would leave three partitions nearly empty; quantiles split the dense run.
+    EXPECT_LT(parts[2].upper, 1000000);
+    EXPECT_EQ(parts.back().upper, 1000009);
+}
+
+TEST(ParallelScanTest, ReducesPartitionsAcrossPooledReaders) {
+    TempFile db("parallel_scan");
+    {
+        sqlite::connection conn(db.string());
+        sqlite::enable_wal(conn);
+        sqlite::execute(conn, "CREATE TABLE numbers(id INTEGER PRIMARY KEY, value INTEGER);",
+                        true);
+        seed_numbers(conn, 1, 5000);
+    }
+
+    sqlite::connection_pool pool(4, sqlite::connection_pool::make_factory(db.string()));
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    auto total = sqlite::parallel_scan(
+        pool, "numbers", "id",
+        [&](sqlite::query &q, sqlite::scan_partition const &part) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            return sum_values(q, part);
+        },
+        [](std::int64_t acc, std::int64_t part) { return acc + part; }, std::int64_t{0},
+        {.columns = "value"});
+    EXPECT_EQ(total, 5000LL * 5001LL);
+    EXPECT_GT(threads.size(), 1u);
+    EXPECT_EQ(pool.leased_count(), 0u);
+
+    auto filtered = sqlite::parallel_scan(
+        pool, "numbers", "id", sum_values,
+        [](std::int64_t acc, std::int64_t part) { return acc + part; }, std::int64_t{0},
+        {.partitions = 2, .columns = "value", .where = "id % 2 = 0"});
+    EXPECT_EQ(filtered, 2LL * (2LL * 2500LL * 2501LL / 2LL));
+}
+
+TEST(ParallelScanTest, RequireSnapshotFailsWithoutWal) {
+    TempFile db("parallel_scan_rollback");
+    {
+        sqlite::connection conn(db.string());
+        sqlite::execute(conn, "CREATE TABLE numbers(id INTEGER PRIMARY KEY, value INTEGER);",
+                        true);
+        seed_numbers(conn, 1, 10);
+    }
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    auto reduce = [](std::int64_t acc, std::int64_t part) { return acc + part; };
+    EXPECT_THROW(sqlite::parallel_scan(pool, "numbers", "id", sum_values, reduce, std::int64_t{0},
+                                       {.columns = "value", .require_snapshot = true}),
+                 sqlite::database_exception);
+    EXPECT_EQ(pool.leased_count(), 0u);
+    EXPECT_EQ(sqlite::parallel_scan(pool, "numbers", "id", sum_values, reduce, std::int64_t{0},
+                                    {.columns = "value"}),
+              110);
+}
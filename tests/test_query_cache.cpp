@@ -0,0 +1,189 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/function.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/query_cache.hpp>
+#include <sqlite/transaction.hpp>
+#include <sqlite/virtual_table.hpp>
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+struct reading {
+    std::int64_t id;
+    double value;
+};
+VSQLITE_FIELDS(reading, "readings", id, value)
+
+void create_tables(sqlite::connection &conn) {
+    sqlite::execute(conn, "CREATE TABLE items(id INTEGER PRIMARY KEY, name TEXT);", true);
+    sqlite::execute(conn, "CREATE TABLE other(id INTEGER PRIMARY KEY);", true);
+    sqlite::execute(conn, "INSERT INTO items(name) VALUES('a'), ('b'), ('c');", true);
+}
+} // namespace
+
+TEST(QueryCacheTest, HitsByStatementAndParameters) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::query_cache cache(conn);
+
+    auto first = cache.fetch("SELECT name FROM items WHERE id > ? ORDER BY id;", 1);
+    auto again = cache.fetch("SELECT name FROM items WHERE id > ? ORDER BY id;", 1);
+    auto other = cache.fetch("SELECT name FROM items WHERE id > ? ORDER BY id;", 2);
+    EXPECT_EQ(first, again);
+    EXPECT_NE(first, other);
+    ASSERT_EQ(first->size(), 2u);
+    EXPECT_EQ(first->at(0, 0).as_text(), "b");
+    EXPECT_EQ(other->size(), 1u);
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_GT(stats.memory_usage, 0u);
+
+    EXPECT_THROW(cache.fetch("DELETE FROM items;"), sqlite::database_exception);
+}
+
+TEST(QueryCacheTest, LocalCommitsInvalidateOnlyDependentTables) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::query_cache cache(conn);
+
+    auto count = cache.fetch("SELECT COUNT(*) FROM items;");
+    auto other = cache.fetch("SELECT COUNT(*) FROM other;");
+    sqlite::execute(conn, "INSERT INTO items(name) VALUES('d');", true);
+
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM other;"), other);
+    auto fresh = cache.fetch("SELECT COUNT(*) FROM items;");
+    EXPECT_NE(fresh, count);
+    EXPECT_EQ(fresh->at(0, 0).as_int64(), 4);
+    EXPECT_EQ(cache.stats().invalidations, 1u);
+
+    cache.invalidate("OTHER");
+    EXPECT_EQ(cache.stats().entries, 1u);
+}
+
+TEST(QueryCacheTest, DropsEverythingOnDeletesTheUpdateHookMisses) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::query_cache cache(conn);
+
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM items;")->at(0, 0).as_int64(), 3);
+    // DELETE without WHERE truncates the table without an update hook call.
+    sqlite::execute(conn, "DELETE FROM items;", true);
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM items;")->at(0, 0).as_int64(), 0);
+    EXPECT_EQ(cache.stats().invalidations, 1u);
+}
+
+TEST(QueryCacheTest, KeepsTheApplicationAuthorizer) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    auto deny_other = [](void *, int action, char const *table, char const *, char const *,
+                         char const *) {
+        bool other = action == SQLITE_READ && table && std::strcmp(table, "other") == 0;
+        return other ? SQLITE_DENY : SQLITE_OK;
+    };
+    sqlite3_set_authorizer(sqlite::private_accessor::get_handle(conn), deny_other, nullptr);
+    sqlite::query_cache cache(conn);
+    sqlite::query_cache second(conn);
+
+    cache.fetch("SELECT COUNT(*) FROM items;");
+    second.fetch("SELECT COUNT(*) FROM items;");
+    EXPECT_THROW(cache.fetch("SELECT COUNT(*) FROM other;"), sqlite::database_exception);
+    EXPECT_THROW(second.fetch("SELECT COUNT(*) FROM other;"), sqlite::database_exception);
+
+    sqlite::execute(conn, "INSERT INTO items(name) VALUES('d');", true);
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM items;")->at(0, 0).as_int64(), 4);
+    EXPECT_EQ(second.fetch("SELECT COUNT(*) FROM items;")->at(0, 0).as_int64(), 4);
+    EXPECT_EQ(cache.stats().invalidations, 1u);
+    EXPECT_EQ(second.stats().invalidations, 1u);
+}
+
+TEST(QueryCacheTest, NeverCachesVirtualTableReads) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    std::vector<reading> readings{{1, 0.5}};
+    sqlite::create_vector_table(conn, "readings", readings);
+    sqlite::query_cache cache(conn);
+
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM readings;")->at(0, 0).as_int64(), 1);
+    readings.push_back({2, 1.5});
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM readings;")->at(0, 0).as_int64(), 2);
+    EXPECT_EQ(cache.stats().bypassed, 2u);
+    EXPECT_EQ(cache.stats().entries, 0u);
+}
+
+TEST(QueryCacheTest, DropsResultsInvalidatedWhileRunning) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::query_cache cache(conn);
+    // Stands in for a commit on another thread landing while the query runs.
+    sqlite::create_function(conn, "invalidate_items", [&cache] {
+        cache.invalidate("items");
+        return 1;
+    });
+
+    cache.fetch("SELECT COUNT(*), invalidate_items() FROM items;");
+    EXPECT_EQ(cache.stats().entries, 0u);
+    cache.fetch("SELECT COUNT(*) FROM items;");
+    EXPECT_EQ(cache.stats().entries, 1u);
+}
+
+TEST(QueryCacheTest, BypassesUncommittedChanges) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::query_cache cache(conn);
+    auto before = cache.fetch("SELECT COUNT(*) FROM items;");
+
+    {
+        sqlite::transaction tx(conn);
+        sqlite::execute(conn, "DELETE FROM items WHERE id = 1;", true);
+        auto inside = cache.fetch("SELECT COUNT(*) FROM items;");
+        EXPECT_EQ(inside->at(0, 0).as_int64(), 2);
+        EXPECT_EQ(cache.stats().bypassed, 1u);
+        tx.rollback();
+    }
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM items;"), before);
+    EXPECT_EQ(before->at(0, 0).as_int64(), 3);
+}
+
+TEST(QueryCacheTest, DataVersionCatchesOtherConnections) {
+    TempFile db("query_cache_external");
+    sqlite::connection conn(db.string());
+    create_tables(conn);
+    sqlite::connection writer(db.string());
+    sqlite::query_cache cache(conn);
+
+    auto before = cache.fetch("SELECT COUNT(*) FROM items;");
+    EXPECT_EQ(cache.fetch("SELECT COUNT(*) FROM items;"), before);
+    sqlite::execute(writer, "INSERT INTO items(name) VALUES('e');", true);
+    auto after = cache.fetch("SELECT COUNT(*) FROM items;");
+    EXPECT_NE(after, before);
+    EXPECT_EQ(after->at(0, 0).as_int64(), 4);
+}
+
+TEST(QueryCacheTest, EvictsLeastRecentlyUsedEntries) {
+    sqlite::connection conn(":memory:");
+    create_tables(conn);
+    sqlite::query_cache cache(conn, {.max_entries = 2});
+
+    auto one = cache.fetch("SELECT name FROM items WHERE id = ?;", 1);
+    cache.fetch("SELECT name FROM items WHERE id = ?;", 2);
+    EXPECT_EQ(cache.fetch("SELECT name FROM items WHERE id = ?;", 1), one);
+    cache.fetch("SELECT name FROM items WHERE id = ?;", 3);
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(cache.fetch("SELECT name FROM items WHERE id = ?;", 1), one);
+}
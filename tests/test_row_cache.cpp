@@ -0,0 +1,188 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/private/private_accessor.hpp>
+#include <sqlite/row_cache.hpp>
+#include <sqlite/transaction.hpp>
+
+#include <sqlite3.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+struct account {
+    std::string name;
+    std::int64_t balance = 0;
+};
+VSQLITE_FIELDS(account, "accounts", name, balance)
+
+void create_accounts(sqlite::connection &conn) {
+    sqlite::execute(conn, "CREATE TABLE accounts(name TEXT PRIMARY KEY, balance INTEGER);", true);
+    sqlite::execute(conn, "CREATE TABLE other(id INTEGER PRIMARY KEY);", true);
+    sqlite::execute(conn, "INSERT INTO accounts VALUES('alice', 10), ('bob', 20), ('carol', 30);",
+                    true);
+}
+} // namespace
+
+TEST(RowCacheTest, ReadsThroughAndHits) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    sqlite::row_cache<std::string, account> cache(conn);
+
+    auto alice = cache.get("alice");
+    ASSERT_TRUE(alice);
+    EXPECT_EQ(alice->balance, 10);
+    EXPECT_EQ(cache.get("alice")->balance, 10);
+    EXPECT_FALSE(cache.get("nobody"));
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.entries, 1u);
+}
+
+TEST(RowCacheTest, UpdateHookDropsOnlyChangedRows) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    sqlite::row_cache<std::string, account> cache(conn);
+    cache.get("alice");
+    cache.get("bob");
+
+    sqlite::execute(conn, "UPDATE accounts SET balance = 15 WHERE name = 'alice';", true);
+    sqlite::execute(conn, "INSERT INTO other DEFAULT VALUES;", true);
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.invalidations, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(cache.get("alice")->balance, 15);
+
+    sqlite::execute(conn, "DELETE FROM accounts WHERE name = 'bob';", true);
+    EXPECT_FALSE(cache.get("bob"));
+}
+
+TEST(RowCacheTest, CachesShareTheConnectionHooks) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    sqlite::row_cache<std::string, account> first(conn);
+    auto second = std::make_unique<sqlite::row_cache<std::string, account>>(conn);
+    first.get("alice");
+    second->get("alice");
+
+    sqlite::execute(conn, "UPDATE accounts SET balance = 11 WHERE name = 'alice';", true);
+    EXPECT_EQ(first.stats().invalidations, 1u);
+    EXPECT_EQ(second->stats().invalidations, 1u);
+
+    // Dropping one cache must leave the other one listening.
+    second.reset();
+    first.get("alice");
+    sqlite::execute(conn, "UPDATE accounts SET balance = 12 WHERE name = 'alice';", true);
+    EXPECT_EQ(first.get("alice")->balance, 12);
+    EXPECT_EQ(first.stats().invalidations, 2u);
+}
+
+TEST(RowCacheTest, CachesComeAndGoWhileAnotherThreadWrites) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    auto *db = sqlite::private_accessor::get_handle(conn);
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        while (!done.load()) {
+            sqlite3_exec(db, "UPDATE accounts SET balance = balance + 1 WHERE name = 'bob';",
+                         nullptr, nullptr, nullptr);
+        }
+    });
+    for (int i = 0; i < 2000; ++i) {
+        sqlite::row_cache<std::string, account> cache(conn);
+        EXPECT_EQ(cache.get("alice")->balance, 10);
+    }
+    done = true;
+    writer.join();
+}
+
+TEST(RowCacheTest, SeesDeletesTheUpdateHookMisses) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    sqlite::row_cache<std::string, account> cache(conn);
+    cache.get("alice");
+    cache.get("bob");
+
+    // DELETE without WHERE uses the truncate optimization and skips the update hook entirely.
+    sqlite::execute(conn, "DELETE FROM accounts;", true);
+    EXPECT_FALSE(cache.get("alice"));
+    EXPECT_FALSE(cache.get("bob"));
+    EXPECT_EQ(cache.stats().entries, 0u);
+
+    // Inside a transaction the truncation is caught at COMMIT.
+    sqlite::execute(conn, "INSERT INTO accounts VALUES('alice', 10), ('bob', 20);", true);
+    EXPECT_EQ(cache.get("alice")->balance, 10);
+    {
+        sqlite::transaction tx(conn);
+        sqlite::execute(conn, "DELETE FROM accounts;", true);
+        tx.commit();
+    }
+    EXPECT_FALSE(cache.get("alice"));
+
+    // REPLACE deletes the conflicting row without an update hook call for it.
+    sqlite::execute(conn, "INSERT INTO accounts VALUES('alice', 10), ('bob', 20);", true);
+    cache.get("alice");
+    cache.get("bob");
+    sqlite::execute(conn, "INSERT OR REPLACE INTO accounts VALUES('alice', 99);", true);
+    EXPECT_EQ(cache.get("alice")->balance, 99);
+}
+
+TEST(RowCacheTest, RefusesToReplaceForeignHooks) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    int marker = 0;
+    auto *db   = sqlite::private_accessor::get_handle(conn);
+    sqlite3_commit_hook(db, [](void *) { return 0; }, &marker);
+    using cache_type = sqlite::row_cache<std::string, account>;
+    EXPECT_THROW(cache_type cache(conn), sqlite::database_exception);
+}
+
+TEST(RowCacheTest, SkipsRowsWithUncommittedChanges) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    sqlite::row_cache<std::string, account> cache(conn);
+    {
+        sqlite::transaction tx(conn);
+        sqlite::execute(conn, "UPDATE accounts SET balance = 99 WHERE name = 'carol';", true);
+        EXPECT_EQ(cache.get("carol")->balance, 99);
+        EXPECT_EQ(cache.stats().entries, 0u);
+        tx.rollback();
+    }
+    EXPECT_EQ(cache.get("carol")->balance, 30);
+    EXPECT_EQ(cache.stats().entries, 1u);
+}
+
+TEST(RowCacheTest, EvictsAndServesConcurrentReaders) {
+    sqlite::connection conn(":memory:");
+    create_accounts(conn);
+    sqlite::row_cache<std::string, account> cache(conn, {.capacity = 2, .shards = 1});
+    cache.get("alice");
+    cache.get("bob");
+    cache.get("carol");
+    EXPECT_EQ(cache.stats().entries, 2u);
+    EXPECT_EQ(cache.stats().evictions, 1u);
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&cache] {
+            for (int i = 0; i < 200; ++i) {
+                EXPECT_EQ(cache.get(i % 2 ? "bob" : "carol")->balance, i % 2 ? 20 : 30);
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    cache.invalidate("bob");
+    cache.clear();
+    EXPECT_EQ(cache.stats().entries, 0u);
+}
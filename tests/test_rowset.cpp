@@ -0,0 +1,77 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/rowset.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace testhelpers;
+
+TEST(RowsetTest, CopiesResultIntoArena) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE items(id INTEGER, name TEXT, price REAL, tag BLOB);",
+                    true);
+    sqlite::execute(conn,
+                    "INSERT INTO items VALUES(1, 'apple', 0.5, x'0102'), (2, NULL, 1.25, NULL), "
+                    "(3, 'cherry', 2.0, x'');",
+                    true);
+
+    sqlite::rowset rows;
+    {
+        sqlite::query q(conn, "SELECT id, name, price, tag FROM items ORDER BY id;");
+        rows = sqlite::rowset(q);
+    }
+    ASSERT_EQ(rows.size(), 3u);
+    ASSERT_EQ(rows.column_count(), 4u);
+    EXPECT_EQ(rows.column_names()[1], "name");
+
+    EXPECT_EQ(rows.at(0, 0).kind(), sqlite::integer);
+    EXPECT_EQ(rows.at(0, 1).as_text(), "apple");
+    EXPECT_DOUBLE_EQ(rows.at(1, 2).as_double(), 1.25);
+    EXPECT_TRUE(rows.at(1, 1).is_null());
+    EXPECT_EQ(rows.at(0, 3).kind(), sqlite::blob);
+    EXPECT_EQ(rows.at(0, 3).as_blob().size(), 2u);
+    EXPECT_EQ(rows.at(0, 3).as_blob()[1], 0x02);
+    EXPECT_EQ(rows[2]["name"].get<std::string>(), "cherry");
+    EXPECT_FALSE(rows[1].get<std::optional<std::string>>(1).has_value());
+    EXPECT_THROW(rows[0]["missing"], sqlite::database_exception);
+
+    std::int64_t sum = 0;
+    for (auto row : rows) {
+        sum += row.get<std::int64_t>(0);
+    }
+    EXPECT_EQ(sum, 6);
+}
+
+TEST(RowsetTest, ConvertsToVariant) {
+    sqlite::connection conn(":memory:");
+    sqlite::query q(conn, "SELECT 42, 'txt', NULL, 5000000000;");
+    sqlite::rowset rows(q);
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(std::get<int>(rows.at(0, 0).to_variant()), 42);
+    EXPECT_EQ(std::get<std::string>(rows.at(0, 1).to_variant()), "txt");
+    EXPECT_TRUE(std::holds_alternative<sqlite::null_t>(rows.at(0, 2).to_variant()));
+    EXPECT_EQ(std::get<std::int64_t>(rows.at(0, 3).to_variant()), 5000000000LL);
+}
+
+TEST(RowsetTest, UsesOneArenaForVariableData) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE words(w TEXT);", true);
+    sqlite::execute insert(conn, "INSERT INTO words VALUES(?);");
+    for (int i = 0; i < 100; ++i) {
+        insert % ("word" + std::to_string(i));
+        insert();
+        insert.clear();
+    }
+    sqlite::query q(conn, "SELECT w FROM words;");
+    sqlite::rowset rows(q);
+    ASSERT_EQ(rows.size(), 100u);
+    auto first = rows.at(0, 0).as_text();
+    auto last  = rows.at(99, 0).as_text();
+    EXPECT_EQ(last, "word99");
+    EXPECT_LT(first.data(), last.data());
+    EXPECT_LE(rows.memory_usage(), 100u * 16u + 100u * 6u);
+}
@@ -0,0 +1,101 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/connection_pool.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/snapshot.hpp>
+#include <sqlite/snapshot_group.hpp>
+
+#include <chrono>
+#include <string>
+
+using namespace testhelpers;
+
+namespace {
+std::int64_t count_items(sqlite::connection &conn) {
+    sqlite::query q(conn, "SELECT COUNT(*) FROM items;");
+    std::int64_t count = 0;
+    for (auto value : q.rows<std::int64_t>()) {
+        count = value;
+    }
+    return count;
+}
+} // namespace
+
+TEST(SnapshotGroupTest, RejectsInvalidReaderCounts) {
+    TempFile db("snapshot_group_args");
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    EXPECT_THROW(sqlite::snapshot_group(pool, 0), sqlite::database_exception);
+    EXPECT_THROW(sqlite::snapshot_group(pool, 3), sqlite::database_exception);
+    EXPECT_EQ(pool.leased_count(), 0u);
+}
+
+TEST(SnapshotGroupTest, ReleasesLeasesWhenSnapshotsUnavailable) {
+    if (sqlite::snapshots_supported()) {
+        GTEST_SKIP() << "SQLite snapshot APIs are available in this build.";
+    }
+    TempFile db("snapshot_group_unsupported");
+    {
+        sqlite::connection writer(db.string());
+        sqlite::enable_wal(writer);
+        sqlite::execute(writer, "CREATE TABLE items(id INTEGER PRIMARY KEY);", true);
+    }
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    try {
+        sqlite::snapshot_group group(pool, 2);
+        FAIL() << "snapshot_group needs the snapshot APIs";
+    } catch (sqlite::database_exception const &e) {
+        EXPECT_NE(std::string(e.what()).find("snapshot APIs are not available"),
+                  std::string::npos);
+    }
+    EXPECT_EQ(pool.leased_count(), 0u);
+}
+
+TEST(SnapshotGroupTest, RequiresWalAndReleasesLeases) {
+    TempFile db("snapshot_group_rollback_journal");
+    {
+        sqlite::connection writer(db.string());
+        sqlite::execute(writer, "CREATE TABLE items(id INTEGER PRIMARY KEY);", true);
+    }
+    sqlite::connection_pool pool(2, sqlite::connection_pool::make_factory(db.string()));
+    // Without snapshot support this fails earlier, on the same documented exception type.
+    EXPECT_THROW(sqlite::snapshot_group(pool, 2), sqlite::database_exception);
+    EXPECT_EQ(pool.leased_count(), 0u);
+    EXPECT_EQ(pool.idle_count(), 2u);
+}
+
+TEST(SnapshotGroupTest, ReadersShareOneSnapshotAndReportLag) {
+    if (!sqlite::snapshots_supported()) {
+        GTEST_SKIP() << "SQLite snapshot APIs not available in this build.";
+    }
+    TempFile db("snapshot_group");
+    sqlite::connection writer(db.string());
+    sqlite::enable_wal(writer);
+    sqlite::execute(writer, "CREATE TABLE items(id INTEGER PRIMARY KEY);", true);
+    sqlite::execute(writer, "INSERT INTO items DEFAULT VALUES;", true);
+
+    sqlite::connection_pool pool(3, sqlite::connection_pool::make_factory(db.string()));
+    {
+        auto opened = std::chrono::steady_clock::now();
+        sqlite::snapshot_group group(pool, 3);
+        ASSERT_EQ(group.size(), 3u);
+        EXPECT_TRUE(group.pinned().valid());
+        EXPECT_FALSE(group.lag().behind);
+
+        sqlite::execute(writer, "INSERT INTO items DEFAULT VALUES;", true);
+        sqlite::execute(writer, "INSERT INTO items DEFAULT VALUES;", true);
+
+        for (std::size_t i = 0; i < group.size(); ++i) {
+            EXPECT_EQ(count_items(group[i]), 1);
+        }
+        auto lag = group.lag();
+        EXPECT_TRUE(lag.behind);
+        EXPECT_GT(lag.age.count(), 0);
+        EXPECT_LE(lag.age, std::chrono::steady_clock::now() - opened);
+        EXPECT_THROW(group.reader(3), std::out_of_range);
+        EXPECT_EQ(pool.leased_count(), 3u);
+    }
+    EXPECT_EQ(pool.leased_count(), 0u);
+    EXPECT_EQ(count_items(writer), 3);
+}
@@ -0,0 +1,48 @@
+#include "test_common.hpp"
+
+#include <sqlite/command.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/stats.hpp>
+
+using namespace testhelpers;
+
+TEST(StatsTest, ConnectionReportsCacheAndSchemaMemory) {
+    TempFile db("stats_connection");
+    sqlite::connection conn(db.string());
+    sqlite::execute(conn, "CREATE TABLE items(id INTEGER PRIMARY KEY, body TEXT);", true);
+    sqlite::command insert(conn, "INSERT INTO items(body) VALUES (?);");
+    for (int i = 0; i < 50; ++i) {
+        insert % std::string(200, 'x');
+        insert.step_once();
+        insert.clear();
+    }
+    EXPECT_EQ(count_rows(conn, "items"), 50);
+
+    auto stats = conn.stats();
+    EXPECT_GT(stats.cache_used, 0);
+    EXPECT_GT(stats.schema_used, 0);
+    EXPECT_GT(stats.cache_hit + stats.cache_miss, 0);
+    EXPECT_EQ(stats.deferred_fks, 0);
+}
+
+TEST(StatsTest, GlobalStatsTrackAllocations) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE t(x);", true);
+    auto stats = sqlite::global_stats();
+    EXPECT_GT(stats.memory_used.current, 0);
+    EXPECT_GE(stats.memory_used.highwater, stats.memory_used.current);
+    EXPECT_GT(stats.malloc_count.current, 0);
+}
+
+TEST(StatsTest, TotalsAddCountersAndKeepThePeak) {
+    sqlite::connection_stats total;
+    total.lookaside_used_highwater = 40;
+    total.cache_hit                = 3;
+    sqlite::connection_stats other;
+    other.lookaside_used_highwater = 25;
+    other.cache_hit                = 4;
+    total += other;
+    EXPECT_EQ(total.lookaside_used_highwater, 40);
+    EXPECT_EQ(total.cache_hit, 7);
+}
@@ -0,0 +1,104 @@
+#include "test_common.hpp"
+
+#include <sqlite/command.hpp>
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/struct_mapping.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace mapping_test {
+struct account {
+    std::int64_t id = 0;
+    std::string owner;
+    std::optional<double> balance;
+};
+VSQLITE_FIELDS(account, "accounts", id, owner, balance)
+
+struct point {
+    int x;
+    int y;
+    std::string label;
+};
+} // namespace mapping_test
+
+using mapping_test::account;
+using mapping_test::point;
+
+static_assert(sqlite::described_struct<account>);
+static_assert(!sqlite::described_struct<point>);
+static_assert(sqlite::field_count<account>() == 3);
+static_assert(sqlite::field_count<point>() == 3);
+static_assert(std::string_view(sqlite::struct_sql<account>::insert) ==
+              "INSERT INTO accounts(id, owner, balance) VALUES(?1, ?2, ?3)");
+static_assert(std::string_view(sqlite::struct_sql<account>::update) ==
+              "UPDATE accounts SET owner = ?2, balance = ?3 WHERE id = ?1");
+static_assert(std::string_view(sqlite::struct_sql<account>::select) ==
+              "SELECT id, owner, balance FROM accounts");
+static_assert(std::string_view(sqlite::struct_sql<account>::select_by_key) ==
+              "SELECT id, owner, balance FROM accounts WHERE id = ?1");
+static_assert(std::string_view(sqlite::struct_sql<account>::remove) ==
+              "DELETE FROM accounts WHERE id = ?1");
+
+TEST(StructMappingTest, RoundTripsDescribedStruct) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE accounts(id INTEGER PRIMARY KEY, owner TEXT, balance REAL);",
+                    true);
+
+    sqlite::command insert(conn, sqlite::struct_sql<account>::insert);
+    insert.bind_struct(account{1, "ada", 10.5}).step_once();
+    insert.clear();
+    insert.bind_struct(account{2, "bob", std::nullopt}).step_once();
+
+    sqlite::command update(conn, sqlite::struct_sql<account>::update);
+    update.bind_struct(account{1, "ada", 12.0}).step_once();
+
+    sqlite::query q(conn, std::string(sqlite::struct_sql<account>::select) + " ORDER BY id");
+    std::vector<account> accounts;
+    for (auto acc : q.as<account>()) {
+        accounts.push_back(std::move(acc));
+    }
+    ASSERT_EQ(accounts.size(), 2u);
+    EXPECT_EQ(accounts[0].owner, "ada");
+    EXPECT_EQ(accounts[0].balance, 12.0);
+    EXPECT_EQ(accounts[1].id, 2);
+    EXPECT_FALSE(accounts[1].balance.has_value());
+
+    sqlite::query by_key(conn, sqlite::struct_sql<account>::select_by_key);
+    int found = 0;
+    for (auto acc : by_key.as<account>(std::int64_t{2})) {
+        EXPECT_EQ(acc.owner, "bob");
+        ++found;
+    }
+    EXPECT_EQ(found, 1);
+}
+
+TEST(StructMappingTest, MapsPlainAggregatesPositionally) {
+    sqlite::connection conn(":memory:");
+    sqlite::execute(conn, "CREATE TABLE points(x INTEGER, y INTEGER, label TEXT);", true);
+    sqlite::command insert(conn, "INSERT INTO points VALUES(?, ?, ?);");
+    insert.bind_struct(point{1, 2, "a"}).step_once();
+    insert.clear();
+    insert.bind_struct(point{3, 4, "b"}).step_once();
+
+    sqlite::query q(conn, "SELECT x, y, label FROM points ORDER BY x;");
+    std::vector<point> points;
+    for (auto p : q.as<point>()) {
+        points.push_back(p);
+    }
+    ASSERT_EQ(points.size(), 2u);
+    EXPECT_EQ(points[1].y, 4);
+    EXPECT_EQ(points[1].label, "b");
+}
+
+TEST(StructMappingTest, RejectsNarrowResults) {
+    sqlite::connection conn(":memory:");
+    sqlite::query q(conn, "SELECT 1, 2;");
+    EXPECT_THROW(q.as<point>(), sqlite::database_exception);
+}
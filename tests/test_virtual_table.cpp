@@ -0,0 +1,206 @@
+#include "test_common.hpp"
+
+#include <sqlite/connection.hpp>
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <sqlite/virtual_table.hpp>
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace testhelpers;
+
+namespace {
+struct series_state {
+    std::int64_t limit = 0;
+    std::vector<std::string> *filters = nullptr;
+};
+
+// Integers 1..limit; equality and range constraints on the value are answered exactly.
+class series_cursor {
+public:
+    using context_type = series_state;
+
+    explicit series_cursor(context_type &state) : state_(state) {}
+
+    static std::string schema(context_type const &) {
+        return "CREATE TABLE x(value INTEGER, square INTEGER)";
+    }
+
+    static sqlite::constraint_use accepts(context_type const &, sqlite::index_constraint c) {
+        return c.column == 0 ? sqlite::constraint_use::exact : sqlite::constraint_use::ignore;
+    }
+
+    void filter(std::span<sqlite::constraint const> constraints) {
+        if (state_.limit < 0) {
+            throw std::runtime_error("series is broken");
+        }
+        value_ = 1;
+        last_  = state_.limit;
+        std::string seen;
+        for (auto const &c : constraints) {
+            auto bound = c.as<std::int64_t>();
+            switch (c.op) {
+            case sqlite::constraint_op::eq:
+                value_ = std::max(value_, bound);
+                last_  = std::min(last_, bound);
+                break;
+            case sqlite::constraint_op::gt:
+                value_ = std::max(value_, bound + 1);
+                break;
+            case sqlite::constraint_op::ge:
+                value_ = std::max(value_, bound);
+                break;
+            case sqlite::constraint_op::lt:
+                last_ = std::min(last_, bound - 1);
+                break;
+            case sqlite::constraint_op::le:
+                last_ = std::min(last_, bound);
+                break;
+            }
+            seen += std::to_string(static_cast<int>(c.op));
+        }
+        if (state_.filters) {
+            state_.filters->push_back(seen);
+        }
+    }
+
+    void next() { ++value_; }
+    bool eof() const { return value_ > last_; }
+    std::int64_t rowid() const { return value_; }
+
+    void column(sqlite::column_result &out, int index) const {
+        out.set(index == 0 ? value_ : value_ * value_);
+    }
+
+private:
+    context_type &state_;
+    std::int64_t value_ = 0;
+    std::int64_t last_  = 0;
+};
+
+// One row; throws from whichever callback `fail_in` names.
+class failing_cursor {
+public:
+    using context_type = std::string;
+
+    explicit failing_cursor(context_type &fail_in) : fail_in_(fail_in) {}
+
+    static std::string schema(context_type const &) {
+        return "CREATE TABLE x(value INTEGER)";
+    }
+
+    static sqlite::constraint_use accepts(context_type const &fail_in, sqlite::index_constraint) {
+        if (fail_in == "accepts") {
+            throw std::runtime_error("accepts failed");
+        }
+        return sqlite::constraint_use::ignore;
+    }
+
+    void filter(std::span<sqlite::constraint const>) { done_ = false; }
+    void next() { done_ = true; }
+
+    bool eof() const {
+        if (fail_in_ == "eof") {
+            throw std::runtime_error("eof failed");
+        }
+        return done_;
+    }
+
+    std::int64_t rowid() const {
+        if (fail_in_ == "rowid") {
+            throw std::runtime_error("rowid failed");
+        }
+        return 1;
+    }
+
+    void column(sqlite::column_result &out, int) const { out.set(std::int64_t{1}); }
+
+private:
+    context_type &fail_in_;
+    bool done_ = true;
+};
+
+struct product {
+    std::int64_t sku;
+    std::string name;
+    std::optional<double> price;
+};
+VSQLITE_FIELDS(product, "products", sku, name, price)
+} // namespace
+
+TEST(VirtualTableTest, CursorReceivesNegotiatedConstraints) {
+    sqlite::connection conn(":memory:");
+    std::vector<std::string> filters;
+    sqlite::create_module<series_cursor>(conn, "series", series_state{100, &filters});
+
+    EXPECT_EQ(count_rows(conn, "series"), 100);
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(square, ',') FROM series "
+                            "WHERE value >= 5 AND value < 8;"),
+              "25,36,49");
+    EXPECT_EQ(text_of(conn, "SELECT square FROM series WHERE value = 12;"), "144");
+    // Unsupported operators are left to SQLite.
+    EXPECT_EQ(count_rows(conn, "series WHERE value <> 3 AND square > 9000"), 6);
+
+    ASSERT_GE(filters.size(), 4u);
+    EXPECT_EQ(filters[0], "");
+    EXPECT_EQ(filters[1].size(), 2u);
+    EXPECT_EQ(filters[2], "0");
+}
+
+TEST(VirtualTableTest, VectorTableJoinsAndSeeksWithoutCopying) {
+    std::vector<product> rows{
+        {10, "bolt", 0.25}, {20, "nut", 0.1}, {20, "washer", std::nullopt}, {40, "gear", 12.5}};
+    sqlite::connection conn(":memory:");
+    sqlite::create_vector_table(conn, "catalog", rows, true);
+    sqlite::execute(conn, "CREATE TABLE orders(sku INTEGER, qty INTEGER);", true);
+    sqlite::execute(conn, "INSERT INTO orders VALUES(20, 3), (40, 1), (99, 7);", true);
+
+    EXPECT_EQ(count_rows(conn, "catalog"), 4);
+    EXPECT_EQ(text_of(conn, "SELECT group_concat(c.name || 'x' || o.qty, ',') FROM orders o "
+                            "JOIN catalog c ON c.sku = o.sku;"),
+              "nutx3,washerx3,gearx1");
+    EXPECT_EQ(text_of(conn, "SELECT name FROM catalog WHERE rowid = 3;"), "washer");
+    EXPECT_EQ(count_rows(conn, "catalog WHERE sku > 10 AND sku <= 20"), 2);
+    EXPECT_EQ(count_rows(conn, "catalog WHERE sku >= 15.5"), 3);
+    EXPECT_EQ(count_rows(conn, "catalog WHERE sku = NULL"), 0);
+    EXPECT_EQ(count_rows(conn, "catalog WHERE price IS NULL"), 1);
+    EXPECT_EQ(count_rows(conn, "catalog WHERE sku = '20'"), 2);
+
+    sqlite::query plan(conn, "EXPLAIN QUERY PLAN SELECT * FROM catalog WHERE sku = ?;");
+    plan % std::int64_t(20);
+    auto plan_res = plan.get_result();
+    ASSERT_TRUE(plan_res->next_row());
+    EXPECT_NE(plan_res->get<std::string>(3).find("VIRTUAL TABLE INDEX 0:0:0;"), std::string::npos);
+}
+
+TEST(VirtualTableTest, CursorErrorsSurfaceAsExceptions) {
+    sqlite::connection conn(":memory:");
+    sqlite::create_module<series_cursor>(conn, "broken", series_state{-1, nullptr});
+    sqlite::query q(conn, "SELECT value FROM broken;");
+    EXPECT_THROW(
+        {
+            auto res = q.get_result();
+            res->next_row();
+        },
+        sqlite::database_exception);
+}
+
+TEST(VirtualTableTest, ExceptionsFromEveryCallbackBecomeErrors) {
+    for (std::string fail_in : {"accepts", "eof", "rowid"}) {
+        sqlite::connection conn(":memory:");
+        sqlite::create_module<failing_cursor>(conn, "failing", fail_in);
+        try {
+            sqlite::query q(conn, "SELECT rowid FROM failing WHERE value = 1;");
+            auto res = q.get_result();
+            res->next_row();
+            ADD_FAILURE() << "no error from " << fail_in;
+        } catch (sqlite::database_exception const &ex) {
+            EXPECT_NE(std::string(ex.what()).find(fail_in + " failed"), std::string::npos)
+                << ex.what();
+        }
+    }
+}